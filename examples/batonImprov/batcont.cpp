@@ -2,6 +2,8 @@
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Last Modified: Sat Jan 16 10:03:46 PST 1999
 // Last Modified: Sat Jan 16 11:03:46 PST 1999
+// Last Modified: Sat Oct 17 16:58:07 PDT 2026 (running status output)
+// Last Modified: Sat Oct 17 18:49:55 PDT 2026 (redundant send suppression)
 // Filename:      ...improv/doc/examples/batonImprov/batcont/batcont.cpp
 // Syntax:        C++; batonImprov
 //  
@@ -55,7 +57,14 @@ void description(void) {
    << endl;
 }
 
-void initialization(void) { }
+void initialization(void) { 
+   // all of the controllers are on one channel, so leave out the
+   // repeated command bytes
+   synth.setRunningStatus(1);
+   // the baton positions are sent at the position report rate, but
+   // only the ones which have changed need to go to the synthesizer
+   synth.setStateCache(1);
+}
 
 void finishup(void) { }
 
@@ -0,0 +1,223 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 12:10:26 PDT 2026
+// Last Modified: Sun Oct 18 12:10:26 PDT 2026
+// Filename:      ...sig/doc/examples/improv/improv/coalescebench.cpp
+// Syntax:        C++; improv
+//
+// Description:   Compares MIDI output with and without write coalescing
+//                (MidiOutPort::setCoalescing()).  Two kinds of output
+//                are timed on an output port: a burst of note-ons
+//                forming a chord followed by flush(), as an EventBuffer
+//                or the improv main loop would send it, and silence()
+//                with the given number of notes sounding on each of the
+//                16 channels.  For each the wall time and the number of
+//                write system calls are printed (the write count comes
+//                from /proc/self/io, so other threads writing at the
+//                same time are counted too).  Any output port will do,
+//                such as an ALSA virtual MIDI port, although the time
+//                depends on what is at the other end.
+//
+
+#include "sigControl.h"
+#include <stdlib.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <iostream>
+using namespace std;
+
+int     atohd(const char* aNumber);
+void    exitUsage(const char* command);
+int64_t getWriteCalls(void);
+void    printResult(const char* name, int coalesce, int64_t elapsed,
+              int64_t writes, int count);
+void    testChords(MidiOutput& midiout, int coalesce, int chords,
+              int notes);
+void    testSilence(MidiOutput& midiout, int coalesce, int repeat,
+              int notes);
+
+
+int main(int argc, char* argv[]) {
+   int port   = 0;
+   int chords = 100;
+   int notes  = 16;
+   if (argc < 2 || argc > 4) {
+      exitUsage(argv[0]);
+   }
+   port = atohd(argv[1]);
+   if (argc > 2) chords = atohd(argv[2]);
+   if (argc > 3) notes  = atohd(argv[3]);
+   if (chords < 1 || notes < 1 || notes > 128) {
+      exitUsage(argv[0]);
+   }
+
+   MidiOutput midiout;
+   if (midiout.getNumPorts() <= port) {
+      cout << "Error: highest available output port is: "
+           << midiout.getNumPorts()-1 << endl;
+      exit(1);
+   }
+   midiout.setPort(port);
+   midiout.open();
+   if (getWriteCalls() < 0) {
+      cout << "Note: /proc/self/io is not readable, so write calls "
+           << "are not counted" << endl;
+   }
+
+   cout << "output\t\tcoalesced\tus each\twrites each" << endl;
+   for (int coalesce=0; coalesce<2; coalesce++) {
+      testChords(midiout, coalesce, chords, notes);
+      testSilence(midiout, coalesce, chords / 10 + 1, notes);
+   }
+   midiout.setCoalescing(0);
+   return 0;
+}
+
+
+
+int atohd(const char* aNumber) {
+   if (aNumber[0] == '0' && tolower(aNumber[1]) == 'x') {
+      return (int)strtol(aNumber, (char**)NULL, 16);
+   } else {
+      return atoi(aNumber);
+   }
+}
+
+
+
+void exitUsage(const char* command) {
+   cout << endl;
+   cout << "Compares the time and write calls of MIDI output with and\n";
+   cout << "without write coalescing.\n";
+   cout << endl;
+   cout << "Usage: " << command << " port [chords [notes]]\n";
+   cout << endl;
+   cout << "   port   = MIDI output port to use.\n";
+   cout << "   chords = number of chords to play, default is 100.\n";
+   cout << "   notes  = notes in each chord and on each channel for\n";
+   cout << "            silence(), 1 to 128, default is 16.\n";
+   cout << endl;
+   exit(1);
+}
+
+
+
+//////////////////////////////
+//
+// getWriteCalls -- returns the number of write system calls made by the
+//     program so far, or -1 if it is not known.
+//
+
+int64_t getWriteCalls(void) {
+   FILE* file = fopen("/proc/self/io", "r");
+   if (file == NULL) {
+      return -1;
+   }
+   char line[128];
+   long long value = -1;
+   while (fgets(line, sizeof(line), file) != NULL) {
+      if (strncmp(line, "syscw:", 6) == 0) {
+         value = atoll(line + 6);
+         break;
+      }
+   }
+   fclose(file);
+   return value;
+}
+
+
+
+//////////////////////////////
+//
+// printResult -- print the average time and write calls of count
+//     repetitions.
+//
+
+void printResult(const char* name, int coalesce, int64_t elapsed,
+      int64_t writes, int count) {
+   cout << name << (strlen(name) < 8 ? "\t\t" : "\t")
+        << (coalesce ? "yes" : "no") << "\t\t"
+        << elapsed / 1000.0 / count << "\t";
+   if (writes < 0) {
+      cout << "-";
+   } else {
+      cout << (double)writes / count;
+   }
+   cout << endl;
+}
+
+
+
+//////////////////////////////
+//
+// testChords -- play chords of notes on channel 1, and time the
+//     note-ons of each chord up to the end of the flush().  The
+//     note-offs are not timed.
+//
+
+void testChords(MidiOutput& midiout, int coalesce, int chords,
+      int notes) {
+   midiout.setCoalescing(coalesce);
+   int64_t elapsed = 0;
+   int64_t writes = 0;
+   int64_t start, before, after;
+   int i, j;
+   for (i=0; i<chords; i++) {
+      before = getWriteCalls();
+      start = SigTimer::getMonotonicTime();
+      for (j=0; j<notes; j++) {
+         midiout.play(0, j, 64);
+      }
+      midiout.flush();
+      elapsed += SigTimer::getMonotonicTime() - start;
+      after = getWriteCalls();
+      if (before < 0 || after < 0) {
+         writes = -1;
+      } else if (writes >= 0) {
+         writes += after - before;
+      }
+      for (j=0; j<notes; j++) {
+         midiout.play(0, j, 0);
+      }
+      midiout.flush();
+   }
+   printResult("chord", coalesce, elapsed, writes, chords);
+}
+
+
+
+//////////////////////////////
+//
+// testSilence -- sound the given number of notes on each channel, and
+//     time silence().
+//
+
+void testSilence(MidiOutput& midiout, int coalesce, int repeat,
+      int notes) {
+   midiout.setCoalescing(coalesce);
+   int64_t elapsed = 0;
+   int64_t writes = 0;
+   int64_t start, before, after;
+   int i, j, channel;
+   for (i=0; i<repeat; i++) {
+      for (channel=0; channel<16; channel++) {
+         for (j=0; j<notes; j++) {
+            midiout.play(channel, j, 64);
+         }
+      }
+      midiout.flush();
+      before = getWriteCalls();
+      start = SigTimer::getMonotonicTime();
+      midiout.silence();
+      elapsed += SigTimer::getMonotonicTime() - start;
+      after = getWriteCalls();
+      if (before < 0 || after < 0) {
+         writes = -1;
+      } else if (writes >= 0) {
+         writes += after - before;
+      }
+   }
+   printResult("silence()", coalesce, elapsed, writes, repeat);
+}
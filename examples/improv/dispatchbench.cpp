@@ -0,0 +1,178 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 23:58:12 PDT 2026
+// Last Modified: Sat Oct 17 23:58:12 PDT 2026
+// Filename:      ...sig/doc/examples/improv/improv/dispatchbench.cpp
+// Syntax:        C++; improv
+//
+// Description:   Measures the time taken to make one million events act,
+//                in four ways:
+//                   virtual:  a virtual call of action() on events which
+//                             were copied with their vtable pointer, as
+//                             the EventBuffer used to store them.
+//                   switch:   Event::action(), which finds the class of
+//                             the event with switch statements.
+//                   table:    EventBuffer::dispatchAction(), which looks
+//                             up the type byte of the event in a table.
+//                   xcheck:   the whole EventBuffer, with all of the
+//                             events due at the same time.
+//                The events are FunctionEvents with a few different
+//                functions, mixed with NoteEvents which have already
+//                been turned off (so that they send no MIDI), in a
+//                random order.  No MIDI port is needed.
+//
+
+#include "sigControl.h"
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <iostream>
+using namespace std;
+
+#define EVENT_COUNT  (1000000)
+
+int   atohd(const char* aNumber);
+void  count1(FunctionEvent& p, EventBuffer& midiOutput);
+void  count2(FunctionEvent& p, EventBuffer& midiOutput);
+void  count3(FunctionEvent& p, EventBuffer& midiOutput);
+void  makeEvent(Event& event);
+void  printTime(const char* name, int64_t elapsed, int count);
+
+int actionCount = 0;
+
+
+int main(int argc, char* argv[]) {
+   int count = EVENT_COUNT;
+   if (argc > 1) {
+      count = atohd(argv[1]);
+   }
+   if (count < 1) {
+      cout << "Usage: " << argv[0] << " [events]" << endl;
+      exit(1);
+   }
+
+   EventBuffer eventBuffer(count);
+
+   // raw storage, so that the compiler cannot know the class of the
+   // events and has to make the virtual calls
+   char* storage = new char[count * sizeof(Event)];
+   Event* events = (Event*)storage;
+   srand(1);
+   int i;
+   for (i=0; i<count; i++) {
+      makeEvent(events[i]);
+   }
+
+   cout << "dispatch\tms per 1M events (ns per event)" << endl;
+   int64_t start;
+
+   actionCount = 0;
+   start = SigTimer::getMonotonicTime();
+   for (i=0; i<count; i++) {
+      events[i].action(eventBuffer);
+   }
+   printTime("virtual", SigTimer::getMonotonicTime() - start, count);
+
+   actionCount = 0;
+   start = SigTimer::getMonotonicTime();
+   for (i=0; i<count; i++) {
+      events[i].Event::action(eventBuffer);
+   }
+   printTime("switch", SigTimer::getMonotonicTime() - start, count);
+
+   actionCount = 0;
+   start = SigTimer::getMonotonicTime();
+   for (i=0; i<count; i++) {
+      eventBuffer.dispatchAction(events[i]);
+   }
+   printTime("table", SigTimer::getMonotonicTime() - start, count);
+
+   for (i=0; i<count; i++) {
+      eventBuffer.insert(events[i]);
+   }
+   actionCount = 0;
+   start = SigTimer::getMonotonicTime();
+   eventBuffer.xcheck(0L);
+   printTime("xcheck", SigTimer::getMonotonicTime() - start, count);
+
+   delete [] storage;
+   return 0;
+}
+
+
+
+int atohd(const char* aNumber) {
+   if (aNumber[0] == '0' && tolower(aNumber[1]) == 'x') {
+      return (int)strtol(aNumber, (char**)NULL, 16);
+   } else {
+      return atoi(aNumber);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// count1, count2, count3 -- the functions of the FunctionEvents.
+//
+
+void count1(FunctionEvent& p, EventBuffer& midiOutput) {
+   actionCount++;
+}
+
+
+void count2(FunctionEvent& p, EventBuffer& midiOutput) {
+   actionCount += 2;
+}
+
+
+void count3(FunctionEvent& p, EventBuffer& midiOutput) {
+   actionCount += 3;
+}
+
+
+
+//////////////////////////////
+//
+// makeEvent -- copy a random kind of event (vtable pointer included)
+//    into the given place, as EventBuffer::insert() used to do.
+//
+
+void makeEvent(Event& event) {
+   FunctionEvent function;
+   NoteEvent note;
+   switch (rand() % 4) {
+      case 0:
+         note.setOnDur(0, 100);
+         note.setStatus(EVENT_STATUS_OFF);
+         memcpy((void*)&event, (void*)&note, sizeof(Event));
+         return;
+      case 1:
+         function.setFunction(count1);
+         break;
+      case 2:
+         function.setFunction(count2);
+         break;
+      default:
+         function.setFunction(count3);
+   }
+   function.setOnTime(0);
+   function.activate();
+   memcpy((void*)&event, (void*)&function, sizeof(Event));
+}
+
+
+
+//////////////////////////////
+//
+// printTime -- print the time per event in nanoseconds, which is
+//    also the time per million events in milliseconds.
+//
+
+void printTime(const char* name, int64_t elapsed, int count) {
+   cout << name << "\t\t" << (double)elapsed / count << endl;
+}
+
+
+
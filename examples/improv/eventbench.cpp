@@ -0,0 +1,132 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 22:47:05 PDT 2026
+// Last Modified: Sat Oct 17 22:47:05 PDT 2026
+// Filename:      ...sig/doc/examples/improv/improv/eventbench.cpp
+// Syntax:        C++; improv
+//
+// Description:   Measures the time taken by EventBuffer::xcheck() with
+//                10, 1000 and 100000 events waiting in the buffer.  The
+//                waiting events are FunctionEvents scheduled a minute
+//                or more in the future (like the notes of ghost.cpp),
+//                and a few more FunctionEvents act on every tick and
+//                reschedule themselves for the next tick (like the
+//                echoes of eco.cpp).  No MIDI is sent, so no MIDI port
+//                is needed.
+//
+
+#include "sigControl.h"
+#include <stdlib.h>
+#include <ctype.h>
+
+#include <iostream>
+using namespace std;
+
+#define TICKS_PER_TEST  (2000)
+#define ACTIVE_EVENTS   (16)
+
+int  atohd(const char* aNumber);
+void reschedule(FunctionEvent& p, EventBuffer& midiOutput);
+void testBuffer(int waiting, int ticks);
+void wait(FunctionEvent& p, EventBuffer& midiOutput);
+
+int actionCount = 0;
+
+
+int main(int argc, char* argv[]) {
+   int ticks = TICKS_PER_TEST;
+   if (argc > 1) {
+      ticks = atohd(argv[1]);
+   }
+   if (ticks < 1) {
+      cout << "Usage: " << argv[0] << " [ticks]" << endl;
+      exit(1);
+   }
+
+   cout << "waiting events\tns per xcheck\tmaximum ns\tactions" << endl;
+   testBuffer(10, ticks);
+   testBuffer(1000, ticks);
+   testBuffer(100000, ticks);
+   return 0;
+}
+
+
+
+int atohd(const char* aNumber) {
+   if (aNumber[0] == '0' && tolower(aNumber[1]) == 'x') {
+      return (int)strtol(aNumber, (char**)NULL, 16);
+   } else {
+      return atoi(aNumber);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// reschedule -- an event which acts on every tick.
+//
+
+void reschedule(FunctionEvent& p, EventBuffer& midiOutput) {
+   actionCount++;
+   p.setOnTime(p.getOnTime() + 1);
+}
+
+
+
+//////////////////////////////
+//
+// testBuffer -- fill an event buffer and time the xcheck() calls for
+//     the given number of ticks.
+//
+
+void testBuffer(int waiting, int ticks) {
+   EventBuffer eventBuffer(waiting + ACTIVE_EVENTS);
+   FunctionEvent event;
+   int i;
+
+   for (i=0; i<waiting; i++) {
+      event.setFunction(wait);
+      event.setOnTime(60000 + ticks + i);
+      event.activate();
+      eventBuffer.insert(event);
+   }
+   for (i=0; i<ACTIVE_EVENTS; i++) {
+      event.setFunction(reschedule);
+      event.setOnTime(0);
+      event.activate();
+      eventBuffer.insert(event);
+   }
+
+   actionCount = 0;
+   int64_t total = 0;
+   int64_t maximum = 0;
+   int64_t start, elapsed;
+   for (i=0; i<ticks; i++) {
+      start = SigTimer::getMonotonicTime();
+      eventBuffer.xcheck((long)i);
+      elapsed = SigTimer::getMonotonicTime() - start;
+      total += elapsed;
+      if (elapsed > maximum) {
+         maximum = elapsed;
+      }
+   }
+
+   cout << waiting << "\t\t" << total / ticks << "\t\t" << maximum
+        << "\t\t" << actionCount << endl;
+}
+
+
+
+//////////////////////////////
+//
+// wait -- an event which is never reached.
+//
+
+void wait(FunctionEvent& p, EventBuffer& midiOutput) {
+   actionCount++;
+   p.off(midiOutput);
+}
+
+
+
@@ -0,0 +1,237 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 12:37:51 PDT 2026
+// Last Modified: Sun Oct 18 12:37:51 PDT 2026
+// Filename:      ...sig/doc/examples/improv/improv/inputbench.cpp
+// Syntax:        C++; improv
+//
+// Description:   Measures the throughput and CPU cost of MIDI input.
+//                A sender thread writes controller messages to an
+//                output port as fast as the input side keeps up, in
+//                bursts of the given number of messages, and the main
+//                thread reads them from an input port which is
+//                connected to the output port.  A loopback is needed:
+//                for example the two ends of an ALSA virtual MIDI port
+//                ("modprobe snd-virmidi"), or an output and an input
+//                joined with "aconnect" or a MIDI cable.  The two data
+//                bytes of each message hold a 14-bit sequence number,
+//                so lost messages are found.  The program prints the
+//                bytes and messages per second received, and the CPU
+//                time per message of the whole program, of the sender
+//                and reader threads, and of the rest (mostly the MIDI
+//                input thread).  It exits with a status of 1 if any
+//                message was lost.
+//
+
+#include "sigControl.h"
+#include <stdlib.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#include <atomic>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#define BULK_SIZE  (256)
+#define WINDOW     (2048)   /* most messages in flight at one time */
+
+int     atohd(const char* aNumber);
+int64_t cpuTime(int who);
+void    exitUsage(const char* command);
+void*   sendMessages(void* x);
+
+MidiOutPort        midiout;
+int                messageCount = 100000;
+int                burstSize    = 16;
+std::atomic<int>   receivedCount(0);
+std::atomic<int>   senderDone(0);
+int64_t            senderCpu    = 0;
+
+
+int main(int argc, char* argv[]) {
+   if (argc < 3 || argc > 5) {
+      exitUsage(argv[0]);
+   }
+   int outport = atohd(argv[1]);
+   int inport  = atohd(argv[2]);
+   if (argc > 3) messageCount = atohd(argv[3]);
+   if (argc > 4) burstSize    = atohd(argv[4]);
+   if (messageCount < 1 || burstSize < 1 || burstSize > WINDOW) {
+      exitUsage(argv[0]);
+   }
+
+   if (midiout.getNumPorts() <= outport) {
+      cout << "Error: highest available output port is: "
+           << midiout.getNumPorts()-1 << endl;
+      exit(1);
+   }
+   if (MidiInput::getNumPorts() <= inport) {
+      cout << "Error: highest available input port is: "
+           << MidiInput::getNumPorts()-1 << endl;
+      exit(1);
+   }
+   midiout.setPort(outport);
+   midiout.open();
+   MidiInput midiin;
+   midiin.setPort(inport);
+   midiin.open();
+   midiin.setBufferSize(WINDOW * 2);
+   smf::MidiEvent events[BULK_SIZE];
+   while (midiin.extract(events, BULK_SIZE) > 0) {
+      // throw away anything which arrived before the test
+   }
+
+   MidiInputStatistics before;
+   midiin.getStatistics(before);
+   int64_t processStart = cpuTime(RUSAGE_SELF);
+   int64_t readerStart  = cpuTime(RUSAGE_THREAD);
+   int64_t start = SigTimer::getMonotonicTime();
+
+   pthread_t thread;
+   if (pthread_create(&thread, NULL, sendMessages, NULL) != 0) {
+      cout << "Error: cannot start the sender thread" << endl;
+      exit(1);
+   }
+
+   int received = 0;
+   int lost = 0;
+   int other = 0;
+   int next = 0;
+   int extracted, sequence, gap, i;
+   while (received + lost < messageCount) {
+      if (!midiin.waitForMessage(1000.0)) {
+         cout << "Timed out waiting for input: is the output port "
+              << "connected to the input port?" << endl;
+         break;
+      }
+      extracted = midiin.extract(events, BULK_SIZE);
+      for (i=0; i<extracted; i++) {
+         if (events[i].size() != 3 || events[i].getP0() != 0xb0) {
+            other++;
+            continue;
+         }
+         sequence = (events[i].getP1() << 7) | events[i].getP2();
+         gap = (sequence - next) & 0x3fff;
+         lost += gap;
+         next = (sequence + 1) & 0x3fff;
+         received++;
+      }
+      receivedCount.store(received + lost, std::memory_order_release);
+   }
+   int64_t elapsed = SigTimer::getMonotonicTime() - start;
+   int64_t readerCpu = cpuTime(RUSAGE_THREAD) - readerStart;
+   senderDone.store(1);
+   receivedCount.store(messageCount, std::memory_order_release);
+   pthread_join(thread, NULL);
+   int64_t processCpu = cpuTime(RUSAGE_SELF) - processStart;
+
+   MidiInputStatistics after;
+   midiin.getStatistics(after);
+   int64_t bytes = after.bytes - before.bytes;
+   double seconds = elapsed / 1000000000.0;
+   int count = received > 0 ? received : 1;
+
+   cout << "Messages received:     " << received << " (" << lost
+        << " lost, " << other << " other, "
+        << after.dropped - before.dropped << " dropped by the buffer)"
+        << endl;
+   cout << "Bursts of:             " << burstSize << " messages" << endl;
+   cout << "Time:                  " << seconds * 1000.0 << " ms" << endl;
+   cout << "Bytes per second:      " << bytes / seconds << endl;
+   cout << "Messages per second:   " << received / seconds << endl;
+   cout << "Peak buffer use:       " << after.peak << " of " << after.size
+        << endl;
+   cout << "CPU us per message:" << endl;
+   cout << "   whole program:      " << processCpu / 1000.0 / count << endl;
+   cout << "   sender thread:      " << senderCpu / 1000.0 / count << endl;
+   cout << "   reader thread:      " << readerCpu / 1000.0 / count << endl;
+   cout << "   input thread, etc.: "
+        << (processCpu - senderCpu - readerCpu) / 1000.0 / count << endl;
+
+   return lost == 0 && received == messageCount ? 0 : 1;
+}
+
+
+
+int atohd(const char* aNumber) {
+   if (aNumber[0] == '0' && tolower(aNumber[1]) == 'x') {
+      return (int)strtol(aNumber, (char**)NULL, 16);
+   } else {
+      return atoi(aNumber);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// cpuTime -- returns the user plus system time in nanoseconds used by
+//     the process (RUSAGE_SELF) or by the calling thread (RUSAGE_THREAD).
+//
+
+int64_t cpuTime(int who) {
+   struct rusage usage;
+   if (getrusage(who, &usage) != 0) {
+      return 0;
+   }
+   return ((int64_t)usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) *
+         1000000000 + ((int64_t)usage.ru_utime.tv_usec +
+         usage.ru_stime.tv_usec) * 1000;
+}
+
+
+
+void exitUsage(const char* command) {
+   cout << endl;
+   cout << "Measures MIDI input throughput and CPU time per message\n";
+   cout << "through a loopback from an output port to an input port.\n";
+   cout << endl;
+   cout << "Usage: " << command << " outport inport [count [burst]]\n";
+   cout << endl;
+   cout << "   outport = MIDI output port to send to.\n";
+   cout << "   inport  = MIDI input port connected to the output port.\n";
+   cout << "   count   = messages to send, default is 100000.\n";
+   cout << "   burst   = messages written at once, default is 16.\n";
+   cout << endl;
+   exit(1);
+}
+
+
+
+//////////////////////////////
+//
+// sendMessages -- write the messages in bursts, keeping no more than
+//     WINDOW messages ahead of the reader so that the input buffer
+//     does not overflow.
+//
+
+void* sendMessages(void* x) {
+   int64_t cpuStart = cpuTime(RUSAGE_THREAD);
+   vector<uchar> burst(burstSize * 3);
+   int sent = 0;
+   int size, i;
+   while (sent < messageCount && !senderDone.load()) {
+      if (sent - receivedCount.load(std::memory_order_acquire) >
+            WINDOW - burstSize) {
+         sched_yield();
+         continue;
+      }
+      size = messageCount - sent;
+      if (size > burstSize) {
+         size = burstSize;
+      }
+      for (i=0; i<size; i++) {
+         burst[i*3]   = 0xb0;
+         burst[i*3+1] = ((sent + i) >> 7) & 0x7f;
+         burst[i*3+2] = (sent + i) & 0x7f;
+      }
+      midiout.rawsend(burst.data(), size * 3);
+      sent += size;
+   }
+   senderCpu = cpuTime(RUSAGE_THREAD) - cpuStart;
+   return NULL;
+}
@@ -2,23 +2,22 @@
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: 4 June 2002
 // Last Modified: 4 June 2002
+// Last Modified: Sat Oct 17 20:04:37 PDT 2026 (use MidiOutputGroup)
 // Filename:      ...sig/doc/examples/improv/improv/midithru/midithru.cpp
 // Syntax:        C++; improv
 //
 // Description:   Have the computer act as a Patch Bay.  Send MIDI input
 //                data to any MIDI output port.  MIDI input can be sent
-//                to multiple output.
+//                to multiple output.  Each input has a MidiOutputGroup
+//                which writes a message to all of its outputs.
 //
 
 #include "improv.h"
 
 typedef Array<int> ArrayInt;
-typedef Array<MidiOutPort> MidiOutputArray;
 
 // function declarations:
 void displayPatchBay(Array<ArrayInt>& connections);
-void sendData(smf::MidiEvent& message, MidiOutPort& output, 
-    MidiInput& input);
 
 /////////////////////////////////////////////////////////////////////////
 
@@ -43,20 +42,27 @@ int main(int argc, char* argv[]) {
 
    smf::MidiEvent message;
    Array<MidiInput> midiins;
+   midiins.setSize(incount);
    for (i=0; i<incount; i++) {
       midiins[i].setPort(i);
       midiins[i].open();
    }
 
-   Array<MidiOutPort> midiouts;
-   midiouts.setSize(outcount);
-   for (i=0; i<outcount; i++) {
-      midiouts[i].setPort(i);
-      midiouts[i].open();
-      cout << "opened MIDI output number " << i << endl;
+   if (incount > 0 && outcount > 3) {
+      connections[0][3] = 0;
+   }
+
+   // one group of outputs for each input
+   Array<MidiOutputGroup*> groups;
+   groups.setSize(incount);
+   for (i=0; i<incount; i++) {
+      groups[i] = new MidiOutputGroup;
+      for (j=0; j<outcount; j++) {
+         if (connections[i][j]) {
+            groups[i]->addDestination(j);
+         }
+      }
    }
- 
-   connections[0][3] = 0;
 
    displayPatchBay(connections);
    int done = 0;
@@ -67,40 +73,25 @@ int main(int argc, char* argv[]) {
             if (message.getP1() == A0) {
                done = 1;
             }
+            groups[i]->send(message);
             cout << "[" << i << ":";
-            for (j=0; j<outcount; j++) {
-               if (connections[i][j]) {
-                  cout << j << " ";
-                  sendData(message, midiouts[j], midiins[i]);
-               }
+            for (j=0; j<groups[i]->getDestinationCount(); j++) {
+               cout << groups[i]->getPort(j) << " ";
             } 
             cout << "]" << flush;
          }
       }
    }
 
+   for (i=0; i<incount; i++) {
+      delete groups[i];
+   }
    return 0;
 }
 
 
 //////////////////////////////////////////////////////////////////////////
 
-//////////////////////////////
-//
-// sendData --
-//
-
-void sendData(smf::MidiEvent& m, MidiOutPort& output, 
-     MidiInput& input) {
-   int count = m.size()-1;
-   if (count >= 0 && count <= 2) {
-      if (count >= 0) output.rawsend(m.getP0());
-      if (count >= 1) output.rawsend(m.getP0(), m.getP1());
-      if (count >= 2) output.rawsend(m.getP0(), m.getP1(), m.getP2());
-   }
-}
-
-
 //////////////////////////////
 //
 // displayPatchBay --
@@ -0,0 +1,309 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 10:41:12 PDT 2026
+// Last Modified: Sun Oct 18 10:41:12 PDT 2026
+// Filename:      ...sig/doc/examples/improv/improv/parsebench.cpp
+// Syntax:        C++; improv
+//
+// Description:   Measures the speed of MidiStreamParser::parse() on dense
+//                synthetic MIDI byte streams:
+//                   running   -- note messages in running status, with
+//                                a new status byte every 64 messages.
+//                   realtime  -- note messages with a timing clock byte
+//                                (0xf8) inside of every message.
+//                   sysex     -- 256-byte system exclusive messages with
+//                                clock bytes inside, between controller
+//                                messages.
+//                   mixed     -- all of the above, given to the parser
+//                                in chunks of 1 to 64 bytes so that
+//                                messages are split between calls.
+//                The messages from the parser are counted and compared
+//                with the number of messages in the stream, and the
+//                program exits with a status of 1 if they differ or if
+//                the parser reports an error.  No MIDI port is needed.
+//
+
+#include "sigControl.h"
+#include "MidiStreamParser.h"
+#include <stdlib.h>
+#include <ctype.h>
+#include <string.h>
+
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#define SYSEX_SIZE  (256)
+
+// the expected contents of a stream
+struct Stream {
+   const char*    name;
+   vector<uchar>  bytes;
+   int64_t        messages;        // complete messages in the stream
+   int64_t        messageBytes;    // bytes of the complete messages
+   int            randomChunks;    // parse in chunks of 1 to 64 bytes
+};
+
+// what the parser delivered
+struct Received {
+   int64_t        messages;
+   int64_t        bytes;
+   int64_t        errors;          // messages without a status byte
+};
+
+int   atohd(const char* aNumber);
+void  countMessage(const uchar* data, int size, int64_t timestamp,
+            void* userdata);
+void  exitUsage(const char* command);
+void  makeMixed(Stream& stream, int count);
+void  makeRealtime(Stream& stream, int count);
+void  makeRunning(Stream& stream, int count);
+void  makeSysex(Stream& stream, int count);
+int   testStream(Stream& stream, int repeat, int chunkSize);
+
+
+int main(int argc, char* argv[]) {
+   int count  = 1000000;
+   int repeat = 10;
+   int chunk  = 4096;
+   if (argc > 4) {
+      exitUsage(argv[0]);
+   }
+   if (argc > 1) count  = atohd(argv[1]);
+   if (argc > 2) repeat = atohd(argv[2]);
+   if (argc > 3) chunk  = atohd(argv[3]);
+   if (count < 1 || repeat < 1 || chunk < 1) {
+      exitUsage(argv[0]);
+   }
+
+   Stream streams[4];
+   makeRunning(streams[0], count);
+   makeRealtime(streams[1], count);
+   makeSysex(streams[2], count / 32 + 1);
+   makeMixed(streams[3], count);
+
+   cout << "stream\t\tMB/s\tns per message\tmessages" << endl;
+   int errors = 0;
+   for (int i=0; i<4; i++) {
+      errors += testStream(streams[i], repeat, chunk);
+   }
+   return errors == 0 ? 0 : 1;
+}
+
+
+
+int atohd(const char* aNumber) {
+   if (aNumber[0] == '0' && tolower(aNumber[1]) == 'x') {
+      return (int)strtol(aNumber, (char**)NULL, 16);
+   } else {
+      return atoi(aNumber);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// countMessage -- the parser callback.
+//
+
+void countMessage(const uchar* data, int size, int64_t timestamp,
+      void* userdata) {
+   Received& received = *((Received*)userdata);
+   received.messages++;
+   received.bytes += size;
+   if ((data[0] & 0x80) == 0) {
+      received.errors++;
+   }
+}
+
+
+
+void exitUsage(const char* command) {
+   cout << endl;
+   cout << "Measures the speed of MidiStreamParser on synthetic streams.\n";
+   cout << endl;
+   cout << "Usage: " << command << " [count [repeat [chunk]]]\n";
+   cout << endl;
+   cout << "   count  = note messages in each stream, default 1000000.\n";
+   cout << "   repeat = times to parse each stream, default 10.\n";
+   cout << "   chunk  = bytes given to each parse() call, default 4096.\n";
+   cout << endl;
+   exit(1);
+}
+
+
+
+//////////////////////////////
+//
+// makeMixed -- running status, realtime and sysex messages, one after
+//    the other, parsed in random chunks.
+//
+
+void makeMixed(Stream& stream, int count) {
+   Stream part[3];
+   makeRunning(part[0], count / 4 + 1);
+   makeRealtime(part[1], count / 4 + 1);
+   makeSysex(part[2], count / 128 + 1);
+   stream.name = "mixed";
+   stream.bytes.clear();
+   stream.messages = 0;
+   stream.messageBytes = 0;
+   for (int i=0; i<3; i++) {
+      stream.bytes.insert(stream.bytes.end(), part[i].bytes.begin(),
+            part[i].bytes.end());
+      stream.messages += part[i].messages;
+      stream.messageBytes += part[i].messageBytes;
+   }
+   stream.randomChunks = 1;
+}
+
+
+
+//////////////////////////////
+//
+// makeRealtime -- note messages with a timing clock in the middle.
+//
+
+void makeRealtime(Stream& stream, int count) {
+   stream.name = "realtime";
+   stream.bytes.clear();
+   stream.bytes.reserve((size_t)count * 5);
+   for (int i=0; i<count; i++) {
+      stream.bytes.push_back(0x90 | (i & 0x0f));
+      stream.bytes.push_back(0xf8);
+      stream.bytes.push_back(i & 0x7f);
+      stream.bytes.push_back(0xf8);
+      stream.bytes.push_back(64);
+   }
+   stream.messages = (int64_t)count * 3;
+   stream.messageBytes = (int64_t)count * 5;
+   stream.randomChunks = 0;
+}
+
+
+
+//////////////////////////////
+//
+// makeRunning -- note messages in running status.
+//
+
+void makeRunning(Stream& stream, int count) {
+   stream.name = "running";
+   stream.bytes.clear();
+   stream.bytes.reserve((size_t)count * 3);
+   for (int i=0; i<count; i++) {
+      if ((i & 0x3f) == 0) {
+         stream.bytes.push_back(0x90 | ((i >> 6) & 0x0f));
+      }
+      stream.bytes.push_back(i & 0x7f);
+      stream.bytes.push_back((i >> 7) & 0x7f);
+   }
+   // the parser delivers each message with its status byte
+   stream.messages = count;
+   stream.messageBytes = (int64_t)count * 3;
+   stream.randomChunks = 0;
+}
+
+
+
+//////////////////////////////
+//
+// makeSysex -- system exclusive messages with clock bytes inside,
+//    each followed by a controller message.
+//
+
+void makeSysex(Stream& stream, int count) {
+   stream.name = "sysex";
+   stream.bytes.clear();
+   stream.bytes.reserve((size_t)count * (SYSEX_SIZE + 16));
+   int clocks = 0;
+   int j;
+   for (int i=0; i<count; i++) {
+      stream.bytes.push_back(0xf0);
+      for (j=1; j<SYSEX_SIZE-1; j++) {
+         if ((j & 0x1f) == 0) {
+            stream.bytes.push_back(0xf8);
+            clocks++;
+         }
+         stream.bytes.push_back((i + j) & 0x7f);
+      }
+      stream.bytes.push_back(0xf7);
+      stream.bytes.push_back(0xb0 | (i & 0x0f));
+      stream.bytes.push_back(7);
+      stream.bytes.push_back(i & 0x7f);
+   }
+   stream.messages = (int64_t)count * 2 + clocks;
+   stream.messageBytes = (int64_t)count * (SYSEX_SIZE + 3) + clocks;
+   stream.randomChunks = 0;
+}
+
+
+
+//////////////////////////////
+//
+// testStream -- parse a stream repeat times and print the speed.
+//    Returns 1 if the parser did not deliver the expected messages.
+//
+
+int testStream(Stream& stream, int repeat, int chunkSize) {
+   Received received;
+   received.messages = 0;
+   received.bytes = 0;
+   received.errors = 0;
+   MidiStreamParser parser(countMessage, &received);
+
+   // the chunk sizes are made before timing starts
+   vector<int> chunks;
+   int size = (int)stream.bytes.size();
+   int position = 0;
+   int length;
+   srand(1);
+   while (position < size) {
+      length = stream.randomChunks ? rand() % 64 + 1 : chunkSize;
+      if (length > size - position) {
+         length = size - position;
+      }
+      chunks.push_back(length);
+      position += length;
+   }
+
+   const uchar* data = stream.bytes.data();
+   int i, j;
+   int64_t start = SigTimer::getMonotonicTime();
+   for (i=0; i<repeat; i++) {
+      position = 0;
+      for (j=0; j<(int)chunks.size(); j++) {
+         parser.parse(data + position, chunks[j]);
+         position += chunks[j];
+      }
+   }
+   int64_t elapsed = SigTimer::getMonotonicTime() - start;
+   if (elapsed < 1) {
+      elapsed = 1;
+   }
+
+   int64_t messages = stream.messages * repeat;
+   double megabytes = (double)size * repeat / 1000000.0;
+   cout << stream.name << (strlen(stream.name) < 8 ? "\t\t" : "\t")
+        << megabytes / (elapsed / 1000000000.0) << "\t"
+        << (double)elapsed / messages << "\t\t" << received.messages
+        << endl;
+
+   int errors = 0;
+   if (received.messages != messages) {
+      cout << "Error: expected " << messages << " messages" << endl;
+      errors = 1;
+   }
+   if (received.bytes != stream.messageBytes * repeat) {
+      cout << "Error: expected " << stream.messageBytes * repeat
+           << " bytes of messages but received " << received.bytes << endl;
+      errors = 1;
+   }
+   if (received.errors != 0 || parser.getErrorCount() != 0) {
+      cout << "Error: " << received.errors << " messages without status, "
+           << parser.getErrorCount() << " parser errors" << endl;
+      errors = 1;
+   }
+   return errors;
+}
@@ -0,0 +1,265 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 22:03:18 PDT 2026
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026
+// Filename:      ...sig/doc/examples/improv/improv/recordbench.cpp
+// Syntax:        C++; improv
+//
+// Description:   Checks that MidiFileRecorder keeps up with a full MIDI
+//                session.  One thread for each simulated input port
+//                sends messages into a shared recorder at the speed of
+//                a MIDI cable (3125 bytes per second, about 1000
+//                three-byte messages per second), calling recordInput()
+//                the same way that the MIDI input thread does.  The
+//                messages are notes, controllers, pitch bends and a
+//                short sysex now and then.  At the end the number of
+//                messages which were lost, the time taken by each
+//                recordInput() call, and the size of the file are
+//                printed.  The program exits with a status of 1 if any
+//                message was lost.
+//
+
+#include "sigControl.h"
+#include <stdlib.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#define WIRE_BYTES_PER_SECOND (3125)
+#define SYSEX_INTERVAL        (500)     // messages between sysexs
+#define SYSEX_SIZE            (32)
+#define HISTOGRAM_SIZE        (16)
+
+// the state of one simulated input port
+struct PortSimulation {
+   int                port;
+   int                seconds;
+   MidiFileRecorder*  recorder;
+   int64_t            messages;
+   int64_t            bytes;
+   int64_t            maxTime;          // slowest recordInput() call (ns)
+   int64_t            histogram[HISTOGRAM_SIZE]; // by power of two in us
+};
+
+int   atohd(const char* aNumber);
+void  exitUsage(const char* command);
+int   makeMessage(uchar* data, int64_t index, int port);
+void* simulatePort(void* x);
+void  printHistogram(const char* title, const int64_t* histogram);
+
+
+int main(int argc, char* argv[]) {
+   int seconds = 10;
+   int ports   = 16;
+   int format  = MIDI_RECORD_BY_PORT;
+
+   if (argc >= 2 && argc <= 5) {
+      if (argc > 2) seconds = atohd(argv[2]);
+      if (argc > 3) ports   = atohd(argv[3]);
+      if (argc > 4) format  = atohd(argv[4]);
+   } else {
+      exitUsage(argv[0]);
+   }
+   if (seconds < 1 || ports < 1 || format < MIDI_RECORD_ONE_TRACK ||
+         format > MIDI_RECORD_LOG) {
+      exitUsage(argv[0]);
+   }
+
+   MidiFileRecorder recorder;
+   if (!recorder.start(argv[1], format)) {
+      exit(1);
+   }
+
+   vector<PortSimulation> simulation(ports);
+   vector<pthread_t> thread(ports);
+   for (int i=0; i<ports; i++) {
+      PortSimulation& port = simulation[i];
+      port.port     = i;
+      port.seconds  = seconds;
+      port.recorder = &recorder;
+      port.messages = 0;
+      port.bytes    = 0;
+      port.maxTime  = 0;
+      for (int j=0; j<HISTOGRAM_SIZE; j++) {
+         port.histogram[j] = 0;
+      }
+      if (pthread_create(&thread[i], NULL, simulatePort, &port) != 0) {
+         cout << "Error: cannot start port thread " << i << endl;
+         exit(1);
+      }
+   }
+
+   int64_t messages = 0;
+   int64_t bytes    = 0;
+   int64_t maxTime  = 0;
+   int64_t histogram[HISTOGRAM_SIZE] = {0};
+   for (int i=0; i<ports; i++) {
+      pthread_join(thread[i], NULL);
+      messages += simulation[i].messages;
+      bytes    += simulation[i].bytes;
+      if (simulation[i].maxTime > maxTime) {
+         maxTime = simulation[i].maxTime;
+      }
+      for (int j=0; j<HISTOGRAM_SIZE; j++) {
+         histogram[j] += simulation[i].histogram[j];
+      }
+   }
+
+   int64_t stopStart = SigTimer::getMonotonicTime();
+   int status = recorder.stop();
+   int64_t stopTime = SigTimer::getMonotonicTime() - stopStart;
+   int64_t lost = recorder.getLostCount();
+
+   struct stat info;
+   int64_t fileSize = stat(argv[1], &info) == 0 ? (int64_t)info.st_size : 0;
+
+   cout << "Ports:             " << ports << endl;
+   cout << "Seconds:           " << seconds << endl;
+   cout << "Messages recorded: " << messages - lost << " of " << messages
+        << " (" << messages / seconds << " per second, "
+        << bytes / seconds << " bytes per second)" << endl;
+   cout << "Messages lost:     " << lost << endl;
+   cout << "recordInput():     maximum " << maxTime / 1000.0 << " us" << endl;
+   cout << "File:              " << argv[1] << ", " << fileSize
+        << " bytes, written in " << stopTime / 1000000.0 << " ms"
+        << (status ? "" : " (WRITE FAILED)") << endl;
+   cout << endl;
+   printHistogram("recordInput() time", histogram);
+
+   return (lost == 0 && status) ? 0 : 1;
+}
+
+
+
+int atohd(const char* aNumber) {
+   if (aNumber[0] == '0' && tolower(aNumber[1]) == 'x') {
+      return (int)strtol(aNumber, (char**)NULL, 16);
+   } else {
+      return atoi(aNumber);
+   }
+}
+
+
+
+void exitUsage(const char* command) {
+      cout << endl;
+      cout << "Records simulated MIDI input from several ports at the\n";
+      cout << "speed of a MIDI cable, and reports any lost messages.\n";
+      cout << endl;
+      cout << "Usage: " << command
+           << " filename [seconds [ports [format]]]\n";
+      cout << endl;
+      cout << "   filename = file to record into\n";
+      cout << "   seconds  = length of the recording, default is 10.\n";
+      cout << "   ports    = number of input ports, default is 16.\n";
+      cout << "   format   = 0: type 0 MIDI file, 1: track for each port\n";
+      cout << "              (default), 2: track for each channel,\n";
+      cout << "              3: binary log.\n";
+      cout << endl;
+      exit(1);
+}
+
+
+
+//////////////////////////////
+//
+// makeMessage -- fill in the next message for a port, and return its
+//     size: note-ons and note-offs, controllers and pitch bends on the
+//     channel of the port, with a sysex every SYSEX_INTERVAL messages.
+//
+
+int makeMessage(uchar* data, int64_t index, int port) {
+   int channel = port & 0x0f;
+   if (index % SYSEX_INTERVAL == SYSEX_INTERVAL - 1) {
+      data[0] = 0xf0;
+      for (int i=1; i<SYSEX_SIZE-1; i++) {
+         data[i] = (uchar)((index + i) & 0x7f);
+      }
+      data[SYSEX_SIZE-1] = 0xf7;
+      return SYSEX_SIZE;
+   }
+   int key = 36 + (int)((index / 4) % 48);
+   switch (index % 4) {
+      case 0:
+         data[0] = 0x90 | channel; data[1] = key;  data[2] = 64;
+         break;
+      case 1:
+         data[0] = 0xb0 | channel; data[1] = 1;    data[2] = index & 0x7f;
+         break;
+      case 2:
+         data[0] = 0xe0 | channel; data[1] = 0;    data[2] = index & 0x7f;
+         break;
+      default:
+         data[0] = 0x80 | channel; data[1] = key;  data[2] = 0;
+   }
+   return 3;
+}
+
+
+
+//////////////////////////////
+//
+// simulatePort -- send messages into the recorder at the speed of a
+//     MIDI cable, as the input thread would when they arrive.
+//
+
+void* simulatePort(void* x) {
+   PortSimulation& port = *((PortSimulation*)x);
+   uchar data[SYSEX_SIZE];
+   int64_t start = SigTimer::getMonotonicTime();
+   int64_t stop  = start + (int64_t)port.seconds * 1000000000;
+   int64_t wireTime = start;
+   struct timespec wakeup;
+   int size, bin;
+   int64_t before, elapsed, limit;
+
+   while (wireTime < stop) {
+      // wait until the message would have finished arriving
+      wakeup.tv_sec  = (time_t)(wireTime / 1000000000);
+      wakeup.tv_nsec = (long)(wireTime % 1000000000);
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL);
+
+      size = makeMessage(data, port.messages, port.port);
+      before = SigTimer::getMonotonicTime();
+      port.recorder->recordInput(port.port, data, size, wireTime);
+      elapsed = SigTimer::getMonotonicTime() - before;
+
+      if (elapsed > port.maxTime) {
+         port.maxTime = elapsed;
+      }
+      bin = 0;
+      limit = 1000;
+      while (elapsed >= limit && bin < HISTOGRAM_SIZE - 1) {
+         limit *= 2;
+         bin++;
+      }
+      port.histogram[bin]++;
+
+      port.messages++;
+      port.bytes += size;
+      wireTime += (int64_t)size * 1000000000 / WIRE_BYTES_PER_SECOND;
+   }
+   return NULL;
+}
+
+
+
+void printHistogram(const char* title, const int64_t* histogram) {
+   int last = HISTOGRAM_SIZE - 1;
+   while (last > 0 && histogram[last] == 0) {
+      last--;
+   }
+   cout << title << ":" << endl;
+   for (int i=0; i<=last; i++) {
+      cout << "\t< " << (i == 0 ? 1 : (1 << i)) << " us:\t"
+           << histogram[i] << endl;
+   }
+}
+
+
+
@@ -0,0 +1,188 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 17:34:26 PDT 2026
+// Last Modified: Sat Oct 17 17:34:26 PDT 2026
+// Filename:      ...sig/doc/examples/improv/improv/sendjitter.cpp
+// Syntax:        C++; improv
+//
+// Description:   Measures the timing of MidiOutput::sendAt().  A
+//                series of controller messages is scheduled on an
+//                output port which is connected back to an input port
+//                (with a MIDI cable, or with an ALSA connection such as
+//                "aconnect").  The arrival times are compared to the
+//                scheduled times, and histograms of the lateness at the
+//                sender thread and of the jitter at the input are
+//                printed.
+//
+
+#include "sigControl.h"
+#include <stdlib.h>
+#include <ctype.h>
+
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#define JITTER_CONTROLLER (16)
+
+int  atohd(const char* aNumber);
+void exitUsage(const char* command);
+void printHistogram(const char* title, const int64_t* histogram);
+
+
+int main(int argc, char* argv[]) {
+   int outport  = 0;
+   int inport   = 0;
+   int count    = 1000;
+   int interval = 5;     // milliseconds between messages
+
+   if (argc >= 3 && argc <= 5) {
+      outport = atohd(argv[1]);
+      inport  = atohd(argv[2]);
+      if (argc > 3) count    = atohd(argv[3]);
+      if (argc > 4) interval = atohd(argv[4]);
+   } else {
+      exitUsage(argv[0]);
+   }
+   if (count < 1 || interval < 1) exitUsage(argv[0]);
+
+   MidiOutput midiout;
+   MidiInput  midiin;
+   if (midiout.getNumPorts() <= outport) {
+      cout << "Error: highest available output port is: "
+           << midiout.getNumPorts()-1 << endl;
+      exit(1);
+   }
+   if (midiin.getNumPorts() <= inport) {
+      cout << "Error: highest available input port is: "
+           << midiin.getNumPorts()-1 << endl;
+      exit(1);
+   }
+   midiout.setPort(outport);
+   midiout.open();
+   midiin.setPort(inport);
+   midiin.open();
+
+   // schedule all of the messages, starting a little in the future
+   vector<int64_t> sendtime(count);
+   int64_t start = SigTimer::getMonotonicTime() + 100000000;
+   for (int i=0; i<count; i++) {
+      sendtime[i] = start + (int64_t)i * interval * 1000000;
+      midiout.sendAt(sendtime[i], 0xb0, JITTER_CONTROLLER, i & 0x7f);
+   }
+
+   // collect the arrival times
+   vector<int64_t> latency;
+   latency.reserve(count);
+   smf::MidiEvent message;
+   int64_t timestamp;
+   while ((int)latency.size() < count) {
+      if (!midiin.waitForMessage(1000.0)) {
+         cout << "Timed out waiting for input: is the output port "
+              << "connected to the input port?" << endl;
+         break;
+      }
+      while (midiin.getCount() > 0) {
+         midiin.extract(message, timestamp);
+         if (message.size() != 3 || (message[0] & 0xf0) != 0xb0 ||
+               message[1] != JITTER_CONTROLLER) {
+            continue;
+         }
+         latency.push_back(timestamp - sendtime[latency.size()]);
+         if ((int)latency.size() >= count) {
+            break;
+         }
+      }
+   }
+   if (latency.empty()) {
+      exit(1);
+   }
+
+   // the jitter is the variation of the loopback latency above its minimum
+   int64_t minimum = latency[0];
+   int64_t maximum = latency[0];
+   int64_t sum = 0;
+   for (int i=0; i<(int)latency.size(); i++) {
+      if (latency[i] < minimum) minimum = latency[i];
+      if (latency[i] > maximum) maximum = latency[i];
+      sum += latency[i];
+   }
+   int64_t jitter[MIDI_SEND_HISTOGRAM_SIZE] = {0};
+   for (int i=0; i<(int)latency.size(); i++) {
+      int bin = 0;
+      int64_t limit = 1000;
+      while (latency[i] - minimum >= limit &&
+            bin < MIDI_SEND_HISTOGRAM_SIZE - 1) {
+         limit *= 2;
+         bin++;
+      }
+      jitter[bin]++;
+   }
+
+   MidiSendStatistics stats;
+   midiout.getSendStatistics(stats);
+
+   cout << "Messages sent:     " << stats.sent << endl;
+   cout << "Messages received: " << latency.size() << endl;
+   if (stats.sent > 0) {
+      cout << "Sender lateness:   average "
+           << stats.totalLateness / stats.sent / 1000.0 << " us, maximum "
+           << stats.maxLateness / 1000.0 << " us" << endl;
+   }
+   cout << "Loopback latency:  minimum " << minimum / 1000.0
+        << " us, average " << sum / (int64_t)latency.size() / 1000.0
+        << " us, maximum " << maximum / 1000.0 << " us" << endl;
+   cout << endl;
+   printHistogram("Sender lateness", stats.histogram);
+   cout << endl;
+   printHistogram("Loopback jitter (latency above minimum)", jitter);
+
+   midiout.close();
+   midiin.close();
+   return 0;
+}
+
+
+
+int atohd(const char* aNumber) {
+   if (aNumber[0] == '0' && tolower(aNumber[1]) == 'x') {
+      return (int)strtol(aNumber, (char**)NULL, 16);
+   } else {
+      return atoi(aNumber);
+   }
+}
+
+
+
+void exitUsage(const char* command) {
+      cout << endl;
+      cout << "Measures the timing of scheduled MIDI output through a\n";
+      cout << "loopback connection from an output port to an input port.\n";
+      cout << endl;
+      cout << "Usage: " << command
+           << " outport inport [count [interval]]\n";
+      cout << endl;
+      cout << "   outport  = MIDI output port\n";
+      cout << "   inport   = MIDI input port connected to the output port\n";
+      cout << "   count    = number of messages to send, default is 1000.\n";
+      cout << "   interval = milliseconds between messages, default is 5.\n";
+      cout << endl;
+      exit(1);
+}
+
+
+
+void printHistogram(const char* title, const int64_t* histogram) {
+   int last = MIDI_SEND_HISTOGRAM_SIZE - 1;
+   while (last > 0 && histogram[last] == 0) {
+      last--;
+   }
+   cout << title << ":" << endl;
+   for (int i=0; i<=last; i++) {
+      cout << "\t< " << (i == 0 ? 1 : (1 << i)) << " us:\t" 
+           << histogram[i] << endl;
+   }
+}
+
+
+
@@ -0,0 +1,335 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 09:12:44 PDT 2026
+// Last Modified: Sun Oct 18 09:12:44 PDT 2026
+// Filename:      ...sig/doc/examples/improv/improv/spscstress.cpp
+// Syntax:        C++; improv
+//
+// Description:   Stress test of the lock-free SpscBuffer used for MIDI
+//                input, and of MidiInput::insert() on a live input port.
+//
+//                First a producer thread inserts a sequence of numbers
+//                into a small SpscBuffer as fast as it can, trying again
+//                whenever the buffer is full, while the main thread
+//                takes them out with single and bulk extract() calls.
+//                Every number must arrive exactly once and in order, and
+//                getCount() must never be outside of the buffer size.
+//
+//                Then, if an input port is given, several threads call
+//                insert() on a MidiInput for that port while its input
+//                thread is running, and the main thread extracts the
+//                messages.  Each thread sends controller messages on its
+//                own channel with a 14-bit sequence number in the two
+//                data bytes, so the messages of each thread must arrive
+//                in order, and the messages received plus the messages
+//                dropped because the buffer was full must add up to the
+//                messages sent.  Don't play into the port during the
+//                test.  The program exits with a status of 1 if any
+//                check fails.  It can be compiled with -fsanitize=thread
+//                to look for data races.
+//
+
+#include "sigControl.h"
+#include "SpscBuffer.h"
+#include <stdlib.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <atomic>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#define BULK_SIZE  (64)
+
+// the state of one thread which inserts into a MidiInput
+struct Inserter {
+   int                channel;
+   int                count;          // messages to insert
+   MidiInput*         input;
+   std::atomic<int>   done;
+};
+
+int   atohd(const char* aNumber);
+void  exitUsage(const char* command);
+void* insertMessages(void* x);
+void* produce(void* x);
+int   testInsert(int port, int threads, int count);
+int   testRing(int count, int size);
+
+SpscBuffer<int>* ring = NULL;
+int ringCount = 0;
+
+
+int main(int argc, char* argv[]) {
+   int count   = 10000000;
+   int size    = 256;
+   int port    = -1;
+   int threads = 4;
+   if (argc > 5) {
+      exitUsage(argv[0]);
+   }
+   if (argc > 1) count   = atohd(argv[1]);
+   if (argc > 2) size    = atohd(argv[2]);
+   if (argc > 3) port    = atohd(argv[3]);
+   if (argc > 4) threads = atohd(argv[4]);
+   if (count < 1 || size < 2 || threads < 1 || threads > 16) {
+      exitUsage(argv[0]);
+   }
+
+   int errors = testRing(count, size);
+   if (port >= 0) {
+      errors += testInsert(port, threads, count < 100000 ? count : 100000);
+   }
+   return errors == 0 ? 0 : 1;
+}
+
+
+
+int atohd(const char* aNumber) {
+   if (aNumber[0] == '0' && tolower(aNumber[1]) == 'x') {
+      return (int)strtol(aNumber, (char**)NULL, 16);
+   } else {
+      return atoi(aNumber);
+   }
+}
+
+
+
+void exitUsage(const char* command) {
+   cout << endl;
+   cout << "Hammers an SpscBuffer from two threads, and optionally\n";
+   cout << "calls MidiInput::insert() from several threads on an open\n";
+   cout << "input port, checking that nothing is lost or reordered.\n";
+   cout << endl;
+   cout << "Usage: " << command << " [count [size [port [threads]]]]\n";
+   cout << endl;
+   cout << "   count   = numbers to pass through the ring, default 10000000.\n";
+   cout << "   size    = size of the ring, default is 256.\n";
+   cout << "   port    = MIDI input port for the insert() test, default none.\n";
+   cout << "   threads = threads calling insert(), 1 to 16, default is 4.\n";
+   cout << endl;
+   exit(1);
+}
+
+
+
+//////////////////////////////
+//
+// insertMessages -- insert the messages of one thread into the input
+//     buffer.  The two data bytes hold a 14-bit sequence number.
+//
+
+void* insertMessages(void* x) {
+   Inserter& inserter = *((Inserter*)x);
+   smf::MidiEvent message;
+   message.tick = 0;
+   message.setP0(0xb0 | inserter.channel);
+   message.setP3(0);
+   for (int i=0; i<inserter.count; i++) {
+      message.setP1((i >> 7) & 0x7f);
+      message.setP2(i & 0x7f);
+      inserter.input->insert(message);
+      if ((i & 0xff) == 0) {
+         sched_yield();
+      }
+   }
+   inserter.done.store(1, std::memory_order_release);
+   return NULL;
+}
+
+
+
+//////////////////////////////
+//
+// produce -- insert the numbers 0 to ringCount-1 into the ring, trying
+//     again whenever it is full.
+//
+
+void* produce(void* x) {
+   for (int i=0; i<ringCount; i++) {
+      while (!ring->insert(i)) {
+         sched_yield();
+      }
+   }
+   return NULL;
+}
+
+
+
+//////////////////////////////
+//
+// testInsert -- call MidiInput::insert() from several threads while the
+//     input thread of the port is running.  Returns the number of errors.
+//
+
+int testInsert(int port, int threads, int count) {
+   if (port >= MidiInput::getNumPorts()) {
+      cout << "Error: there is no MIDI input port " << port << endl;
+      return 1;
+   }
+   MidiInput input(port, 1);
+   input.setBufferSize(1024);
+   MidiInputStatistics before;
+   input.getStatistics(before);
+
+   vector<Inserter> inserter(threads);
+   vector<pthread_t> thread(threads);
+   vector<int> nextSequence(threads, 0);
+   vector<int> received(threads, 0);
+   int i;
+   for (i=0; i<threads; i++) {
+      inserter[i].channel = i;
+      inserter[i].count   = count;
+      inserter[i].input   = &input;
+      inserter[i].done.store(0);
+   }
+   int64_t start = SigTimer::getMonotonicTime();
+   for (i=0; i<threads; i++) {
+      if (pthread_create(&thread[i], NULL, insertMessages, &inserter[i]) != 0) {
+         cout << "Error: cannot start insert thread " << i << endl;
+         exit(1);
+      }
+   }
+
+   smf::MidiEvent events[BULK_SIZE];
+   int errors = 0;
+   int other = 0;
+   int finished = 0;
+   int extracted, channel, sequence, gap, j;
+   while (1) {
+      if (!finished) {
+         finished = 1;
+         for (i=0; i<threads; i++) {
+            if (!inserter[i].done.load(std::memory_order_acquire)) {
+               finished = 0;
+               break;
+            }
+         }
+      } else if (input.getCount() == 0) {
+         break;
+      }
+      extracted = input.extract(events, BULK_SIZE);
+      for (j=0; j<extracted; j++) {
+         channel = events[j].getP0() & 0x0f;
+         if ((events[j].getP0() & 0xf0) != 0xb0 || channel >= threads) {
+            other++;
+            continue;
+         }
+         // messages which were dropped leave a gap in the sequence, and
+         // a step backwards means a message was repeated or reordered
+         sequence = (events[j].getP1() << 7) | events[j].getP2();
+         gap = (sequence - nextSequence[channel]) & 0x3fff;
+         if (gap >= 0x2000) {
+            errors++;
+         } else {
+            nextSequence[channel] += gap + 1;
+         }
+         received[channel]++;
+      }
+      if (extracted == 0) {
+         sched_yield();
+      }
+   }
+   int64_t elapsed = SigTimer::getMonotonicTime() - start;
+   for (i=0; i<threads; i++) {
+      pthread_join(thread[i], NULL);
+   }
+
+   MidiInputStatistics after;
+   input.getStatistics(after);
+   int64_t total = 0;
+   for (i=0; i<threads; i++) {
+      total += received[i];
+   }
+   int64_t sent = (int64_t)threads * count;
+   int64_t dropped = after.dropped - before.dropped;
+   if (total + dropped != sent) {
+      errors++;
+   }
+
+   cout << endl;
+   cout << "insert() on port " << port << ": " << threads << " threads"
+        << endl;
+   cout << "Messages sent:     " << sent << endl;
+   cout << "Messages received: " << total << endl;
+   cout << "Messages dropped:  " << dropped << endl;
+   cout << "Other messages:    " << other << endl;
+   cout << "Errors:            " << errors << endl;
+   cout << "Time:              " << elapsed / 1000000.0 << " ms" << endl;
+   return errors;
+}
+
+
+
+//////////////////////////////
+//
+// testRing -- pass count numbers through an SpscBuffer of the given
+//     size from a producer thread to this thread.  Returns the number
+//     of errors.
+//
+
+int testRing(int count, int size) {
+   ring = new SpscBuffer<int>(size);
+   ringCount = count;
+
+   pthread_t thread;
+   int64_t start = SigTimer::getMonotonicTime();
+   if (pthread_create(&thread, NULL, produce, NULL) != 0) {
+      cout << "Error: cannot start producer thread" << endl;
+      exit(1);
+   }
+
+   int items[BULK_SIZE];
+   int errors = 0;
+   int expected = 0;
+   int64_t extractCalls = 0;
+   int64_t emptyCalls = 0;
+   int extracted, level, j;
+   while (expected < count) {
+      level = ring->getCount();
+      if (level < 0 || level > ring->getSize()) {
+         errors++;
+      }
+      // alternate between single and bulk extraction
+      if (extractCalls & 1) {
+         extracted = ring->extract(items, BULK_SIZE);
+      } else {
+         extracted = ring->extract(items[0]);
+      }
+      extractCalls++;
+      if (extracted == 0) {
+         emptyCalls++;
+         sched_yield();
+         continue;
+      }
+      for (j=0; j<extracted; j++) {
+         if (items[j] != expected) {
+            errors++;
+            expected = items[j];
+         }
+         expected++;
+      }
+   }
+   int64_t elapsed = SigTimer::getMonotonicTime() - start;
+   pthread_join(thread, NULL);
+   if (ring->getCount() != 0) {
+      errors++;
+   }
+
+   cout << "SpscBuffer of size " << ring->getSize() << endl;
+   cout << "Items passed:      " << count << endl;
+   cout << "Extract calls:     " << extractCalls << " (" << emptyCalls
+        << " empty)" << endl;
+   cout << "Errors:            " << errors << endl;
+   cout << "Time:              " << elapsed / 1000000.0 << " ms ("
+        << (double)elapsed / count << " ns per item)" << endl;
+
+   delete ring;
+   ring = NULL;
+   return errors;
+}
+
+
+
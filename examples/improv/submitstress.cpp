@@ -0,0 +1,202 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sun Oct 18 00:41:27 PDT 2026
+// Last Modified: Sun Oct 18 00:41:27 PDT 2026
+// Filename:      ...sig/doc/examples/improv/improv/submitstress.cpp
+// Syntax:        C++; improv
+//
+// Description:   Stress test of EventBuffer::submit().  Several producer
+//                threads submit FunctionEvents as fast as they can while
+//                the main thread runs xcheck() on the buffer.  Each event
+//                carries the number of its producer and its place in the
+//                sequence of that producer, and when it acts it checks
+//                that every event from the producer arrives exactly once
+//                and in order.  A producer tries again when the queue is
+//                full, so every event must arrive.  The program exits
+//                with a status of 1 if an event is lost, repeated or out
+//                of order.  It can be compiled with -fsanitize=thread to
+//                look for data races.  No MIDI port is needed.
+//
+
+#include "sigControl.h"
+#include <stdlib.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include <atomic>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+// the state of one producer thread
+struct Producer {
+   int                number;
+   int                count;          // events to submit
+   EventBuffer*       buffer;
+   std::atomic<int>   done;
+};
+
+int   atohd(const char* aNumber);
+void  check(FunctionEvent& p, EventBuffer& midiOutput);
+void  exitUsage(const char* command);
+void* produce(void* x);
+
+vector<int> nextEvent;                // next sequence number of each producer
+int64_t     received = 0;
+int64_t     errors   = 0;
+
+
+int main(int argc, char* argv[]) {
+   int producers = 8;
+   int count     = 100000;
+   int queueSize = 256;
+   if (argc > 4) {
+      exitUsage(argv[0]);
+   }
+   if (argc > 1) producers = atohd(argv[1]);
+   if (argc > 2) count     = atohd(argv[2]);
+   if (argc > 3) queueSize = atohd(argv[3]);
+   if (producers < 1 || count < 1 || queueSize < 1) {
+      exitUsage(argv[0]);
+   }
+
+   EventBuffer buffer(1024, queueSize);
+   nextEvent.assign(producers, 0);
+
+   vector<Producer> producer(producers);
+   vector<pthread_t> thread(producers);
+   int i;
+   for (i=0; i<producers; i++) {
+      producer[i].number  = i;
+      producer[i].count   = count;
+      producer[i].buffer  = &buffer;
+      producer[i].done.store(0);
+   }
+   int64_t start = SigTimer::getMonotonicTime();
+   for (i=0; i<producers; i++) {
+      if (pthread_create(&thread[i], NULL, produce, &producer[i]) != 0) {
+         cout << "Error: cannot start producer thread " << i << endl;
+         exit(1);
+      }
+   }
+
+   // the owner thread: keep running the buffer until every producer has
+   // finished and the queue has been emptied
+   int64_t expected = (int64_t)producers * count;
+   long tick = 0;
+   int finished = 0;
+   while (received < expected) {
+      finished = 1;
+      for (i=0; i<producers; i++) {
+         if (!producer[i].done.load(std::memory_order_acquire)) {
+            finished = 0;
+            break;
+         }
+      }
+      buffer.xcheck(tick++);
+      if (finished) {
+         // everything had been submitted, so that xcheck() got it all
+         break;
+      }
+   }
+   int64_t elapsed = SigTimer::getMonotonicTime() - start;
+
+   for (i=0; i<producers; i++) {
+      pthread_join(thread[i], NULL);
+   }
+
+   EventBufferStatistics stats;
+   buffer.getStatistics(stats);
+
+   cout << "Producers:       " << producers << endl;
+   cout << "Queue size:      " << queueSize << endl;
+   cout << "Events received: " << received << " of " << expected << endl;
+   cout << "Errors:          " << errors << endl;
+   cout << "Queue full:      " << stats.dropped << " times" << endl;
+   cout << "Ticks:           " << tick << endl;
+   cout << "Time:            " << elapsed / 1000000.0 << " ms ("
+        << (double)elapsed / expected << " ns per event)" << endl;
+   cout << "Buffer:          " << stats.size << " spaces, peak "
+        << stats.peak << endl;
+
+   return (errors == 0 && received == expected) ? 0 : 1;
+}
+
+
+
+int atohd(const char* aNumber) {
+   if (aNumber[0] == '0' && tolower(aNumber[1]) == 'x') {
+      return (int)strtol(aNumber, (char**)NULL, 16);
+   } else {
+      return atoi(aNumber);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// check -- the function of each submitted event, which is run by the
+//     owner thread.  intValue(8) is the producer and intValue(12) is
+//     the place of the event in the sequence of the producer.
+//
+
+void check(FunctionEvent& p, EventBuffer& midiOutput) {
+   int number = p.intValue(8);
+   int sequence = p.intValue(12);
+   if (number < 0 || number >= (int)nextEvent.size()) {
+      errors++;
+   } else if (sequence != nextEvent[number]) {
+      errors++;
+      nextEvent[number] = sequence + 1;
+   } else {
+      nextEvent[number]++;
+   }
+   received++;
+   p.off(midiOutput);
+}
+
+
+
+void exitUsage(const char* command) {
+   cout << endl;
+   cout << "Submits events to an EventBuffer from several threads\n";
+   cout << "and checks that they all arrive in order.\n";
+   cout << endl;
+   cout << "Usage: " << command << " [producers [events [queue-size]]]\n";
+   cout << endl;
+   cout << "   producers  = number of producer threads, default is 8.\n";
+   cout << "   events     = events from each producer, default is 100000.\n";
+   cout << "   queue-size = size of the submit() queue, default is 256.\n";
+   cout << endl;
+   exit(1);
+}
+
+
+
+//////////////////////////////
+//
+// produce -- submit the events of one producer, trying again whenever
+//     the queue is full.
+//
+
+void* produce(void* x) {
+   Producer& producer = *((Producer*)x);
+   FunctionEvent event;
+   event.setFunction(check);
+   event.setOnTime(0);
+   event.intValue(8) = producer.number;
+   for (int i=0; i<producer.count; i++) {
+      event.intValue(12) = i;
+      event.activate();
+      while (!producer.buffer->submit(event)) {
+         sched_yield();
+      }
+   }
+   producer.done.store(1, std::memory_order_release);
+   return NULL;
+}
+
+
+
@@ -2,6 +2,7 @@
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: 4 January 1998
 // Last Modified: Mon Nov 23 16:37:22 PST 1998
+// Last Modified: Sun Oct 18 10:05:31 PDT 2026 (1 ms idle period)
 // Filename:      ...sig/doc/examples/improv/synthImprov/loop1/loop1.cpp
 // Syntax:        C++; synthImprov 2.0
 //  
@@ -62,6 +63,7 @@ void description(void) {
 
 
 void initialization(void) { 
+   eventIdler.setPeriod(1.0);   // the beat timers are polled
    cout << "How many beats in the loop: ";
    echoKeysOn();
    cin  >> beats;
@@ -2,6 +2,7 @@
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: 4 January 1998
 // Last Modified: Fri Jan  9 18:30:17 GMT-0800 1998
+// Last Modified: Sun Oct 18 10:05:31 PDT 2026 (1 ms idle period)
 // Filename:      ...sig/doc/examples/improv/synthImprov/loop2/loop2.cpp
 // Syntax:        C++; synthImprov 2.0
 //  
@@ -79,6 +80,7 @@ void zero(void) {
 
 
 void initialization(void) { 
+   eventIdler.setPeriod(1.0);   // the beat timers are polled
    int inst;
 
    cout << "How many beats in the loop: ";
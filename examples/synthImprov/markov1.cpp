@@ -2,6 +2,7 @@
 // Programmer:    Leland Stanford, Jr. <leland@stanford.edu>
 // Creation Date: Wed May 12 00:18:31 PDT 1999
 // Last Modified: Wed May 12 01:47:06 PDT 1999
+// Last Modified: Sun Oct 18 10:05:31 PDT 2026 (1 ms idle period)
 // Filename:      .../improv/examples/synthImprov/markov1/markov1.cpp
 // Syntax:        C++; Visual C++ 6.0; synthImprov
 //  
@@ -100,6 +101,7 @@ void description(void) {
 //
 
 void initialization(void) { 
+   eventIdler.setPeriod(1.0);   // the beat timers are polled
    markovVoice.pc(0);
    markovVoice.setChannel(0);
    metronome.setTempo(60);
@@ -3,6 +3,7 @@
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Wed May  5 21:42:45 PDT 1999
 // Last Modified: Sun May  9 14:49:50 PDT 1999
+// Last Modified: Sun Oct 18 10:05:31 PDT 2026 (1 ms idle period)
 // Filename:      ...sig/doc/examples/all/nana1/nana1.cpp
 // Syntax:        C++; synthImprov 2.1; sigNet 1.0
 //  
@@ -107,6 +108,7 @@ void description(void) {
 //
 
 void initialization(void) { 
+   eventIdler.setPeriod(1.0);   // the beat timers are polled
    cout << "Enter a tempo for melody performance: ";
    echoKeysOn();
    cin  >> tempo;
@@ -4,6 +4,7 @@
 // Creation Date: Wed May  5 21:42:45 PDT 1999
 // Last Modified: Mon May 10 22:29:39 PDT 1999
 // Last Modified: Tue May 18 17:31:56 PDT 1999
+// Last Modified: Sun Oct 18 10:05:31 PDT 2026 (1 ms idle period)
 // Filename:      ...sig/doc/examples/all/nana2/nana2.cpp
 // Syntax:        C++; synthImprov 2.1; sigNet 1.0
 //  
@@ -137,6 +138,7 @@ void description(void) {
 //
 
 void initialization(void) { 
+   eventIdler.setPeriod(1.0);   // the beat timers are polled
  
    cout << "Enter a tempo for melody performance: ";
    echoKeysOn();
@@ -3,6 +3,7 @@
 // Creation Date: Mon Oct 26 17:00:30 PST 1998
 // Last Modified: Wed Oct 28, 1998
 // Last Modified: Fri Jun 25 16:38:47 PDT 1999
+// Last Modified: Sun Oct 18 10:05:31 PDT 2026 (1 ms idle period)
 // Filename:      ...sig/doc/examples/improv/synthImprov/position2/position2.cpp
 // Syntax:        C++; synthImprov 2.0
 //  
@@ -121,6 +122,7 @@ void description(void) {
 //
 
 void initialization(void) { 
+   eventIdler.setPeriod(1.0);   // the beat timers are polled
    sensor.initialize(gargv);    // start CVIRTE stuff for NIDAQ Card
    sensor.setPollPeriod(1);     // check for new data every 1 millisecond   
    sensor.setBufferSize(8);     // buffer size of transfer frame
@@ -2,6 +2,7 @@
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sun May 16 12:54:28 PDT 1999
 // Last Modified: Sun May 31 19:49:53 EDT 2009 (added alternative weights)
+// Last Modified: Sun Oct 18 10:05:31 PDT 2026 (1 ms idle period)
 // Filename:      .../improv/examples/synthImprov/rtkey/rtkey.cpp
 // Syntax:        C++; synthImprov 2.1
 //  
@@ -153,6 +154,7 @@ void description(void) {
 //
 
 void initialization(void) { 
+   eventIdler.setPeriod(1.0);   // the beat timers are polled
    tempo = 60.0;                    // tempo of analysis playback 
    analysisDuration = 7.0;          // duration in seconds of analysis window
    metronome.setTempo(tempo);
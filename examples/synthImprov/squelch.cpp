@@ -2,6 +2,7 @@
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Tue Nov 19 17:59:51  2002
 // Last Modified: Tue Nov 19 17:59:54  2002
+// Last Modified: Sat Oct 17 14:58:33 PDT 2026 (filter non-note input)
 // Filename:      ...sig/doc/examples/improv/synthImprov/squelch.cpp
 // Syntax:        C++; synthImprov 2.0
 //  
@@ -54,6 +55,11 @@ void initialization(void) {
    memory.reset();
    mintime = 48;   // minimum delta time
    maxtime = 180;   // maximum delta time
+
+   // only notes are examined, so don't buffer any other messages
+   for (int command=0xa0; command<=0xe0; command+=0x10) {
+      synth.getFilter().setChannel(command, -1, 0);
+   }
    description();
 }
 
@@ -2,6 +2,8 @@
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Sun Dec 19 13:52:11 PST 1999
 // Last Modified: Wed Jan 12 15:21:15 PST 2000
+// Last Modified: Sat Oct 17 20:41:18 PDT 2026 (added output pacing)
+// Last Modified: Sun Oct 18 10:05:31 PDT 2026 (1 ms idle period)
 // Filename:      ...improv/examples/synthImprov/testgliss.cpp
 // Syntax:        C++; synthImprov 2.0
 //
@@ -22,6 +24,11 @@
 //              the program will send out the MIDI command [0xaa 0x7f
 //              0x00] and stop sending out the glissando data.
 //           
+//              The "p" key toggles pacing of the output to the speed
+//              of a MIDI cable, so that a glissando which is faster
+//              than the cable waits in the program rather than in the
+//              driver.
+//
 //              There are also some neat ideas for controlling
 //              glissandos in this program.
 //
@@ -46,6 +53,7 @@ int      note = lowestnote;  // current note being played in the glissando
 int      notestate = -1;     // note is either on=1, or off=0.
 int      direction = 1;      // 1=gliss going up, -1 = gliss going down
 int      step = 1;           // half-note step amount
+int      pacing = 0;         // boolean for pacing output to cable speed
 
 int      comparestate = 0;   // boolean for comparing input to output MIDI
 uchar    checkin[3]   = {0}; // temporary comparison storage for MIDI input 
@@ -79,6 +87,7 @@ void description(void) {
    psl("     \"5\" = lower step.              \"6\" = raise step. ");
    psl("     \"-\" = lower top of range.      \"=\" = raise top of range. ");
    psl("     \"u\" = gliss up.                \"d = gliss down.  ");
+   psl("     \"p\" = toggle output pacing. ");
    psl(" ");
    psl(" Type 'h' for more information  ");
    printboxbottom();
@@ -86,6 +95,7 @@ void description(void) {
 
 
 void initialization(void) { 
+   eventIdler.setPeriod(1.0);   // the beat timers are polled
    notetimer.setPeriod(period); // set the period in ms between MIDI events.
    notetimer.reset();
 
@@ -276,6 +286,17 @@ void keyboardchar(int key) {
             cout << "highestnote note set to: " << highestnote << endl;
          }
          break;
+      case 'p':        // toggle pacing of output to cable speed
+         pacing = !pacing;
+         synth.setPacing(pacing);
+         if (pacing) {
+            cout << "Output paced to " << MIDI_WIRE_BYTES_PER_SECOND 
+                 << " bytes/second, current latency: " 
+                 << synth.getPacingLatency() / 1000000.0 << " ms" << endl;
+         } else {
+            cout << "Output pacing off" << endl;
+         }
+         break;
       case ' ':       // toggle sending/comparing of data
          if (comparestate) {
             stop();
@@ -2,6 +2,7 @@
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Mon Oct 15 14:46:35 PDT 2001
 // Last Modified: Wed Oct 17 20:30:37 PDT 2001
+// Last Modified: Sun Oct 18 01:20:55 PDT 2026 ("k" stops newest algorithm)
 // Filename:      ...sig/doc/examples/improv/synthImprov/tumble/tumble.cpp
 // Syntax:        C++; synthImprov 2.0
 //
@@ -90,6 +91,7 @@ int anticipation = 125;   // anticipation of first note in tumble for
                           // Value is in milliseconds.
 double tolerance = 0.90;  // allowable trigger rhythm tolerance.
 vector<TumbleParameters> tparam;  // data storage for tumble functions
+int newest = -1;          // parameter location of the newest algorithm
 
 
 // function declarations:
@@ -136,6 +138,7 @@ static void TumbleNoteFunction(FunctionEvent& p, EventBuffer& midiOutput) {
    note.setVel(param.v[param.pos]);
    note.setChan(p.getChan());
    note.setKey(newnote);
+   note.setGroup(p.getGroup()); // cancelled with the algorithm
    note.activate();
    note.action(midiOutput);     // start right now, avoiding any buffer delay
    midiOutput.insert(note);     // store the note for turning off later
@@ -165,6 +168,7 @@ void description(void) {
    "     \"-\" = decrease seq.   \"=\" = increase seq.   \"\\\" = change "
                                                                   "direction");
    psl("      \"0\"-\"9\" = octave number of computer keyboard notes");
+   psl("      \"k\" = stop the newest algorithm and its sounding notes");
    psl("      Notes:           s   d      g    h   j   ");
    psl("                     z   x   c   v   b   n   m  ");
    printboxbottom();
@@ -348,6 +352,7 @@ int startAlgorithm(TumbleParameters& p) {
    tn.setKeyno(0);
    tn.setVelocity(0);
    tn.charValue(0) = (char)ploc;         // store location of the parameters
+   tn.setGroup(ploc + 1);                // group of the algorithm's events
    tn.setStatus(EVENT_STATUS_ACTIVE);
    tn.setOnTime(t_time + p.i[0] - anticipation);
 
@@ -361,6 +366,7 @@ int startAlgorithm(TumbleParameters& p) {
    cout << " ioi: " << p.i[0];
    cout << endl;
 
+   newest = ploc;
    return eventBuffer.insert(tn);
 }
 
@@ -412,6 +418,14 @@ void keyboardchar(int key) {
             cout << "Down" << endl;
          }
          break;
+      case 'k':                       // stop the newest algorithm
+         if (newest >= 0 && tparam[newest].active) {
+            tparam[newest].active = 0;
+            cout << "Stopped algorithm: "
+                 << eventBuffer.cancelGroup(newest + 1) << " events" << endl;
+         }
+         newest = -1;
+         break;
       case 'r':                       // random direction to current algorithms
          randomizeDirections(tparam);
          cout << "Random directions" << endl;
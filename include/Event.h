@@ -3,6 +3,7 @@
 // Creation Date: Fri Sep  5 21:34:57 GMT-0800 1997
 // Last Modified: Fri Sep  5 21:34:58 GMT-0800 1997
 // Last Modified: Sun Jun 11 14:26:51 PDT 2000 (added floatValue() function)
+// Last Modified: Sat Oct 17 23:58:12 PDT 2026 (no virtual calls on stored events)
 // Filename:      ...sig/src/control/Event/Event.h
 // Web Address:   http://www-ccrma.stanford.edu/~craig/improv/include/Event.h
 // Syntax:        C++ 
@@ -109,6 +110,8 @@ class Event {
 
 
       void          printBits      (uchar aByte, ostream& output = cout) const;
+
+   friend class EventBuffer;
 };
     
 
@@ -5,12 +5,66 @@
 // Last Modified: Mon Feb 16 22:17:30 GMT-0800 1998
 // Last Modified: Wed Sep 30 13:48:15 PDT 1998
 // Last Modified: Sat Jun 13 21:16:29 PDT 2009 (check --> xcheck for OSX)
+// Last Modified: Sat Oct 17 22:47:05 PDT 2026 (events kept in a heap)
+// Last Modified: Sat Oct 17 23:21:40 PDT 2026 (storage grows in chunks)
+// Last Modified: Sat Oct 17 23:58:12 PDT 2026 (dispatch on the type byte)
+// Last Modified: Sun Oct 18 00:41:27 PDT 2026 (submit() from any thread)
+// Last Modified: Sun Oct 18 01:20:55 PDT 2026 (cancel and move event groups)
+// Last Modified: Sun Oct 18 10:05:31 PDT 2026 (getWaitTime)
 // Filename:      ...sig/src/control/EventBuffer/EventBuffer.h
 // Web Address:   http://sig.sapp.org/include/sig/EventBuffer.h
 // Syntax:        C++ 
 //
 // Description:   A storage and performance class that holds notes,
 //                etc. until a certain time when they are performed.
+//                The active events are kept in a binary heap ordered
+//                by action time, so xcheck() only looks at the events
+//                which are due rather than at every event in the
+//                buffer, and an event which has acted is put back into
+//                the heap in O(log n) time.
+//
+//                Events with the same action time act in the order in
+//                which they were activated.
+//
+//                The heap uses the action time that an event had when
+//                it was activated or when it last acted.  Events which
+//                are reached through operator[] are looked at again at
+//                the next xcheck(), since their times may have been
+//                changed.
+//
+//                Events are stored in chunks of EVENTBUFFER_CHUNK_SIZE
+//                events.  When all of the chunks are full another one
+//                is added, and the events already in the buffer are not
+//                moved, so the indices returned by insert() and aquire()
+//                stay valid for as long as their events are alive.
+//                Chunks above the size given to the constructor or to
+//                setBufferSize() are given back when they become empty
+//                (one empty chunk is kept in reserve).
+//
+//                Only the data of an event is copied into the buffer;
+//                the stored event is a plain Event.  The buffer calls
+//                the action() and off() functions of the derived class
+//                through a table indexed by the type byte of the event
+//                (data[0]), so there is no virtual call for each event.
+//
+//                All of the functions of the buffer must be called by
+//                the thread which owns it (the one calling xcheck()),
+//                except for submit().  Other threads, such as MIDI input
+//                callbacks or worker threads, schedule events with
+//                submit(), which copies the event into a lock-free
+//                queue and never blocks or allocates memory.  The owner
+//                thread moves the submitted events into the buffer at
+//                the start of each xcheck().  If the queue is full the
+//                event is not scheduled and submit() returns 0.
+//
+//                The active events of each group number (Event::setGroup)
+//                are kept in a linked list, so that cancelGroup() and
+//                rescheduleGroup() only visit the events of the group.
+//
+//                getWaitTime() tells an event loop how long it can sleep
+//                before the buffer has something to do, and
+//                getThreadWaitTime() gives the shortest wait of all of
+//                the buffers created by the calling thread.
 //
 
 #ifndef _EVENTBUFFER_H_INCLUDED
@@ -22,21 +76,75 @@
 #include "MidiOutput.h"
 #include "SigTimer.h"
 
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <stdint.h>
+
+
+#define EVENTBUFFER_CHUNK_BITS  (8)
+#define EVENTBUFFER_CHUNK_SIZE  (1 << EVENTBUFFER_CHUNK_BITS)
+#define EVENTBUFFER_CHUNK_MASK  (EVENTBUFFER_CHUNK_SIZE - 1)
+
+// default number of events in the submit() queue (a power of two)
+#define EVENTBUFFER_SUBMIT_SIZE (1024)
+
+
+// usage counts for an event buffer
+struct EventBufferStatistics {
+   int     size;       // number of event spaces allocated
+   int     used;       // event spaces holding an event
+   int     peak;       // most event spaces ever in use at one time
+   int     chunks;     // number of chunks allocated
+   int64_t grown;      // chunks added because the buffer was full
+   int64_t released;   // empty chunks given back
+   int64_t submitted;  // events taken from the submit() queue
+   int64_t dropped;    // submitted events lost because the queue was full
+};
+
+
+// EVENTBUFFER_CHUNK_SIZE events of storage
+class _EBChunk {
+   public:
+      Event     events[EVENTBUFFER_CHUNK_SIZE];
+      int       heapPosition[EVENTBUFFER_CHUNK_SIZE];  // -1 = not active
+      char      touchedQ[EVENTBUFFER_CHUNK_SIZE];      // in touchedList
+      int       freeList[EVENTBUFFER_CHUNK_SIZE];      // free spaces
+      int       freeCount;                             // size of freeList
+      int       groupOf[EVENTBUFFER_CHUNK_SIZE];       // -1 = in no list
+      int       groupNext[EVENTBUFFER_CHUNK_SIZE];     // next in group
+      int       groupPrev[EVENTBUFFER_CHUNK_SIZE];     // previous in group
+};
+
 
-class _EBPrivate {
+// an event waiting in the submit() queue
+class _EBQueueCell {
    public:
-      int last;
-      int next;
+      std::atomic<uint64_t> sequence;
+      uchar     data[32];                // the data of the Event
+};
+
+
+// an active event in the heap
+class _EBHeapEntry {
+   public:
+      int time;                    // action time of the event
+      int index;                   // location of the event in storage
+      unsigned int order;          // activation order, for equal times
 };
 
 
 class EventBuffer : public MidiOutput {
    public:
-                EventBuffer        (int bufferSize = 1024);
+                EventBuffer        (int bufferSize = 1024,
+                                    int submitSize = EVENTBUFFER_SUBMIT_SIZE);
                ~EventBuffer        (void);
 
       int       aquire             (void);
       void      activate           (int);
+      int       cancelGroup        (int aGroup);
+      void      dispatchAction     (Event& anEvent);
+      void      dispatchOff        (Event& anEvent);
       void      xcheck             (void);
       void      xcheck             (long currentTime);
       int       checkPoll          (void);
@@ -44,27 +152,96 @@ class EventBuffer : public MidiOutput {
       int       getBufferSize      (void) const;
       int       getFreeCount       (void) const;
       int       getPollPeriod      (void); 
+      void      getStatistics      (EventBufferStatistics& stats) const;
+      double    getWaitTime        (void);
+      void      clearStatistics    (void);
       int       insert             (const Event* anEvent);
       int       insert             (const Event& anEvent);
       void      off                (void);
       Event&    operator[]         (int anIndex);
       void      print              (void) const;
+      int       rescheduleGroup    (int aGroup, int delta);
       void      reset              (void);
       void      setBufferSize      (int);
       void      setPollPeriod      (double aPeriod);
+      int       submit             (const Event* anEvent);
+      int       submit             (const Event& anEvent);
+
+      static double getThreadWaitTime(void);
 
 
    protected:
-      Event*              eventStorage;     // ptr to Event storage location
-      int                 storageSize;      // max num of elements in storage
-      _EBPrivate*         eventList;        // list of events to play
-      CircularBuffer<int> freeSlots;        // free event spaces in storage
+      _EBChunk**          chunks;           // event storage, NULL = released
+      int                 chunkCount;       // number of places in chunks
+      int                 minChunks;        // chunks which are never released
+      int                 allocatedChunks;  // chunks which are not NULL
+      int                 emptyChunks;      // allocated chunks with no events
+      int                 firstFree;        // no free spaces before this chunk
+      int                 freeCount;        // free spaces in all chunks
+      int                 listSize;         // size of the heap and lists
+      _EBHeapEntry*       eventHeap;        // active events by action time
+      int                 heapCount;        // number of events in heap
+      _EBHeapEntry*       dueList;          // events acting in xcheck()
+      unsigned int        activationCount;  // for the order of new events
+      int*                touchedList;      // events reached by operator[]
+      int                 touchedCount;     // number of events in touchedList
+      int                 usedPeak;         // for statistics
+      int64_t             grownCount;       // for statistics
+      int64_t             releasedCount;    // for statistics
+      _EBQueueCell*       submitQueue;      // events from submit()
+      int                 submitSize;       // cells in submitQueue
+      std::atomic<uint64_t> submitTail;     // next cell for submit()
+      uint64_t            submitHead;       // next cell for xcheck()
+      std::atomic<int64_t> submitDropped;   // for statistics
+      int64_t             submittedCount;   // for statistics
+      int*                groupHeads[256];  // first event of each group,
+                                            // in blocks of 256 groups
       SigTimer            pollTimer;        // for period checking of poll
       SigTimer            timer;            // for getting current time
+      std::thread::id     ownerThread;      // thread which created buffer
+      EventBuffer*        nextBuffer;       // for getThreadWaitTime()
+
+      static EventBuffer* bufferList;       // all buffers, newest first
+      static std::mutex   bufferListLock;   // for bufferList and nextBuffer
 
 
    // private functions:
+      int       addChunk         (void);
+      int       allocateEvent    (void);
+      void      freeEvent        (int index);
+      int       groupFirst       (int aGroup) const;
+      void      groupLink        (int index);
+      void      groupUnlink      (int index);
+      void      drainSubmitted   (void);
+      void      heapInsert       (const _EBHeapEntry& entry);
+      void      heapRemove       (int position);
+      void      heapUpdate       (int position, int time);
+      void      releaseChunk     (int chunk);
+      void      releaseEmptyChunks(void);
       void      removeEvent      (int index);
+      void      siftDown         (int position);
+      void      siftUp           (int position);
+      void      updateTouched    (void);
+      int       validIndex       (int index) const;
+
+      Event&    eventAt          (int index) const {
+                   return chunks[index >> EVENTBUFFER_CHUNK_BITS]->
+                         events[index & EVENTBUFFER_CHUNK_MASK]; }
+      int&      heapPosition     (int index) const {
+                   return chunks[index >> EVENTBUFFER_CHUNK_BITS]->
+                         heapPosition[index & EVENTBUFFER_CHUNK_MASK]; }
+      char&     touchedQ         (int index) const {
+                   return chunks[index >> EVENTBUFFER_CHUNK_BITS]->
+                         touchedQ[index & EVENTBUFFER_CHUNK_MASK]; }
+      int&      groupOf          (int index) const {
+                   return chunks[index >> EVENTBUFFER_CHUNK_BITS]->
+                         groupOf[index & EVENTBUFFER_CHUNK_MASK]; }
+      int&      groupNext        (int index) const {
+                   return chunks[index >> EVENTBUFFER_CHUNK_BITS]->
+                         groupNext[index & EVENTBUFFER_CHUNK_MASK]; }
+      int&      groupPrev        (int index) const {
+                   return chunks[index >> EVENTBUFFER_CHUNK_BITS]->
+                         groupPrev[index & EVENTBUFFER_CHUNK_MASK]; }
 
 };
 
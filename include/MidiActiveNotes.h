@@ -0,0 +1,54 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 19:27:03 PDT 2026
+// Last Modified: Sat Oct 17 19:27:03 PDT 2026
+// Filename:      ...sig/maint/code/control/MidiOutput/MidiActiveNotes.h
+// Web Address:   http://sig.sapp.org/include/sig/MidiActiveNotes.h
+// Syntax:        C++11
+//
+// Description:   Keeps track of the notes which are sounding on a MIDI
+//                output port, so that they can be turned off without
+//                sending a note off for every key on every channel.
+//                Each channel/key has a count of the note-ons which
+//                have not been matched by a note-off, and each channel
+//                has a count of its sounding keys so that silent
+//                channels can be skipped.  The counts are atomic, so
+//                a thread which queues timed output can update them
+//                while the main thread is reading them.
+//
+
+#ifndef _MIDIACTIVENOTES_H_INCLUDED
+#define _MIDIACTIVENOTES_H_INCLUDED
+
+#include <atomic>
+#include <stdint.h>
+
+typedef unsigned char uchar;
+
+
+class MidiActiveNotes {
+   public:
+                    MidiActiveNotes     (void);
+
+      void          clear               (void);
+      void          clear               (int channel);
+      int           getActiveCount      (void) const;
+      int           getActiveCount      (int channel) const;
+      int           getNoteCount        (int channel, int key) const;
+      int           isSounding          (int channel, int key) const;
+      void          update              (const uchar* data, int size);
+
+   protected:
+      std::atomic<uint8_t> noteCount[16][128]; // unmatched note-ons
+      std::atomic<int>     channelCount[16];   // sounding keys per channel
+      std::atomic<int>     totalCount;         // sounding keys on port
+
+      void          noteOff             (int channel, int key);
+      void          noteOn              (int channel, int key);
+};
+
+
+#endif  /* _MIDIACTIVENOTES_H_INCLUDED */
+
+
+
@@ -0,0 +1,171 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 21:16:52 PDT 2026
+// Last Modified: Sat Oct 17 21:16:52 PDT 2026
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026 (input recording, binary log)
+// Filename:      ...sig/maint/code/control/MidiFileWrite/MidiFileRecorder.h
+// Web Address:   http://sig.sapp.org/include/sig/MidiFileRecorder.h
+// Syntax:        C++11
+//
+// Description:   Records MIDI messages into a Standard MIDI File without
+//                doing any file I/O on the thread which is sending or
+//                receiving the messages.  record() copies each message
+//                with its timestamp into a preallocated ring of cells,
+//                which takes a few atomic operations and never blocks
+//                or allocates memory; if the ring is full the message is
+//                counted as lost.  A background thread takes the
+//                messages out of the ring and encodes them into tracks
+//                in memory, and the file is written by that thread when
+//                the recording is stopped.  The messages can be kept in
+//                one track (a type 0 file), or in a separate track for
+//                each port or for each channel (a type 1 file).
+//                Messages from input and output ports can be recorded
+//                by the same recorder, so that a whole session ends up
+//                in one file on one time line.
+//
+//                Time is in milliseconds from the start of the recording:
+//                1000 ticks per quarter note at 60 beats per minute.
+//                Channel messages and sysex are recorded; real-time and
+//                system common messages have no place in a MIDI file
+//                and are left out.
+//
+//                The recorder can also write a compact binary log
+//                instead of a MIDI file (MIDI_RECORD_LOG).  The log is
+//                written while recording, so it does not grow in memory
+//                during long sessions, and it keeps every message with
+//                microsecond times.  It starts with the four bytes
+//                "MLOG", followed by one record for each message:
+//                   variable-length value: microseconds since the
+//                        previous record (or since the start)
+//                   variable-length value: port * 2, plus 1 for input
+//                   variable-length value: number of bytes in message
+//                   the bytes of the message
+//                Variable-length values are the same as in MIDI files.
+//
+
+#ifndef _MIDIFILERECORDER_H_INCLUDED
+#define _MIDIFILERECORDER_H_INCLUDED
+
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <pthread.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+typedef unsigned char uchar;
+
+// track layouts
+#define MIDI_RECORD_ONE_TRACK  (0)   // type 0 file
+#define MIDI_RECORD_BY_PORT    (1)   // type 1 file, a track for each port
+#define MIDI_RECORD_BY_CHANNEL (2)   // type 1 file, a track for each channel
+#define MIDI_RECORD_LOG        (3)   // binary log, not a MIDI file
+
+// default number of cells in the ring (must be a power of two).  A short
+// message takes one 32-byte cell.
+#define MIDI_RECORD_CELLS      (16384)
+
+
+class MidiFileRecorder {
+   public:
+                    MidiFileRecorder   (int cellCount = MIDI_RECORD_CELLS);
+                   ~MidiFileRecorder   ();
+
+      int64_t       getLostCount       (void) const;
+      int           isRecording        (void) const;
+      void          record             (int port, const uchar* data,
+                                        int size, int64_t timestamp = 0);
+      void          recordInput        (int port, const uchar* data,
+                                        int size, int64_t timestamp = 0);
+      int           start              (const char* filename,
+                                        int trackMode = MIDI_RECORD_ONE_TRACK);
+      int           stop               (void);
+
+   protected:
+      // A message is stored in one or more consecutive cells.  The first
+      // cell holds the timestamp, port, size and the first bytes of the
+      // message, and the following cells hold the rest of the bytes.
+      struct Cell {
+         std::atomic<uint64_t> sequence;
+         uchar      bytes[24];
+      };
+      struct Header {
+         int64_t    time;               // CLOCK_MONOTONIC nanoseconds
+         int16_t    port;
+         uint16_t   size;               // bytes in the message
+         uint8_t    input;              // true if from an input port
+      };
+
+      // one track being encoded by the background thread
+      struct Track {
+         int64_t    lastTick;
+         std::vector<uchar> data;
+      };
+
+      Cell*         cells;
+      int           cellCount;
+      std::atomic<uint64_t> tail;       // next cell for record()
+      uint64_t      head;               // next cell for the thread
+      std::atomic<int> recording;       // true while messages are taken
+      std::atomic<int> running;         // false when the thread should end
+      std::atomic<int64_t> lost;        // messages which did not fit
+      pthread_t     encoderThread;
+
+      // used only by the background thread while recording
+      std::string   filename;
+      int           trackMode;
+      int64_t       startTime;
+      std::map<int, Track> tracks;      // by port or channel
+      std::ofstream logFile;            // for MIDI_RECORD_LOG
+      int64_t       logTime;            // time of the last log record
+      int           writeStatus;        // true if the file was written
+
+      void          addEvent           (int key, int64_t tick,
+                                        const uchar* data, int size);
+      static void   addVLValue         (std::vector<uchar>& data,
+                                        int64_t aValue);
+      int           drain              (void);
+      void          encode             (const Header& header,
+                                        const uchar* data);
+      void          encodeLog          (const Header& header,
+                                        const uchar* data);
+      void          store              (int port, int input,
+                                        const uchar* data, int size,
+                                        int64_t timestamp);
+      int           writeFile          (void);
+
+   friend void *encodeMidiFilePrivate(void* x);
+};
+
+void *encodeMidiFilePrivate(void* x);
+
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// MidiRecorderSlot -- the recorder of a port, which can be changed by
+//     one thread while the input thread of the port records through
+//     it.  set() does not return until the input thread has stopped
+//     using the old recorder, so that it can then be deleted.
+//
+
+class MidiRecorderSlot {
+   public:
+                    MidiRecorderSlot   (void);
+
+      MidiFileRecorder* get            (void) const;
+      void          recordInput        (int port, const uchar* data,
+                                        int size, int64_t timestamp = 0);
+      void          set                (MidiFileRecorder* aRecorder);
+
+   protected:
+      std::atomic<MidiFileRecorder*> recorder;
+      std::atomic<int> users;           // threads using the recorder
+};
+
+
+#endif  /* _MIDIFILERECORDER_H_INCLUDED */
+
+
+
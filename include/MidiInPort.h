@@ -5,6 +5,14 @@
 // Last Modified: Sat Nov  7 16:09:18 PST 1998
 // Last Modified: Tue Jun 29 16:14:50 PDT 1999 (added Sysex input)
 // Last Modified: Tue May 23 23:08:44 PDT 2000 (oss/alsa selection added)
+// Last Modified: Sat Oct 17 11:32:40 PDT 2026 (bulk extract)
+// Last Modified: Sat Oct 17 12:48:09 PDT 2026 (nanosecond timestamps)
+// Last Modified: Sat Oct 17 13:20:37 PDT 2026 (input event descriptor)
+// Last Modified: Sat Oct 17 13:51:02 PDT 2026 (input callbacks)
+// Last Modified: Sat Oct 17 14:22:15 PDT 2026 (sysex pool)
+// Last Modified: Sat Oct 17 14:58:33 PDT 2026 (input filters)
+// Last Modified: Sat Oct 17 15:40:12 PDT 2026 (overflow policies, counters)
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026 (input recording)
 // Filename:      ...sig/maint/code/control/MidiInPort/MidiInPort.h
 // Web Address:   http://sig.sapp.org/include/sig/MidiInPort.h
 // Syntax:        C++ 
@@ -20,6 +28,9 @@
 #define _MIDIINPORT_H_INCLUDED
 
 #include "MidiEvent.h"
+#include "SysexPool.h"
+
+#include <stdint.h>
 
 #ifdef VISUAL
    #define MIDIINPORT  MidiInPort_visual
@@ -54,22 +65,42 @@ class MidiInPort : protected MIDIINPORT {
 
       void        clearSysex(void) { MIDIINPORT::clearSysex(); }
       void        clearSysex(int buffer) { MIDIINPORT::clearSysex(buffer); }
+      void        clearCallback(void) { MIDIINPORT::clearCallback(); }
+      void        clearStatistics(void) { MIDIINPORT::clearStatistics(); }
       void        close(void)        { MIDIINPORT::close(); }
       void        closeAll(void)     { MIDIINPORT::closeAll(); }
       void        extract(smf::MidiEvent& event) { MIDIINPORT::extract(event); }
+      void        extract(smf::MidiEvent& event, int64_t& timestamp) {
+                     MIDIINPORT::extract(event, timestamp); }
+      int         extract(smf::MidiEvent* events, int count, 
+                          int64_t* timestamps = NULL) {
+                     return MIDIINPORT::extract(events, count, timestamps); }
       int         getBufferSize(void) { return MIDIINPORT::getBufferSize(); }
       int         getChannelOffset(void) const { 
                                         return MIDIINPORT::getChannelOffset(); }
       int         getCount(void)     { return MIDIINPORT::getCount(); }
+      MidiInputFilter& getFilter(void) { return MIDIINPORT::getFilter(); }
+      int         getInputEventFd(void) { 
+                     return MIDIINPORT::getInputEventFd(getPort()); }
       const char* getName(void)      { return MIDIINPORT::getName(); }
       static const char* getName(int i)  { return MIDIINPORT::getName(i); }
       static int  getNumPorts(void) { 
                      return MIDIINPORT::getNumPorts(); }
+      int         getOverflowPolicy(void) { 
+                     return MIDIINPORT::getOverflowPolicy(); }
       int         getPort(void)      { return MIDIINPORT::getPort(); }
       int         getPortStatus(void){ 
                      return MIDIINPORT::getPortStatus(); }
+      MidiFileRecorder* getRecorder(void) { 
+                     return MIDIINPORT::getRecorder(); }
+      void        getStatistics(MidiInputStatistics& stats) {
+                     MIDIINPORT::getStatistics(stats); }
       uchar*      getSysex(int buffer) { return MIDIINPORT::getSysex(buffer); }
       int getSysexSize(int buffer) { return MIDIINPORT::getSysexSize(buffer); }
+      int         getSysexOverflowCount(void) { 
+                     return MIDIINPORT::getSysexOverflowCount(); }
+      SysexView   getSysexView(int buffer) { 
+                     return MIDIINPORT::getSysexView(buffer); }
       int         getTrace(void)     { return MIDIINPORT::getTrace(); }
       void        insert(const smf::MidiEvent& aMessage) {
                      MIDIINPORT::insert(aMessage); }
@@ -81,10 +112,18 @@ class MidiInPort : protected MIDIINPORT {
       void        pause(void)        { MIDIINPORT::pause(); }
       void        setBufferSize(int aSize) {
                      MIDIINPORT::setBufferSize(aSize); }
+      void        setCallback(MIDI_Message_function aFunction, 
+                     void* userdata = NULL, int callbackOnly = 0) {
+                     MIDIINPORT::setCallback(aFunction, userdata, 
+                     callbackOnly); }
       void        setChannelOffset(int anOffset) { 
                      MIDIINPORT::setChannelOffset(anOffset); }
+      void        setOverflowPolicy(int aPolicy, int aLimit = 0) {
+                     MIDIINPORT::setOverflowPolicy(aPolicy, aLimit); }
       void        setAndOpenPort(int aPort) { setPort(aPort); open(); }
       void        setPort(int aPort) { MIDIINPORT::setPort(aPort); }
+      void        setRecorder(MidiFileRecorder* aRecorder) {
+                     MIDIINPORT::setRecorder(aRecorder); }
       int         setTrace(int aState) { 
                      return MIDIINPORT::setTrace(aState); }
       void        toggleTrace(void) { MIDIINPORT::toggleTrace(); }
@@ -3,6 +3,16 @@
 // Creation Date: Sun May 14 22:05:27 PDT 2000
 // Last Modified: Sat Oct 13 16:11:24 PDT 2001 (updated for ALSA 0.9)
 // Last Modified: Sat Nov  2 20:35:50 PST 2002 (added #ifdef ALSA)
+// Last Modified: Sat Oct 17 11:04:18 PDT 2026 (one epoll thread for all ports)
+// Last Modified: Sat Oct 17 11:32:40 PDT 2026 (lock-free input buffers)
+// Last Modified: Sat Oct 17 12:05:51 PDT 2026 (use MidiStreamParser)
+// Last Modified: Sat Oct 17 12:48:09 PDT 2026 (nanosecond input timestamps)
+// Last Modified: Sat Oct 17 13:20:37 PDT 2026 (input arrival eventfd)
+// Last Modified: Sat Oct 17 13:51:02 PDT 2026 (input thread callbacks)
+// Last Modified: Sat Oct 17 14:22:15 PDT 2026 (reference-counted sysex pool)
+// Last Modified: Sat Oct 17 14:58:33 PDT 2026 (per-port input filters)
+// Last Modified: Sat Oct 17 15:40:12 PDT 2026 (overflow policies, counters)
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026 (recording in input thread)
 // Filename:      ...sig/maint/code/control/MidiInPort/linux/MidiInPort_alsa.h
 // Web Address:   http://sig.sapp.org/include/sig/MidiInPort_alsa.h
 // Syntax:        C++ 
@@ -18,16 +28,39 @@
 #ifdef LINUX
 #ifdef ALSA
 
-#include "CircularBuffer.h"
+#include "SpscBuffer.h"
+#include "MidiFileRecorder.h"
+#include "MidiInputFilter.h"
+#include "MidiInputStatistics.h"
+#include "SysexPool.h"
 #include "Sequencer_alsa.h"
 #include "SigTimer.h"
 #include "MidiEvent.h"
 
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
 #include <vector>
 #include <pthread.h>
 
 typedef unsigned char uchar;
 typedef void (*MIDI_Callback_function)(int arrivalPort);
+typedef void (*MIDI_Message_function)(const smf::MidiEvent& message,
+      int arrivalPort, void* userdata);
+
+// a callback function registered for an input port
+struct MidiInputCallback {
+   MIDI_Message_function function;
+   void*                 userdata;
+   int                   callbackOnly;   // don't store messages in buffer
+};
+
+// a message in the input buffer, stored together with its arrival time
+// so that the two can never get out of step
+struct MidiInputRecord {
+   smf::MidiEvent        event;
+   int64_t               timestamp;      // CLOCK_MONOTONIC time in ns
+};
 
 
 class MidiInPort_alsa : public Sequencer_alsa {
@@ -36,21 +69,36 @@ class MidiInPort_alsa : public Sequencer_alsa {
                       MidiInPort_alsa             (int aPort, int autoOpen = 1);
                      ~MidiInPort_alsa             ();
 
+      void            clearCallback              (void);
       void            clearSysex                 (int buffer);
       void            clearSysex                 (void);
+      void            clearStatistics            (void);
       void            close                      (void);
       void            closeAll                   (void);
       void            extract                    (smf::MidiEvent& event);
+      void            extract                    (smf::MidiEvent& event,
+                                                  int64_t& timestamp);
+      int             extract                    (smf::MidiEvent* events,
+                                                  int count,
+                                                  int64_t* timestamps = NULL);
       int             getBufferSize              (void);
       int             getChannelOffset           (void) const;
       int             getCount                   (void);
+      MidiInputFilter& getFilter                 (void);
+      static int      getInputEventFd            (int aPort);
+      static int      getInputThreadCount        (void);
       const char*     getName                    (void);
       static const char* getName                 (int i);
       static int      getNumPorts                (void);
+      int             getOverflowPolicy          (void);
       int             getPort                    (void);
       int             getPortStatus              (void);
+      MidiFileRecorder* getRecorder              (void);
+      void            getStatistics              (MidiInputStatistics& stats);
       uchar*          getSysex                   (int buffer);
+      int             getSysexOverflowCount      (void);
       int             getSysexSize               (int buffer);
+      SysexView       getSysexView               (int buffer);
       int             getTrace                   (void);
       void            insert                     (const smf::MidiEvent& aMessage);
       int             installSysex               (uchar* anArray, int aSize);
@@ -58,18 +106,44 @@ class MidiInPort_alsa : public Sequencer_alsa {
       int             open                       (void);
       void            pause                      (void);
       void            setBufferSize              (int aSize);
+      void            setCallback                (MIDI_Message_function aFunction,
+                                                  void* userdata = NULL,
+                                                  int callbackOnly = 0);
       void            setChannelOffset           (int anOffset);
+      static void     setInputThreadCount        (int aCount);
+      void            setOverflowPolicy          (int aPolicy, 
+                                                  int aLimit = 0);
       void            setPort                    (int aPort);
+      void            setRecorder                (MidiFileRecorder* aRecorder);
       int             setTrace                   (int aState);
       void            toggleTrace                (void);
       void            unpause                    (void);
 
-      static vector<int> threadinitport;
+      static vector<int> threadinitport;    // thread index for each thread
 
    protected:
       int    port;     // the port to which this object belongs
+      vector<int> heldSysex; // sysex buffers of the last extracted sysexs
 
       static MIDI_Callback_function  callbackFunction;
+      static std::atomic<MidiInputCallback*>* inputCallback; // for each port
+      static MidiInputFilter* inputFilter;  // messages to buffer for each port
+      static MidiRecorderSlot* inputRecorder; // recorder for each port
+
+      // counters for each port, written only by the input thread
+      struct PortCounters {
+         std::atomic<int64_t> received;     // messages from the parser
+         std::atomic<int64_t> dropped;      // messages lost to overflow
+         std::atomic<int64_t> bytes;        // bytes read from the port
+         std::atomic<int>     peak;         // most messages in the buffer
+      };
+      static PortCounters* inputCounters;
+      static std::atomic<int>* overflowPolicy; // full input buffer behavior
+      static int*       growLimit;          // for MIDI_OVERFLOW_GROW policy
+      static std::mutex* bufferLock;        // for DROP_OLDEST and GROW
+      static std::atomic<int>* inputWriting;   // input thread is in buffer
+      static std::atomic<int>* bufferExclusive; // user threads writing
+      static vector<MidiInputCallback*> oldCallbacks; // freed at deinitialize
 
       static int      installSysexPrivate        (int port, 
                                                     uchar* anArray, int aSize);
@@ -79,18 +153,33 @@ class MidiInPort_alsa : public Sequencer_alsa {
       static int*       trace;              // for verifying input
       static ostream*   tracedisplay;       // stream for displaying trace
       static int        numDevices;         // number of input ports
-      static CircularBuffer<smf::MidiEvent>** midiBuffer; // MIDI storage frm ports
+      static SpscBuffer<MidiInputRecord>** midiBuffer; // MIDI storage frm ports
       static int        channelOffset;      // channel offset, either 0 or 1
                                             // not being used right now.
       static int*       pauseQ;             // for adding items to Buffer or not
       static SigTimer   midiTimer;          // for timing MIDI input
       static vector<pthread_t> midiInThread; // for MIDI input thread function
-      static int*       sysexWriteBuffer;   // for MIDI sysex write location
-      static vector<uchar>** sysexBuffers;   // for MIDI sysex storage
+      static vector<int> inputWakeFd;     // eventfd to wake up input threads
+      static std::atomic<int> inputThreadStop; // tells input threads to exit
+      static vector<int> inputEventFd;    // eventfd signaled on new input
+      static int        inputThreadCount;   // number of input threads to start
+      static SysexPool** sysexPool;         // for MIDI sysex storage
 
    private:
       void            deinitialize               (void); 
       void            initialize                 (void); 
+      void            holdSysex                  (smf::MidiEvent* events,
+                                                  int count);
+      void            releaseSysex               (void);
+      static int      bufferInput                (int device,
+                                                  const smf::MidiEvent& message,
+                                                  int64_t timestamp);
+      static void     storeParsedInput           (const uchar* data, int size,
+                                                  int64_t timestamp,
+                                                  void* userdata);
+      static void     signalInput                (int aPort);
+      static void     stopInputThreads           (void);
+      static void     wakeInputThread            (int aPort);
 
  
    friend void *interpretMidiInputStreamPrivateALSA(void * x);
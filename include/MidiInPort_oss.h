@@ -4,6 +4,9 @@
 // Last Modified: Fri Jan  8 08:34:01 PST 1999
 // Last Modified: Tue Jun 29 16:18:02 PDT 1999 (added sysex capability)
 // Last Modified: Wed May 10 17:10:05 PDT 2000 (name change from _linux to _oss)
+// Last Modified: Sat Oct 17 12:05:51 PDT 2026 (use MidiStreamParser)
+// Last Modified: Sat Oct 17 14:58:33 PDT 2026 (per-port input filters)
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026 (recording in input thread)
 // Filename:      ...sig/maint/code/control/MidiInPort/linux/MidiInPort_oss.h
 // Web Address:   http://sig.sapp.org/include/sig/MidiInPort_oss.h
 // Syntax:        C++ 
@@ -19,15 +22,22 @@
 #ifdef LINUX
 
 #include "CircularBuffer.h"
+#include "MidiFileRecorder.h"
+#include "MidiInputFilter.h"
+#include "MidiInputStatistics.h"
 #include "Array.h"
 #include "Sequencer_oss.h"
 #include "SigTimer.h"
 #include "MidiEvent.h"
+#include "SysexPool.h"
 
+#include <stdint.h>
 #include <pthread.h>
 
 typedef unsigned char uchar;
 typedef void (*MIDI_Callback_function)(int arrivalPort);
+typedef void (*MIDI_Message_function)(const smf::MidiEvent& message,
+      int arrivalPort, void* userdata);
 
 
 class MidiInPort_oss : public Sequencer_oss {
@@ -36,22 +46,35 @@ class MidiInPort_oss : public Sequencer_oss {
                       MidiInPort_oss             (int aPort, int autoOpen = 1);
                      ~MidiInPort_oss             ();
 
+      void            clearCallback              (void) { }
       void            clearSysex                 (int buffer);
       void            clearSysex                 (void);
       void            close                      (void);
       void            close                      (int i) { close(); }
       void            closeAll                   (void);
       void            extract                    (smf::MidiEvent& event);
+      void            extract                    (smf::MidiEvent& event,
+                                                  int64_t& timestamp);
+      int             extract                    (smf::MidiEvent* events,
+                                                  int count,
+                                                  int64_t* timestamps = NULL);
       int             getBufferSize              (void);
       int             getChannelOffset           (void) const;
       int             getCount                   (void);
+      MidiInputFilter& getFilter                 (void);
+      static int      getInputEventFd            (int aPort) { return -1; }
       const char*     getName                    (void);
       static const char* getName                 (int i);
       static int      getNumPorts                (void);
       int             getPort                    (void);
       int             getPortStatus              (void);
+      MidiFileRecorder* getRecorder              (void);
       uchar*          getSysex                   (int buffer);
       int             getSysexSize               (int buffer);
+      // sysex messages are copied, so they are never refused
+      int             getSysexOverflowCount      (void) { return 0; }
+      SysexView       getSysexView               (int buffer) { 
+                                                     return SysexView(); }
       int             getTrace                   (void);
       void            insert                     (const smf::MidiEvent& aMessage);
       int             installSysex               (uchar* anArray, int aSize);
@@ -59,8 +82,23 @@ class MidiInPort_oss : public Sequencer_oss {
       int             open                       (void);
       void            pause                      (void);
       void            setBufferSize              (int aSize);
+      // input callbacks are not supported: messages are buffered as usual
+      void            setCallback                (MIDI_Message_function aFunction,
+                                                  void* userdata = NULL,
+                                                  int callbackOnly = 0) { }
+      // input counters and overflow policies are not supported
+      void            clearStatistics            (void) { }
+      int             getOverflowPolicy          (void) { 
+                                           return MIDI_OVERFLOW_DROP_NEWEST; }
+      void            getStatistics              (MidiInputStatistics& stats) {
+                                           stats.received = stats.dropped = 0;
+                                           stats.bytes = 0; stats.peak = 0;
+                                           stats.size = getBufferSize(); }
+      void            setOverflowPolicy          (int aPolicy, 
+                                                  int aLimit = 0) { }
       void            setChannelOffset           (int anOffset);
       void            setPort                    (int aPort);
+      void            setRecorder                (MidiFileRecorder* aRecorder);
       int             setTrace                   (int aState);
       void            toggleTrace                (void);
       void            unpause                    (void);
@@ -86,10 +124,15 @@ class MidiInPort_oss : public Sequencer_oss {
       static pthread_t  midiInThread;    // for MIDI input thread function
       static int*       sysexWriteBuffer; // for MIDI sysex write location
       static Array<uchar>** sysexBuffers; // for MIDI sysex storage
+      static MidiInputFilter* inputFilter; // messages to buffer for each port
+      static MidiRecorderSlot* inputRecorder; // recorder for each port
 
    private:
       void            deinitialize               (void); 
       void            initialize                 (void); 
+      static void     storeParsedInput           (const uchar* data, int size,
+                                                  int64_t timestamp,
+                                                  void* userdata);
 
  
    friend void *interpretMidiInputStreamPrivate(void * x);
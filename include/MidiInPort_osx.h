@@ -2,6 +2,8 @@
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Thu Jun 11 16:43:04 PDT 2009
 // Last Modified: Thu Jun 11 16:43:12 PDT 2009
+// Last Modified: Sat Oct 17 14:58:33 PDT 2026 (per-port input filters)
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026 (recording in input thread)
 // Filename:      ...sig/maint/code/control/MidiInPort/osx/MidiInPort_osx.h
 // Web Address:   http://sig.sapp.org/include/sig/MidiInPort_osx.h
 // Syntax:        C++ 
@@ -18,13 +20,21 @@
 #if defined(OSXPC) || defined(OSXOLD)
 
 #include "CircularBuffer.h"
+#include "MidiFileRecorder.h"
+#include "MidiInputFilter.h"
+#include "MidiInputStatistics.h"
 #include "Array.h"
 #include "SigTimer.h"
 #include <CoreMIDI/CoreMIDI.h>
 #include "MidiEvent.h"
+#include "SysexPool.h"
+
+#include <stdint.h>
 
 typedef unsigned char uchar;
 typedef void (*MIDI_Callback_function)(int arrivalPort);
+typedef void (*MIDI_Message_function)(const smf::MidiEvent& message,
+      int arrivalPort, void* userdata);
 
 
 class MidiInPort_osx {
@@ -33,22 +43,35 @@ class MidiInPort_osx {
                       MidiInPort_osx             (int aPort, int autoOpen = 1);
                      ~MidiInPort_osx             ();
 
+      void            clearCallback              (void) { }
       void            clearSysex                 (int buffer);
       void            clearSysex                 (void);
       void            close                      (void);
       void            close                      (int i) { close(); }
       void            closeAll                   (void);
       void            extract                    (smf::MidiEvent& event);
+      void            extract                    (smf::MidiEvent& event,
+                                                  int64_t& timestamp);
+      int             extract                    (smf::MidiEvent* events,
+                                                  int count,
+                                                  int64_t* timestamps = NULL);
       int             getBufferSize              (void);
       int             getChannelOffset           (void) const;
       int             getCount                   (void);
+      MidiInputFilter& getFilter                 (void);
+      static int      getInputEventFd            (int aPort) { return -1; }
       const char*     getName                    (void);
       static const char* getName                 (int i);
       static int      getNumPorts                (void);
       int             getPort                    (void);
       int             getPortStatus              (void);
+      MidiFileRecorder* getRecorder              (void);
       uchar*          getSysex                   (int buffer);
       int             getSysexSize               (int buffer);
+      // sysex messages are copied, so they are never refused
+      int             getSysexOverflowCount      (void) { return 0; }
+      SysexView       getSysexView               (int buffer) { 
+                                                     return SysexView(); }
       int             getTrace                   (void);
       void            insert                     (const smf::MidiEvent& aMessage);
       int             installSysex               (uchar* anArray, int aSize);
@@ -56,8 +79,23 @@ class MidiInPort_osx {
       int             open                       (void);
       void            pause                      (void);
       void            setBufferSize              (int aSize);
+      // input callbacks are not supported: messages are buffered as usual
+      void            setCallback                (MIDI_Message_function aFunction,
+                                                  void* userdata = NULL,
+                                                  int callbackOnly = 0) { }
+      // input counters and overflow policies are not supported
+      void            clearStatistics            (void) { }
+      int             getOverflowPolicy          (void) { 
+                                           return MIDI_OVERFLOW_DROP_NEWEST; }
+      void            getStatistics              (MidiInputStatistics& stats) {
+                                           stats.received = stats.dropped = 0;
+                                           stats.bytes = 0; stats.peak = 0;
+                                           stats.size = getBufferSize(); }
+      void            setOverflowPolicy          (int aPolicy, 
+                                                  int aLimit = 0) { }
       void            setChannelOffset           (int anOffset);
       void            setPort                    (int aPort);
+      void            setRecorder                (MidiFileRecorder* aRecorder);
       int             setTrace                   (int aState);
       void            toggleTrace                (void);
       void            unpause                    (void);
@@ -82,6 +120,8 @@ class MidiInPort_osx {
       static SigTimer   midiTimer;       // for timing MIDI input
       static int*       sysexWriteBuffer; // for MIDI sysex write location
       static Array<uchar>** sysexBuffers; // for MIDI sysex storage
+      static MidiInputFilter* inputFilter; // messages to buffer for each port
+      static MidiRecorderSlot* inputRecorder; // recorder for each port
 
    private:
       void            deinitialize               (void); 
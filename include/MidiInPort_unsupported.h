@@ -3,6 +3,7 @@
 // Creation Date: Fri Jan 23 00:04:51 GMT-0800 1998
 // Last Modified: Fri Jan 23 00:04:58 GMT-0800 1998
 // Last Modified: Wed Jun 30 11:42:59 PDT 1999 (added sysex capability)
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026 (recording in input thread)
 // Filename:      ...sig/code/control/MidiInPort/unsupported/MidiInPort_unsupported.h
 // Web Address:   http://www-ccrma.stanford.edu/~craig/improv/include/MidiInPort_unsupported.h
 // Syntax:        C++ 
@@ -20,8 +21,17 @@
 #define _MIDIINPUT_UNSUPPORTED_H_INCLUDED
 
 #include "CircularBuffer.h"
+#include "MidiFileRecorder.h"
+#include "MidiInputFilter.h"
+#include "MidiInputStatistics.h"
 #include "Array.h"
 #include "MidiEvent.h"
+#include "SysexPool.h"
+
+#include <stdint.h>
+
+typedef void (*MIDI_Message_function)(const smf::MidiEvent& message,
+      int arrivalPort, void* userdata);
 
 
 class MidiInPort_unsupported {
@@ -30,31 +40,60 @@ class MidiInPort_unsupported {
                       MidiInPort_unsupported     (int aPort, int autoOpen = 1);
                      ~MidiInPort_unsupported     ();
 
+      void            clearCallback              (void) { }
       void            clearSysex                 (int index) { }
       void            clearSysex                 (void) { }
       int             getSysexSize               (int index) { return 0; }
       unsigned char*  getSysex                   (int buffer) { return NULL; }
+      int             getSysexOverflowCount      (void) { return 0; }
+      SysexView       getSysexView               (int buffer) { 
+                                                     return SysexView(); }
       int             installSysex               (unsigned char *&, int &) { return 0; }
       int             getBufferSize              (void) { return 0; }
+      // input counters and overflow policies are not supported
+      void            clearStatistics            (void) { }
+      int             getOverflowPolicy          (void) { 
+                                           return MIDI_OVERFLOW_DROP_NEWEST; }
+      void            getStatistics              (MidiInputStatistics& stats) {
+                                           stats.received = stats.dropped = 0;
+                                           stats.bytes = 0; stats.peak = 0;
+                                           stats.size = getBufferSize(); }
+      void            setOverflowPolicy          (int aPolicy, 
+                                                  int aLimit = 0) { }
       void            close                      (void);
       void            close                      (int i) { close(); }
       void            closeAll                   (void);
       void            extract                    (smf::MidiEvent& event);
+      void            extract                    (smf::MidiEvent& event,
+                                                  int64_t& timestamp);
+      int             extract                    (smf::MidiEvent* events,
+                                                  int count,
+                                                  int64_t* timestamps = NULL);
       int             getChannelOffset           (void) const;
       int             getCount                   (void);
+      MidiInputFilter& getFilter                 (void) { 
+                                        static MidiInputFilter x; return x; }
+      static int      getInputEventFd            (int aPort) { return -1; }
       const char*     getName                    (void);
       static const char* getName                 (int i);
       int             getNumPorts                (void);
       int             getPort                    (void);
       int             getPortStatus              (void);
+      // input recording is not supported: there is no input thread
+      MidiFileRecorder* getRecorder              (void) { return NULL; }
       int             getTrace                   (void);
       void            insert                     (const smf::MidiEvent& aMessage);
       smf::MidiEvent& message                    (int index);
       int             open                       (void);
       void            pause                      (void);
       void            setBufferSize              (int aSize);
+      // input callbacks are not supported: messages are buffered as usual
+      void            setCallback                (MIDI_Message_function aFunction,
+                                                  void* userdata = NULL,
+                                                  int callbackOnly = 0) { }
       void            setChannelOffset           (int anOffset);
       void            setPort                    (int aPort);
+      void            setRecorder                (MidiFileRecorder* aRecorder) { }
       int             setTrace                   (int aState);
       void            toggleTrace                (void);
       void            unpause                    (void);
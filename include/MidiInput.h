@@ -3,6 +3,10 @@
 // Creation Date: 18 December 1997
 // Last Modified: Sun Jan 25 15:27:02 GMT-0800 1998
 // Last Modified: Thu Apr 20 16:23:24 PDT 2000 (added scale function)
+// Last Modified: Sat Oct 17 11:32:40 PDT 2026 (bulk extract)
+// Last Modified: Sat Oct 17 12:48:09 PDT 2026 (nanosecond timestamps)
+// Last Modified: Sat Oct 17 13:20:37 PDT 2026 (waitForMessage/waitAny)
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026 (recordStart/recordStop)
 // Filename:      ...sig/code/control/MidiInput/MidiInput.h
 // Web Address:   http://sig.sapp.org/include/sig/MidiInput.h
 // Syntax:        C++
@@ -17,6 +21,7 @@
 #define _MIDIINPUT_H_INCLUDED
 
 #include "MidiInPort.h"
+#include "CircularBuffer.h"
 
 
 class MidiInput : public MidiInPort {
@@ -28,11 +33,24 @@ class MidiInput : public MidiInPort {
       int           getBufferSize     (void);
       int           getCount          (void);
       void          extract           (smf::MidiEvent& event);
+      void          extract           (smf::MidiEvent& event,
+                                       int64_t& timestamp);
+      int           extract           (smf::MidiEvent* events, int count,
+                                       int64_t* timestamps = NULL);
+      static int64_t getCurrentTimestamp(void);
+      int64_t       getTimestamp      (void) const;
       void          insert            (const smf::MidiEvent& aMessage);
       int           isOrphan          (void) const;
       void          makeOrphanBuffer  (int aSize = 1024);
+      int           recordStart       (const char* filename,
+                                       int format = MIDI_RECORD_ONE_TRACK);
+      void          recordStart       (MidiFileRecorder& recorder);
+      int           recordStop        (void);
       void          removeOrphanBuffer(void);
       void          setBufferSize     (int aSize);
+      int           waitForMessage    (double timeout = -1.0);
+      static int    waitAny           (MidiInput** inputs, int count,
+                                       double timeout = -1.0);
 
       int           scale             (int value, int min, int max);
       double        fscale            (int value, double min, double max);
@@ -41,6 +59,10 @@ class MidiInput : public MidiInPort {
 
    protected:
       CircularBuffer<smf::MidiEvent>* orphanBuffer;
+      int64_t       lastTimestamp;     // arrival time of last extract (ns)
+      int           inputRecordQ;      // boolean for recording
+      MidiFileRecorder* midiRecorder;  // for recording the input
+      int           midiRecorderOwnerQ; // true if midiRecorder is ours
 
 };
 
@@ -0,0 +1,73 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 14:58:33 PDT 2026
+// Last Modified: Sat Oct 17 14:58:33 PDT 2026
+// Last Modified: Sun Oct 18 11:02:47 PDT 2026 (atomic drop counts)
+// Filename:      ...sig/maint/code/control/MidiInputFilter/MidiInputFilter.h
+// Web Address:   http://sig.sapp.org/include/sig/MidiInputFilter.h
+// Syntax:        C++11
+//
+// Description:   Decides which incoming MIDI messages are stored in the
+//                input buffer of a port.  Channel messages are selected
+//                by a bitmap of message type by channel, controller
+//                messages additionally by controller number, and note
+//                messages (note off, note on, and polyphonic aftertouch)
+//                by a range of key numbers.  System messages are selected
+//                by status byte.  The MIDI input thread calls accept()
+//                for each message before buffering it, so rejected
+//                messages cost no buffer space.  The number of rejected
+//                messages is counted by message type.  By default all
+//                messages are accepted except for MIDI clock (0xf8) and
+//                active sensing (0xfe).
+//
+//                The filter may be changed while MIDI input is running:
+//                each setting is stored atomically, although a message
+//                which arrives while several settings are being changed
+//                may be tested against a mixture of old and new ones.
+//
+
+#ifndef _MIDIINPUTFILTER_H_INCLUDED
+#define _MIDIINPUTFILTER_H_INCLUDED
+
+#include <atomic>
+#include <stdint.h>
+
+typedef unsigned char uchar;
+
+
+class MidiInputFilter {
+   public:
+                    MidiInputFilter    (void);
+                   ~MidiInputFilter    ();
+
+      int           accept             (const uchar* data, int size);
+      void          acceptAll          (void);
+      void          clearDropCounts    (void);
+      int64_t       getDropCount       (void) const;
+      int64_t       getDropCount       (int statusByte) const;
+      void          reset              (void);
+      void          setChannel         (int command, int channel, 
+                                        int state);
+      void          setChannelMask     (int command, int aMask);
+      void          setController      (int controller, int state);
+      void          setNoteRange       (int aLowKey, int aHighKey);
+      void          setSystem          (int statusByte, int state);
+
+   protected:
+      // accepted channels (bit n = channel n) for commands 0x80 to 0xe0
+      std::atomic<uint16_t> channelMask[7];
+      // accepted system messages (bit n = status byte 0xf0 + n)
+      std::atomic<uint16_t> systemMask;
+      // accepted controller numbers (bit n of word n/64)
+      std::atomic<uint64_t> controllerMask[2];
+      // accepted key numbers for 0x80, 0x90 and 0xa0 messages
+      std::atomic<int> lowKey;
+      std::atomic<int> highKey;
+      // rejected messages: 0-6 for channel commands, 7-22 for 0xf0-0xff
+      std::atomic<int64_t> dropCount[23];
+
+      int           drop               (int index);
+};
+
+
+#endif  /* _MIDIINPUTFILTER_H_INCLUDED */
@@ -0,0 +1,35 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 15:40:12 PDT 2026
+// Last Modified: Sat Oct 17 15:40:12 PDT 2026
+// Filename:      ...sig/maint/code/control/MidiInPort/MidiInputStatistics.h
+// Web Address:   http://sig.sapp.org/include/sig/MidiInputStatistics.h
+// Syntax:        C++ 
+//
+// Description:   Overflow policies for MIDI input buffers, and the
+//                counters which are kept for each MIDI input port.
+//                Use the counters to choose a buffer size from the
+//                actual input load of a program.
+//
+
+#ifndef _MIDIINPUTSTATISTICS_H_INCLUDED
+#define _MIDIINPUTSTATISTICS_H_INCLUDED
+
+#include <stdint.h>
+
+// what to do with a new message when the MIDI input buffer is full:
+#define MIDI_OVERFLOW_DROP_NEWEST (0)  /* discard the new message       */
+#define MIDI_OVERFLOW_DROP_OLDEST (1)  /* discard the oldest message    */
+#define MIDI_OVERFLOW_GROW        (2)  /* enlarge buffer up to a limit  */
+#define MIDI_OVERFLOW_BLOCK       (3)  /* wait for space in the buffer  */
+
+struct MidiInputStatistics {
+   int64_t received;   // complete messages read from the port
+   int64_t dropped;    // messages lost because the input buffer was full
+   int64_t bytes;      // bytes read from the port
+   int     peak;       // most messages ever waiting in the input buffer
+   int     size;       // current size of the input buffer
+};
+
+
+#endif  /* _MIDIINPUTSTATISTICS_H_INCLUDED */
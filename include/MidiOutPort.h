@@ -6,6 +6,8 @@
 // Last Modified: Tue May 23 23:08:44 PDT 2000 (oss/alsa selection added)
 // Last Modified: Mon Jun 19 10:32:11 PDT 2000 (oss/alsa define fix)
 // Last Modified: Fri Jun 12 12:38:17 PDT 2009 (added osx)
+// Last Modified: Sat Oct 17 16:21:48 PDT 2026 (output coalescing)
+// Last Modified: Sat Oct 17 16:58:07 PDT 2026 (running status)
 // Filename:      ...sig/code/control/MidiOutPort/MidiOutPort.h
 // Web Address:   http://sig.sapp.org/include/sig/MidiOutPort.h
 // Syntax:        C++ 
@@ -52,14 +54,22 @@ class MidiOutPort : public MIDIOUTPORT {
 
       void        close(void)         { MIDIOUTPORT::close(); }
       void        closeAll(void)      { MIDIOUTPORT::closeAll(); }
+      int         flush(void)         { return MIDIOUTPORT::flush(); }
+      static int  flushAll(void)      { return MIDIOUTPORT::flushAll(); }
       int         getChannelOffset(void) const { 
                      return MIDIOUTPORT::getChannelOffset(); }
+      int         getCoalescing(void) { 
+                     return MIDIOUTPORT::getCoalescing(); }
       const char* getName(void)       { return MIDIOUTPORT::getName(); }
       static const char* getName(int i) { return MIDIOUTPORT::getName(i); }
       static int  getNumPorts(void)   { return MIDIOUTPORT::getNumPorts(); }
       int         getPort(void)       { return MIDIOUTPORT::getPort(); }
       int         getPortStatus(void) { 
                      return MIDIOUTPORT::getPortStatus(); }
+      int         getRunningStatus(void) { 
+                     return MIDIOUTPORT::getRunningStatus(); }
+      int64_t     getRunningStatusSavings(void) { 
+                     return MIDIOUTPORT::getRunningStatusSavings(); }
       int         getTrace(void) { 
                      return MIDIOUTPORT::getTrace(); }
       int         open(void)         { return MIDIOUTPORT::open(); }
@@ -74,7 +84,13 @@ class MidiOutPort : public MIDIOUTPORT {
       void        setAndOpenPort(int aPort) { setPort(aPort); open(); }
 //    void        setChannelOffset(int aChannel) { 
 //                   MIDIOUTPORT::setChannelOffset(aChannel); }
+      void        setCoalescing(int aState) { 
+                     MIDIOUTPORT::setCoalescing(aState); }
+      static void setFlushLimits(int maxBytes, double maxMilliseconds) {
+                     MIDIOUTPORT::setFlushLimits(maxBytes, maxMilliseconds); }
       void        setPort(int aPort) { MIDIOUTPORT::setPort(aPort); }
+      void        setRunningStatus(int aState) { 
+                     MIDIOUTPORT::setRunningStatus(aState); }
       int         setTrace(int aState) {
                      return MIDIOUTPORT::setTrace(aState); }
       int         sysex(uchar* array, int size) {
@@ -3,6 +3,9 @@
 // Creation Date: Wed May 10 16:22:00 PDT 2000
 // Last Modified: Sun May 14 20:43:44 PDT 2000
 // Last Modified: Sat Nov  2 20:39:01 PST 2002 (added ALSA def)
+// Last Modified: Sat Oct 17 16:21:48 PDT 2026 (output write coalescing)
+// Last Modified: Sat Oct 17 16:58:07 PDT 2026 (running status output)
+// Last Modified: Sun Oct 18 11:48:30 PDT 2026 (atomic stage settings)
 // Filename:      ...sig/maint/code/control/MidiOutPort/linux/MidiOutPort_alsa.h
 // Web Address:   http://sig.sapp.org/include/sig/MidiOutPort_alsa.h
 // Syntax:        C++
@@ -21,6 +24,11 @@
 
 #include "Sequencer_alsa.h"
 
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
 #ifndef OLDCPP
    #include <iostream>
    using namespace std;
@@ -39,12 +47,17 @@ class MidiOutPort_alsa : public Sequencer_alsa {
 
       void            close                      (void);
       void            closeAll                   (void);
+      int             flush                      (void);
+      static int      flushAll                   (void);
       int             getChannelOffset           (void) const;
+      int             getCoalescing              (void);
       const char*     getName                    (void);
       static const char* getName                 (int i);
       int             getPort                    (void);
       static int      getNumPorts                (void);
       int             getPortStatus              (void);
+      int             getRunningStatus           (void);
+      int64_t         getRunningStatusSavings    (void);
       int             getTrace                   (void);
       int             rawsend                    (int command, int p1, int p2);
       int             rawsend                    (int command, int p1);
@@ -52,7 +65,11 @@ class MidiOutPort_alsa : public Sequencer_alsa {
       int             rawsend                    (uchar* array, int size);
       int             open                       (void);
       void            setChannelOffset           (int aChannel);
+      void            setCoalescing              (int aState);
+      static void     setFlushLimits             (int maxBytes, 
+                                                  double maxMilliseconds);
       void            setPort                    (int aPort);
+      void            setRunningStatus           (int aState);
       int             setTrace                   (int aState);
       int             sysex                      (uchar* array, int size);
       void            toggleTrace                (void);
@@ -65,11 +82,24 @@ class MidiOutPort_alsa : public Sequencer_alsa {
       static int        numDevices;      // number of output ports
       static int*       trace;           // for printing messages to output
       static ostream*   tracedisplay;    // for printing trace messages
+      static std::atomic<int>* coalesceQ; // true if output is staged
+      static vector<uchar>* stageBuffer; // staged output for each port
+      static int64_t*   stageTime;       // time of oldest staged byte (ns)
+      static std::mutex* stageLock;      // for stageBuffer and stageTime
+      static std::atomic<int>* runningStatusQ; // true if running status
+      static int*       lastStatus;      // running status of port, 0 = none
+      static int64_t*   statusSavings;   // status bytes not sent
+      static std::atomic<int> flushBytes; // write when this much is staged
+      static std::atomic<int64_t> flushAge; // write when staged this long (ns)
 
    private:
       void            deinitialize               (void); 
       void            initialize                 (void); 
+      int             sendBytes                  (uchar* data, int count);
+      static void     stageRunningStatus         (int aPort, uchar* data,
+                                                  int count);
       void            setPortStatus              (int aStatus);
+      static int      writeStage                 (int aPort);
 
       static int      channelOffset;     // channel offset, either 0 or 1.
                                          // not being used right now.
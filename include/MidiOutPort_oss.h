@@ -19,6 +19,8 @@
 
 #include "Sequencer_oss.h"
 
+#include <stdint.h>
+
 typedef unsigned char uchar;
 
 
@@ -30,12 +32,19 @@ class MidiOutPort_oss : public Sequencer_oss {
 
       void            close                      (void);
       void            closeAll                   (void);
+      // output is not staged, so there is never anything to flush
+      int             flush                      (void) { return 1; }
+      static int      flushAll                   (void) { return 1; }
       int             getChannelOffset           (void) const;
+      int             getCoalescing              (void) { return 0; }
       const char*     getName                    (void);
       static const char* getName                 (int i);
       int             getPort                    (void);
       static int      getNumPorts                (void);
       int             getPortStatus              (void);
+      // status bytes are always sent
+      int             getRunningStatus           (void) { return 0; }
+      int64_t         getRunningStatusSavings    (void) { return 0; }
       int             getTrace                   (void);
       int             rawsend                    (int command, int p1, int p2);
       int             rawsend                    (int command, int p1);
@@ -43,7 +52,11 @@ class MidiOutPort_oss : public Sequencer_oss {
       int             rawsend                    (uchar* array, int size);
       int             open                       (void);
       void            setChannelOffset           (int aChannel);
+      void            setCoalescing              (int aState) { }
+      static void     setFlushLimits             (int maxBytes, 
+                                                  double maxMilliseconds) { }
       void            setPort                    (int aPort);
+      void            setRunningStatus           (int aState) { }
       int             setTrace                   (int aState);
       int             sysex                      (uchar* array, int size);
       void            toggleTrace                (void);
@@ -26,6 +26,8 @@
 
 #include "Array.h"
 
+#include <stdint.h>
+
 #include <CoreMIDI/CoreMIDI.h>         /* interface to MIDI in Macintosh OS X */
 #include <CoreServices/CoreServices.h> /* for file stuff */
 #include <AudioToolbox/AudioToolbox.h> /* for AUGraph */
@@ -43,12 +45,19 @@ class MidiOutPort_osx {
 
       void            close               (void);
       static void     closeAll            (void);
+      // output is not staged, so there is never anything to flush
+      int             flush               (void) { return 1; }
+      static int      flushAll            (void) { return 1; }
       int             getChannelOffset    (void) const;
+      int             getCoalescing       (void) { return 0; }
       const char*     getName             (void);
       static const char* getName          (int i);
       int             getPort             (void);
       static int      getNumPorts         (void);
       int             getPortStatus       (void);
+      // status bytes are always sent
+      int             getRunningStatus    (void) { return 0; }
+      int64_t         getRunningStatusSavings (void) { return 0; }
       int             getTrace            (void);
       int             rawsend             (int command, int p1, int p2);
       int             rawsend             (int command, int p1);
@@ -56,7 +65,11 @@ class MidiOutPort_osx {
       int             rawsend             (uchar* array, int size);
       int             open                (void);
       void            setChannelOffset    (int aChannel);
+      void            setCoalescing       (int aState) { }
+      static void     setFlushLimits      (int maxBytes, 
+                                           double maxMilliseconds) { }
       void            setPort             (int aPort);
+      void            setRunningStatus    (int aState) { }
       int             setTrace            (int aState);
       int             sysex               (uchar* array, int size);
       void            toggleTrace         (void);
@@ -16,6 +16,8 @@
 #ifndef _MIDIOUTPUT_UNSUPPORTED_H_INCLUDED
 #define _MIDIOUTPUT_UNSUPPORTED_H_INCLUDED
 
+#include <stdint.h>
+
 typedef unsigned char uchar;
 
 class MidiOutPort_unsupported {
@@ -26,12 +28,17 @@ class MidiOutPort_unsupported {
 
       void              close                    (void);
       void              closeAll                 (void);
+      int               flush                    (void) { return 1; }
+      static int        flushAll                 (void) { return 1; }
       int               getChannelOffset         (void) const;
+      int               getCoalescing            (void) { return 0; }
       const char*       getName                  (void) const;
       const char*       getName                  (int i) const;
       int               getPort                  (void) const;
       int               getNumPorts              (void) const;
       int               getPortStatus            (void) const;
+      int               getRunningStatus         (void) { return 0; }
+      int64_t           getRunningStatusSavings  (void) { return 0; }
       int               getTrace                 (void) const;
       int               rawsend                  (int command, int p1, int p2);
       int               rawsend                  (int command, int p1);
@@ -39,7 +46,11 @@ class MidiOutPort_unsupported {
       int               rawsend                  (uchar* array, int size);
       int               open                     (void);
       void              setChannelOffset         (int aChannel);
+      void              setCoalescing            (int aState) { }
+      static void       setFlushLimits           (int maxBytes, 
+                                                  double maxMilliseconds) { }
       void              setPort                  (int aPort);
+      void              setRunningStatus         (int aState) { }
       int               setTrace                 (int aState);
       int               sysex                    (uchar* array, int size);
       void              toggleTrace              (void);
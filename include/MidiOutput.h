@@ -5,6 +5,13 @@
 // Last Modified: Sat Jan 30 14:00:29 PST 1999
 // Last Modified: Sun Jul 18 18:52:42 PDT 1999 (added RPN functions)
 // Last Modified: Wed Jun  4 20:06:46 PDT 2003 (initial MIDI file recording)
+// Last Modified: Sat Oct 17 17:34:26 PDT 2026 (timed output with sendAt)
+// Last Modified: Sat Oct 17 18:49:55 PDT 2026 (redundant send suppression)
+// Last Modified: Sat Oct 17 19:27:03 PDT 2026 (active note tracking)
+// Last Modified: Sat Oct 17 20:41:18 PDT 2026 (output pacing)
+// Last Modified: Sat Oct 17 21:16:52 PDT 2026 (background MIDI file recording)
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026 (binary log recording)
+// Last Modified: Sun Oct 18 11:24:09 PDT 2026 (MidiOutputGroup is a friend)
 // Filename:      ...sig/maint/code/control/MidiOutput/MidiOutput.h
 // Web Address:   http://www-ccrma.stanford.edu/~craig/improv/include/MidiOutput.h
 // Syntax:        C++
@@ -18,7 +25,11 @@
 #define _MIDIOUTPUT_H_INCLUDED
 
 #include "MidiOutPort.h"
+#include "MidiActiveNotes.h"
+#include "MidiSendQueue.h"
+#include "MidiStateCache.h"
 #include "MidiFileWrite.h"
+#include "MidiFileRecorder.h"
 #include "FileIO.h"
 #include "SigTimer.h"
 #include "Array.h"
@@ -27,14 +38,45 @@
 #define RECORD_ASCII     (0)
 #define RECORD_BINARY    (1)
 #define RECORD_MIDI_FILE (2)
+#define RECORD_MIDI_FILE_PORTS    (3)   // a track for each port
+#define RECORD_MIDI_FILE_CHANNELS (4)   // a track for each channel
+#define RECORD_MIDI_LOG           (5)   // MidiFileRecorder binary log
 
 
 class MidiOutput : public MidiOutPort {
+   // updates activeNotes and outputState for the messages it sends
+   friend class MidiOutputGroup;
+
    public:
                 MidiOutput     (void);
                 MidiOutput     (int aPort, int autoOpen = 1);
                ~MidiOutput     ();
 
+      // Timed output commands (times are SigTimer::getMonotonicTime() ns):
+      void      clearScheduled (void);
+      int       getScheduledCount(void);
+      void      getSendStatistics(MidiSendStatistics& stats);
+      int       sendAt         (int64_t nanoseconds, int command, int p1,
+                                int p2);
+      int       sendAt         (int64_t nanoseconds, smf::MidiEvent& message);
+      int       sendAt         (int64_t nanoseconds, const uchar* data,
+                                int size);
+
+      // Pace output to the speed of the MIDI cable:
+      int64_t   getPacingLatency(void);
+      void      setPacing      (int aState, double bytesPerSecond =
+                                MIDI_WIRE_BYTES_PER_SECOND);
+
+      // Leave out messages which would not change the port state:
+      MidiStateCache& getStateCache(void);
+      void      setStateCache  (int aState, int controllerDeadband = 0,
+                                int pitchBendDeadband = 0);
+
+      // Notes which are sounding on the port:
+      int       getActiveCount (int channel = -1);
+      int       isSounding     (int channel, int keynum);
+      void      panic          (int aChannel = -1);
+
       // Basic user MIDI output commands:
       int       cont           (int channel, int controller, int data);
       int       off            (int channel, int keynum, int releaseVelocity);
@@ -44,6 +86,7 @@ class MidiOutput : public MidiOutPort {
       int       pw             (int channel, int tuningData);
       int       pw             (int channel, double tuningData);
       void      recordStart    (char *filename, int format);
+      void      recordStart    (MidiFileRecorder& recorder);
       void      recordStop     (void);
       void      reset          (void);
       int       send           (int command, int p1, int p2);
@@ -60,20 +103,32 @@ class MidiOutput : public MidiOutPort {
       int       outputRecordType;  // what form to record MIDI data in
       int       lastFlushTime;     // for recording midi data
       FileIO    outputRecordFile;  // file for recording midi data
+      MidiFileRecorder* midiRecorder; // for recording MIDI files
+      int       midiRecorderOwnerQ; // true if midiRecorder is deleted here
       static SigTimer timer;       // for recording midi data
       static Array<int>* rpn_lsb_status; // for RPN messages
       static Array<int>* rpn_msb_status; // for RPN messages
       static int objectCount;            // for RPN messages
+      static MidiSendQueue** sendQueue;  // timed output for each port
+      static MidiStateCache* outputState; // for leaving out redundant data
+      static MidiActiveNotes* activeNotes; // sounding notes on each port
 
+      void      deinitializeActiveNotes(void);
       void      deinitializeRPN    (void);
+      void      deinitializeSendQueues(void);
+      void      deinitializeStateCache(void);
+      void      initializeActiveNotes(void);
+      void      initializeStateCache(void);
+      int       isPaced        (void);
+      int       isRedundant    (int command, int p1, int p2, int size);
+      void      sendFailed     (int command);
+      void      sendSucceeded  (int command, int p1, int p2, int size);
+      MidiSendQueue* getSendQueue  (void);
       void      initializeRPN      (void);
       void      writeOutputAscii   (int channel, int p1, int p2);
       void      writeOutputBinary  (int channel, int p1, int p2); 
       void      writeOutputMidifile(int channel, int p1, int p2);
 
-   private:
-      MidiFileWrite rtmidifile;
-
    public: // RPN controller functions
       int    NRPN                    (int channel, int nrpn_msb, int nrpn_lsb, 
                                            int data_msb, int data_lsb);
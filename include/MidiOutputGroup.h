@@ -0,0 +1,114 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 20:04:37 PDT 2026
+// Last Modified: Sat Oct 17 20:04:37 PDT 2026
+// Last Modified: Sun Oct 18 11:24:09 PDT 2026 (follow sounding notes)
+// Filename:      ...sig/maint/code/control/MidiOutput/MidiOutputGroup.h
+// Web Address:   http://sig.sapp.org/include/sig/MidiOutputGroup.h
+// Syntax:        C++11
+//
+// Description:   Sends one MIDI message to several output destinations,
+//                such as for a patch bay.  Each destination is an output
+//                port with its own rules: which message types are sent,
+//                which channels are sent and what channel they are sent
+//                on, a range of key numbers, and a transposition.  The
+//                rules are compiled into a table of routes for each
+//                status byte, so sending a message only looks up its
+//                routes rather than testing every rule of every
+//                destination.  The messages for each output port are
+//                collected and written with one rawsend(), even if
+//                several destinations use the same port (for example
+//                to double a part on two channels or in octaves).
+//
+//                Notes sent by the group are added to the sounding notes
+//                of their ports, so MidiOutput::isSounding(), panic() and
+//                silence() know about them.  A port whose MidiOutput
+//                state cache is active forgets the channels which the
+//                group changed, so that the next MidiOutput message on
+//                those channels is not left out as redundant.
+//
+//                The group is not thread-safe: set up the destinations
+//                and call send() from the same thread, which should be
+//                the thread which uses the state caches of the ports.
+//
+
+#ifndef _MIDIOUTPUTGROUP_H_INCLUDED
+#define _MIDIOUTPUTGROUP_H_INCLUDED
+
+#include "MidiOutPort.h"
+#include "MidiEvent.h"
+
+#include <stdint.h>
+#include <vector>
+
+typedef unsigned char uchar;
+
+
+class MidiOutputGroup {
+   public:
+                    MidiOutputGroup    (void);
+                   ~MidiOutputGroup    ();
+
+      int           addDestination     (int aPort, int autoOpen = 1);
+      void          clear              (void);
+      int           getDestinationCount(void) const;
+      int           getPort            (int destination) const;
+      int           send               (const uchar* data, int size);
+      int           send               (int command, int p1, int p2);
+      int           send               (int command, int p1);
+      int           send               (int command);
+      int           send               (smf::MidiEvent& message);
+      void          setChannel         (int destination, int inChannel,
+                                        int outChannel);
+      void          setChannel         (int destination, int outChannel);
+      void          setCommand         (int destination, int command,
+                                        int state);
+      void          setNoteRange       (int destination, int aLowKey,
+                                        int aHighKey);
+      void          setTranspose       (int destination, int semitones);
+
+   protected:
+      // the rules for one destination
+      struct Destination {
+         int        output;             // index into outputs
+         int8_t     channelMap[16];     // output channel, -1 = not sent
+         uint8_t    commandMask;        // bit n = command 0x80 + n*0x10
+         uint16_t   systemMask;         // bit n = status byte 0xf0 + n
+         uchar      lowKey;             // lowest key number sent
+         uchar      highKey;            // highest key number sent
+         int        transpose;          // added to key numbers
+      };
+
+      // one compiled route for a status byte
+      struct Route {
+         int        output;             // index into outputs
+         uchar      status;             // status byte to send
+         uchar      lowKey;             // key range of note messages
+         uchar      highKey;
+         int8_t     transpose;          // added to key numbers
+      };
+
+      // an output port and the bytes waiting to be written to it
+      struct Output {
+         MidiOutPort* port;
+         std::vector<uchar> batch;
+      };
+
+      std::vector<Destination> destinations;
+      std::vector<Output>      outputs;
+      std::vector<Route>       routes;      // grouped by status byte
+      int           routeStart[129];        // first route of 0x80 + n
+      std::vector<int>         pending;     // outputs with bytes waiting
+      int           compiled;               // false if rules changed
+
+      void          compile            (void);
+      Destination*  getDestination     (int destination);
+      void          trackOutput        (int aPort, const uchar* data,
+                                        int count, int size, int sent);
+};
+
+
+#endif  /* _MIDIOUTPUTGROUP_H_INCLUDED */
+
+
+
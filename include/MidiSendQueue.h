@@ -0,0 +1,128 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 17:34:26 PDT 2026
+// Last Modified: Sat Oct 17 17:34:26 PDT 2026
+// Last Modified: Sat Oct 17 19:27:03 PDT 2026 (active note tracking)
+// Last Modified: Sat Oct 17 20:41:18 PDT 2026 (output pacing)
+// Filename:      ...sig/maint/code/control/MidiOutput/MidiSendQueue.h
+// Web Address:   http://sig.sapp.org/include/sig/MidiSendQueue.h
+// Syntax:        C++11
+//
+// Description:   A time-ordered queue of MIDI messages for one output
+//                port, with a sender thread which sleeps until the next
+//                message is due and then sends it.  Times are absolute
+//                CLOCK_MONOTONIC nanoseconds (see
+//                SigTimer::getMonotonicTime()), the same time base as
+//                MIDI input timestamps.  Messages which are due at the
+//                same time are sent in the order they were inserted.
+//                The lateness of each message is collected into a
+//                histogram so that the output jitter can be measured.
+//
+//                The queue can also pace its output to the speed of a
+//                MIDI cable (or any other byte rate).  Messages which
+//                are due wait in three lanes, and one is written only
+//                when the bytes already written would have left the
+//                cable.  Notes and other messages whose order matters
+//                are written first, then continuous controller, pitch
+//                bend and aftertouch messages, then sysex.  While a
+//                continuous message is waiting, a newer value for the
+//                same controller replaces it instead of being queued
+//                behind it, so controller streams are thinned when the
+//                cable is saturated.  The time until the cable would be
+//                free is reported as the predicted latency.
+//
+
+#ifndef _MIDISENDQUEUE_H_INCLUDED
+#define _MIDISENDQUEUE_H_INCLUDED
+
+#include "MidiOutPort.h"
+#include "MidiActiveNotes.h"
+
+#include <atomic>
+#include <deque>
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+
+typedef unsigned char uchar;
+
+// number of bins in the lateness histogram.  Bin 0 counts messages sent
+// less than 1 microsecond after their time, and bin i counts messages
+// sent from 2^(i-1) up to 2^i microseconds late.  The last bin also
+// counts anything later.
+#define MIDI_SEND_HISTOGRAM_SIZE (24)
+
+// byte rate of a MIDI cable: 31250 baud with 10 bits per byte
+#define MIDI_WIRE_BYTES_PER_SECOND (3125.0)
+
+struct MidiSendStatistics {
+   int64_t sent;                    // messages sent by the sender thread
+   int64_t maxLateness;             // latest message in nanoseconds
+   int64_t totalLateness;           // sum of lateness in nanoseconds
+   int64_t histogram[MIDI_SEND_HISTOGRAM_SIZE];
+   int64_t thinned;                 // paced messages replaced by newer
+};
+
+
+class MidiSendQueue {
+   public:
+                    MidiSendQueue      (int aPort,
+                                        MidiActiveNotes* notes = NULL);
+                   ~MidiSendQueue      ();
+
+      void          clear              (void);
+      void          clearStatistics    (void);
+      int           getCount           (void);
+      double        getPacing          (void);
+      int           getPort            (void);
+      int64_t       getPredictedLatency(void);
+      void          getStatistics      (MidiSendStatistics& stats);
+      int           insert             (int64_t nanoseconds,
+                                        const uchar* data, int size);
+      int           isPaced            (void);
+      void          setPacing          (double bytesPerSecond);
+
+   protected:
+      struct Message {
+         int64_t    time;               // when to send (ns)
+         uint64_t   order;              // insertion order for equal times
+         int        size;               // number of bytes in message
+         uchar      shortData[4];       // bytes of short messages
+         std::vector<uchar> longData;   // bytes of sysex messages
+      };
+
+      MidiOutPort   output;             // where the messages are sent
+      MidiActiveNotes* activeNotes;     // notes sounding on port, or NULL
+      std::vector<Message> heap;        // pending messages, earliest first
+      std::deque<Message> lane[3];      // due messages waiting for pacing
+      int64_t       laneBytes;          // bytes waiting in the lanes
+      int           writeCount;         // messages being written now
+      int64_t       wireBusyUntil;      // when the written bytes are out
+      std::atomic<int64_t> byteTime;    // ns per byte, 0 = not paced
+      uint64_t      orderCount;         // for ordering equal times
+      int           running;            // false when thread should exit
+      pthread_t     senderThread;
+      pthread_mutex_t queueLock;        // for heap and statistics
+      pthread_cond_t  queueChanged;     // signaled on insert/clear/exit
+      MidiSendStatistics statistics;
+
+      void          addToLane          (Message& message);
+      void          countLateness      (int64_t lateness);
+      static int    getLane            (const Message& message);
+      int64_t       getNextTime        (void);
+      static bool   isLater            (const Message& a, const Message& b);
+      int64_t       sendMessage        (Message& message);
+      void          takeLanes          (int64_t now,
+                                        std::vector<Message>& batch);
+      void          waitUntil          (int64_t nanoseconds);
+
+   friend void *sendMidiQueuePrivate(void* x);
+};
+
+void *sendMidiQueuePrivate(void* x);
+
+
+#endif  /* _MIDISENDQUEUE_H_INCLUDED */
+
+
+
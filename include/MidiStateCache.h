@@ -0,0 +1,67 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 18:49:55 PDT 2026
+// Last Modified: Sat Oct 17 18:49:55 PDT 2026
+// Filename:      ...sig/maint/code/control/MidiOutput/MidiStateCache.h
+// Web Address:   http://sig.sapp.org/include/sig/MidiStateCache.h
+// Syntax:        C++
+//
+// Description:   Remembers the state of a MIDI output port (controller
+//                values, pitch bend, program and the RPN/NRPN parameter
+//                selection on each channel) so that messages which
+//                would not change anything can be left out.  Controller
+//                and pitch bend changes smaller than a deadband can also
+//                be left out.  Messages which perform an action rather
+//                than set a value (notes, data entry, channel mode
+//                messages) are always sent.
+//
+
+#ifndef _MIDISTATECACHE_H_INCLUDED
+#define _MIDISTATECACHE_H_INCLUDED
+
+#include <stdint.h>
+
+typedef unsigned char uchar;
+
+
+class MidiStateCache {
+   public:
+                    MidiStateCache      (void);
+
+      int           accept              (const uchar* data, int size);
+      void          clear               (void);
+      void          clear               (int channel);
+      void          clearStatistics     (void);
+      int           getActive           (void) const;
+      int           getController       (int channel, int controller) const;
+      int           getControllerDeadband(void) const;
+      int           getPitchBend        (int channel) const;
+      int           getPitchBendDeadband(void) const;
+      int           getProgram          (int channel) const;
+      int64_t       getSuppressedBytes  (void) const;
+      int64_t       getSuppressedCount  (void) const;
+      void          setActive           (int aState);
+      void          setDeadband         (int controllerDeadband,
+                                         int pitchBendDeadband = 0);
+
+   protected:
+      int           active;             // true if messages are filtered
+      int           controllerDeadband; // largest ignored controller change
+      int           pitchBendDeadband;  // largest ignored pitch bend change
+      int16_t       controller[16][128];// last controller values sent
+      int16_t       pitchBend[16];      // last pitch bend values sent
+      int16_t       program[16];        // last program changes sent
+      int16_t       selection[16][4];   // NRPN lsb/msb, RPN lsb/msb
+      int8_t        selectionType[16];  // which of RPN/NRPN is selected
+      int64_t       suppressedCount;    // messages left out
+      int64_t       suppressedBytes;    // bytes left out
+
+      int           acceptController    (int channel, int number, int value);
+      int           suppress            (int size);
+};
+
+
+#endif  /* _MIDISTATECACHE_H_INCLUDED */
+
+
+
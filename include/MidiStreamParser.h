@@ -0,0 +1,97 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 12:05:51 PDT 2026
+// Last Modified: Sat Oct 17 12:05:51 PDT 2026
+// Last Modified: Sat Oct 17 14:22:15 PDT 2026 (added swapSysex)
+// Filename:      ...sig/maint/code/control/MidiStreamParser/MidiStreamParser.h
+// Web Address:   http://sig.sapp.org/include/sig/MidiStreamParser.h
+// Syntax:        C++11
+//
+// Description:   Converts a raw MIDI byte stream from one input device
+//                into complete MIDI messages.  Handles running status,
+//                system common messages, system exclusive messages,
+//                and realtime bytes (0xf8-0xff) which may be interleaved
+//                inside of any other message.  Bytes can be given to
+//                the parser in arbitrary chunks; a message split across
+//                two calls to parse() is completed on the second call.
+//                Each complete message is passed to a callback function.
+//                Malformed input is counted and skipped, never fatal.
+//
+
+#ifndef _MIDISTREAMPARSER_H_INCLUDED
+#define _MIDISTREAMPARSER_H_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+typedef unsigned char uchar;
+
+// Called once for each complete message.  data[0] is the status byte,
+// and size is the total number of bytes in the message.  For system
+// exclusive messages, data contains the whole message from 0xf0 to
+// the terminating 0xf7.  If a sysex is cut off by another status byte,
+// the bytes received so far are delivered with an added 0xf7 (and
+// counted by getErrorCount()).  timestamp is the value given to parse()
+// when the first byte of the message arrived.
+typedef void (*MIDI_Parse_function)(const uchar* data, int size,
+      int64_t timestamp, void* userdata);
+
+
+class MidiStreamParser {
+   public:
+                    MidiStreamParser   (void);
+                    MidiStreamParser   (MIDI_Parse_function aFunction,
+                                        void* userdata = NULL);
+                   ~MidiStreamParser   ();
+
+      int           getErrorCount      (void) const;
+      static int    getMessageLength   (int statusByte);
+      int           inSysex            (void) const;
+      int           parse              (const uchar* data, int count,
+                                        int64_t timestamp = 0);
+      void          reset              (void);
+      void          setCallback        (MIDI_Parse_function aFunction,
+                                        void* userdata = NULL);
+      void          swapSysex          (std::vector<uchar>& storage);
+
+   protected:
+      MIDI_Parse_function callback;     // where to send complete messages
+      void*         callbackData;       // passed back to the callback
+      uchar         message[3];         // message being assembled
+      int           messageSize;        // bytes stored in message so far
+      int           expectedSize;       // total bytes, or 0 if no message
+      uchar         runningStatus;      // last channel status byte, or 0
+      int64_t       messageTime;        // time of first byte of message
+      int           sysexQ;             // true if inside of a sysex
+      std::vector<uchar> sysex;         // sysex message being assembled
+      int           errorCount;         // number of bytes which were ignored
+
+      // number of bytes in a message indexed by the status byte (0 for
+      // data bytes, -1 for variable-length system exclusive)
+      static constexpr signed char lengthTable[256] = {
+         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x00
+         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x10
+         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x20
+         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x30
+         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x40
+         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x50
+         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x60
+         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,   // 0x70
+         3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,   // 0x80 note off
+         3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,   // 0x90 note on
+         3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,   // 0xa0 aftertouch
+         3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,   // 0xb0 controller
+         2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,   // 0xc0 patch change
+         2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,   // 0xd0 pressure
+         3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,   // 0xe0 pitch bend
+        -1, 2, 3, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1    // 0xf0 system
+      };
+
+      void          deliver            (const uchar* data, int size,
+                                        int64_t timestamp);
+};
+
+
+
+#endif  /* _MIDISTREAMPARSER_H_INCLUDED */
@@ -0,0 +1,89 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 18:12:40 PDT 2026
+// Last Modified: Sat Oct 17 18:12:40 PDT 2026
+// Filename:      ...sig/maint/code/control/MidiTrace/MidiTrace.h
+// Web Address:   http://sig.sapp.org/include/sig/MidiTrace.h
+// Syntax:        C++11
+//
+// Description:   Asynchronous trace of MIDI input and output.  The MIDI
+//                ports add a fixed-size record for each message to a
+//                lock-free ring buffer, which takes a few atomic
+//                operations and never allocates memory or does I/O.
+//                A background thread takes the records out of the ring
+//                and either prints them as text (in the same format as
+//                the old inline trace: "(90:60,64)" for output and
+//                "[90:60,64]" for input) or writes the raw records to
+//                a binary file.  If the ring is full, records are lost
+//                and counted rather than slowing down the MIDI thread.
+//                The number of records can be limited by sampling
+//                (keep one record in N) and by a maximum rate.
+//
+
+#ifndef _MIDITRACE_H_INCLUDED
+#define _MIDITRACE_H_INCLUDED
+
+#include <stdint.h>
+
+#ifndef OLDCPP
+   #include <iostream>
+   using namespace std;
+#else
+   #include <iostream.h>
+#endif
+
+typedef unsigned char uchar;
+
+// record directions
+#define MIDI_TRACE_OUTPUT  (0)
+#define MIDI_TRACE_INPUT   (1)
+
+// record flags
+#define MIDI_TRACE_FAILED  (1)   // output could not be written
+#define MIDI_TRACE_PAUSED  (2)   // input arrived while port paused
+#define MIDI_TRACE_DROPPED (4)   // input lost (no sysex buffer space)
+
+// number of message bytes kept in a record
+#define MIDI_TRACE_BYTES   (12)
+
+// One traced message.  This is also the layout of the records in a
+// binary trace file (native byte order, 32 bytes each).
+struct MidiTraceRecord {
+   int64_t  time;                    // CLOCK_MONOTONIC nanoseconds
+   int16_t  port;                    // input or output port number
+   uint8_t  direction;               // MIDI_TRACE_INPUT or _OUTPUT
+   uint8_t  flags;                   // MIDI_TRACE_FAILED, etc.
+   int32_t  size;                    // size of the complete message
+   uchar    data[MIDI_TRACE_BYTES];  // first bytes of the message
+};
+
+
+class MidiTrace {
+   public:
+      static void     flush            (void);
+      static int64_t  getLostCount     (void);
+      static void     record           (int direction, int port,
+                                        const uchar* data, int size,
+                                        int flags = 0,
+                                        int64_t timestamp = 0);
+      static int      setBinaryFile    (const char* filename);
+      static void     setRateLimit     (int recordsPerSecond);
+      static void     setSampling      (int everyN);
+      static void     setStream        (ostream& out);
+      static void     start            (void);
+      static void     stop             (void);
+
+   private:
+      static int      drain            (void);
+      static void     print            (const MidiTraceRecord& record);
+
+   friend void *writeMidiTracePrivate(void* x);
+};
+
+void *writeMidiTracePrivate(void* x);
+
+
+#endif  /* _MIDITRACE_H_INCLUDED */
+
+
+
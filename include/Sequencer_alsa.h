@@ -4,6 +4,8 @@
 // Last Modified: Sat Oct 13 14:50:04 PDT 2001 (updated for ALSA 0.9 interface)
 // Last Modified: Tue May 26 12:29:15 EDT 2009 (updated for ALSA 1.0 interface)
 // Last Modified: Sat Jun 13 21:16:29 PDT 2009 (renamed SigCollection)
+// Last Modified: Sat Oct 17 12:48:09 PDT 2026 (driver input timestamps)
+// Last Modified: Sat Oct 17 16:21:48 PDT 2026 (static write functions)
 // Filename:      ...sig/maint/code/control/MidiOutPort/Sequencer_alsa.h
 // Web Address:   http://sig.sapp.org/include/sig/Sequencer_alsa.h
 // Syntax:        C++ 
@@ -75,17 +77,17 @@ class Sequencer_alsa {
       static const char*   getOutputName (int aDevice);
       static int    getNumInputs         (void);
       static int    getNumOutputs        (void);
-      int           is_open              (int mode, int index);
-      int           is_open_in           (int index);
-      int           is_open_out          (int index);
+      static int    is_open              (int mode, int index);
+      static int    is_open_in           (int index);
+      static int    is_open_out          (int index);
       int           open                 (int direction, int index);
       int           openInput            (int index);
       int           openOutput           (int index);
       void          read                 (int dev, uchar* buf, int count);
-      int           write                (int aDevice, int aByte);
-      int           write                (int aDevice, uchar* bytes, int count);
-      int           write                (int aDevice, char* bytes, int count);
-      int           write                (int aDevice, int* bytes, int count);
+      static int    write                (int aDevice, int aByte);
+      static int    write                (int aDevice, uchar* bytes, int count);
+      static int    write                (int aDevice, char* bytes, int count);
+      static int    write                (int aDevice, int* bytes, int count);
       
       int           getInCardValue       (int aDevice) const;
       int           getOutCardValue      (int aDevice) const;
@@ -96,6 +98,7 @@ class Sequencer_alsa {
       static int    initialized;            // for starting buileinfodatabase
 
       static vector<snd_rawmidi_t*> rawmidi_in;
+      static vector<int>            rawmidi_in_tstamp; // timestamped reads
       static vector<snd_rawmidi_t*> rawmidi_out;
       static vector<ALSA_ENTRY>     rawmidi_info;
       static vector<int>            midiin_index;
@@ -103,6 +106,7 @@ class Sequencer_alsa {
 
    private:
       static void   buildInfoDatabase     (void);
+      static int    enableInputTimestamps (snd_rawmidi_t* handle);
       static void   rebuildInfoDatabase   (void);
       static void   removeInfoDatabase    (void);
       static void   getDeviceInfo         (vector<ALSA_ENTRY>& info);
@@ -147,16 +151,16 @@ class Sequencer_alsa {
       static const char*   getOutputName (int aDevice) { return ""; }
       static int    getNumInputs         (void) { return 0; }
       static int    getNumOutputs        (void) { return 0; }
-      int           is_open              (int mode, int index) { return 0; }
-      int           is_open_in           (int index) { return 0; }
-      int           is_open_out          (int index) { return 0; }
+      static int    is_open              (int mode, int index) { return 0; }
+      static int    is_open_in           (int index) { return 0; }
+      static int    is_open_out          (int index) { return 0; }
       int           open                 (void) { return 0; }
       void          read                 (int dev, uchar* buf, int count) { }
       void          rebuildInfoDatabase  (void) { }
-      int           write                (int aDevice, int aByte) { return 0; }
-      int           write                (int aDevice, uchar* bytes, int count) { return 0; }
-      int           write                (int aDevice, char* bytes, int count) { return 0; }
-      int           write                (int aDevice, int* bytes, int count) { return 0; }
+      static int    write                (int aDevice, int aByte) { return 0; }
+      static int    write                (int aDevice, uchar* bytes, int count) { return 0; }
+      static int    write                (int aDevice, char* bytes, int count) { return 0; }
+      static int    write                (int aDevice, int* bytes, int count) { return 0; }
       int           getInCardValue       (int aDevice) const { return 0; }
       int           getOutCardValue      (int aDevice) const { return 0; }
 
@@ -11,6 +11,7 @@
 // Last Modified: Sun Nov 28 12:39:39 PST 1999 (added adjustPeriod())
 // Last Modified: Sun Nov 20 02:03:24 PST 2005 (changed to int64bit cpu speed)
 // Last Modified: Tue Jun  9 13:43:51 PDT 2009 (added Apple OSX interface)
+// Last Modified: Sat Oct 17 12:48:09 PDT 2026 (added getMonotonicTime)
 // Filename:      .../sig/code/control/SigTimer/SigTimer.h
 // Web Address:   http://www-ccrma.stanford.edu/~craig/improv/include/SigTimer.h
 // Syntax:        C++
@@ -29,6 +30,7 @@
 #define SIGTIMER_H_INCLUDED
 
 #include <time.h>
+#include <stdint.h>
 
 #ifdef VISUAL
    #include <wtypes.h>
@@ -74,6 +76,7 @@ class SigTimer {
       void             update             (int periodCount);
 
       static int64bits getCpuSpeed        (void);
+      static int64_t   getMonotonicTime   (void);
       static int64bits clockCycles        (TimeSpec& tspec);
 
    protected:
@@ -0,0 +1,347 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 11:32:40 PDT 2026
+// Last Modified: Sat Oct 17 12:48:09 PDT 2026 (added discard)
+// Last Modified: Sat Oct 17 15:40:12 PDT 2026 (added resize)
+// Filename:      ...sig/maint/code/base/SpscBuffer/SpscBuffer.cpp
+// Web Address:   http://sig.sapp.org/src/sigBase/SpscBuffer.cpp
+// Syntax:        C++11
+//
+// Description:   A circular buffer which can be written to by one thread
+//                and read from by another thread at the same time
+//                without locking (single-producer/single-consumer).
+//
+
+#ifndef _SPSCBUFFER_CPP_INCLUDED
+#define _SPSCBUFFER_CPP_INCLUDED
+
+#include "SpscBuffer.h"
+
+#include <stdlib.h>
+
+#ifndef OLDCPP
+   #include <iostream>
+   using namespace std;
+#else
+   #include <iostream.h>
+#endif
+
+
+//////////////////////////////
+//
+// SpscBuffer::SpscBuffer -- Constructor.  The requested size
+//    is rounded up to the next power of two.
+//
+
+template<class type>
+SpscBuffer<type>::SpscBuffer(void) {
+   size = 0;
+   mask = 0;
+   buffer = NULL;
+   reset();
+}
+
+
+template<class type>
+SpscBuffer<type>::SpscBuffer(int maxElements) {
+   size = 0;
+   mask = 0;
+   buffer = NULL;
+   setSize(maxElements);
+}
+
+
+
+//////////////////////////////
+//
+// SpscBuffer::~SpscBuffer -- Destructor.
+//    deallocates buffer memory.
+//
+
+template<class type>
+SpscBuffer<type>::~SpscBuffer() {
+   if (buffer != NULL) {
+      delete [] buffer;
+      buffer = NULL;
+   }
+}
+
+
+
+//////////////////////////////
+//
+// SpscBuffer::capacity -- returns the number of items which
+//    can be added to the buffer.  Returns 0 if the buffer is full.
+//
+
+template<class type>
+int SpscBuffer<type>::capacity(void) const {
+   return getSize() - getCount();
+}
+
+
+
+//////////////////////////////
+//
+// SpscBuffer::discard -- removes up to count items from the buffer
+//    without reading them.  Returns the number of items removed.
+//    Consumer thread only.
+//
+
+template<class type>
+int SpscBuffer<type>::discard(int count) {
+   if (count <= 0) {
+      return 0;
+   }
+   unsigned int tail = readIndex.load(std::memory_order_relaxed);
+   unsigned int head = writeIndex.load(std::memory_order_acquire);
+   unsigned int available = head - tail;
+   if (available > (unsigned int)count) {
+      available = count;
+   }
+   if (available > 0) {
+      readIndex.store(tail + available, std::memory_order_release);
+   }
+   return (int)available;
+}
+
+
+
+//////////////////////////////
+//
+// SpscBuffer::extract -- reads the next value from the buffer.
+//    Returns 1 if an item was extracted, or 0 if the buffer
+//    was empty (in which case item is not changed).  Consumer
+//    thread only.
+//
+
+template<class type>
+int SpscBuffer<type>::extract(type& item) {
+   unsigned int tail = readIndex.load(std::memory_order_relaxed);
+   unsigned int head = writeIndex.load(std::memory_order_acquire);
+   if (head == tail) {
+      return 0;
+   }
+   item = buffer[tail & mask];
+   readIndex.store(tail + 1, std::memory_order_release);
+   return 1;
+}
+
+
+//
+// Bulk version: extracts up to count items into the items array
+//    and returns the number of items which were extracted.
+//
+
+template<class type>
+int SpscBuffer<type>::extract(type* items, int count) {
+   if (items == NULL || count <= 0) {
+      return 0;
+   }
+   unsigned int tail = readIndex.load(std::memory_order_relaxed);
+   unsigned int head = writeIndex.load(std::memory_order_acquire);
+   unsigned int available = head - tail;
+   if (available > (unsigned int)count) {
+      available = count;
+   }
+   for (unsigned int i=0; i<available; i++) {
+      items[i] = buffer[(tail + i) & mask];
+   }
+   if (available > 0) {
+      readIndex.store(tail + available, std::memory_order_release);
+   }
+   return (int)available;
+}
+
+
+
+//////////////////////////////
+//
+// SpscBuffer::getCount -- returns the number of elements
+//    between the write index and the read index.  Safe to call
+//    from either thread.
+//
+
+template<class type>
+int SpscBuffer<type>::getCount(void) const {
+   unsigned int head = writeIndex.load(std::memory_order_acquire);
+   unsigned int tail = readIndex.load(std::memory_order_acquire);
+   return (int)(head - tail);
+}
+
+
+
+//////////////////////////////
+//
+// SpscBuffer::getSize -- returns the allocated size of the buffer.
+//
+
+template<class type>  
+int SpscBuffer<type>::getSize(void) const {
+   return (int)size;
+}
+
+
+
+//////////////////////////////
+//
+// SpscBuffer::insert -- add an element to the buffer.  Returns 1
+//    if the item was stored, or 0 if the buffer is full (in which
+//    case the new item is dropped).  Producer thread only.
+//
+
+template<class type>
+int SpscBuffer<type>::insert(const type& anItem) {
+   unsigned int head = writeIndex.load(std::memory_order_relaxed);
+   unsigned int tail = readIndex.load(std::memory_order_acquire);
+   if (head - tail >= size) {
+      return 0;
+   }
+   buffer[head & mask] = anItem;
+   writeIndex.store(head + 1, std::memory_order_release);
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// SpscBuffer::operator[] -- access an element relative to the
+//    last written element: object[0] is the most recent item and
+//    object[-1] (or object[1]) is the item written before that.
+//    The element may be overwritten by the producer once it has
+//    been extracted, so this is only useful for peeking at recent
+//    input.
+//
+
+template<class type>
+type& SpscBuffer<type>::operator[](int index) {
+   if (buffer == NULL) {
+      cerr << "Error: buffer has no allocated space" << endl;
+      exit(1);
+   }
+   int realIndex = (index < 0) ? -index : index;
+   if (realIndex >= getSize()) {
+      cerr << "Error:   Invalid access: " << realIndex << ", maximum is "
+           << getSize()-1 << endl;
+      exit(1);
+   }
+   unsigned int head = writeIndex.load(std::memory_order_acquire);
+   return buffer[(head - 1 - realIndex) & mask];
+}
+
+
+
+//////////////////////////////
+//
+// SpscBuffer::read -- an alias for the extract function.
+//
+
+template<class type>
+int SpscBuffer<type>::read(type& item) {
+   return extract(item);
+}
+
+
+
+//////////////////////////////
+//
+// SpscBuffer::reset -- throws out all previous data.  Not
+//    thread-safe: neither the producer nor the consumer may be
+//    using the buffer.
+//
+
+template<class type>
+void SpscBuffer<type>::reset(void) {
+   writeIndex.store(0, std::memory_order_relaxed);
+   readIndex.store(0, std::memory_order_release);
+}
+
+
+
+//////////////////////////////
+//
+// SpscBuffer::resize -- change the size of the buffer while keeping
+//    the waiting items in order.  The size is rounded up to a power
+//    of two, and is never made smaller than the number of waiting
+//    items.  Not thread-safe.
+//
+
+template<class type>
+void SpscBuffer<type>::resize(int aSize) {
+   int count = getCount();
+   if (aSize < count) {
+      aSize = count;
+   }
+   unsigned int newsize = 1;
+   while (newsize < (unsigned int)aSize) {
+      newsize <<= 1;
+   }
+   if (newsize == size) {
+      return;
+   }
+
+   type* newbuffer = new type[newsize];
+   unsigned int tail = readIndex.load(std::memory_order_relaxed);
+   for (int i=0; i<count; i++) {
+      newbuffer[i] = buffer[(tail + i) & mask];
+   }
+   if (buffer != NULL) {
+      delete [] buffer;
+   }
+   buffer = newbuffer;
+   size = newsize;
+   mask = newsize - 1;
+   readIndex.store(0, std::memory_order_relaxed);
+   writeIndex.store(count, std::memory_order_release);
+}
+ 
+  
+
+//////////////////////////////
+//
+// SpscBuffer::setSize -- warning: will throw out all previous data 
+//    stored in buffer.  The size is rounded up to a power of two.
+//    Not thread-safe.
+//
+
+template<class type>
+void SpscBuffer<type>::setSize(int aSize) {
+   if (aSize < 0) {
+      cerr << "Error: cannot have a negative buffer size: " << aSize << endl;
+      exit(1);
+   }
+   if (buffer != NULL) {
+      delete [] buffer;
+      buffer = NULL;
+   }
+
+   if (aSize == 0) {
+      size = 0;
+      mask = 0;
+   } else {
+      unsigned int newsize = 1;
+      while (newsize < (unsigned int)aSize) {
+         newsize <<= 1;
+      }
+      size = newsize;
+      mask = newsize - 1;
+      buffer = new type[size];
+   }
+   reset();
+}   
+
+
+
+//////////////////////////////
+//
+// SpscBuffer::write --  an alias for the insert function.
+//
+
+template<class type>
+int SpscBuffer<type>::write(const type& anElement) {
+   return insert(anElement);
+}
+
+
+#endif  /* _SPSCBUFFER_CPP_INCLUDED */
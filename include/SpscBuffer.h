@@ -0,0 +1,76 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 11:32:40 PDT 2026
+// Last Modified: Sat Oct 17 12:48:09 PDT 2026 (added discard)
+// Last Modified: Sat Oct 17 15:40:12 PDT 2026 (added resize)
+// Filename:      ...sig/maint/code/base/SpscBuffer/SpscBuffer.h
+// Web Address:   http://sig.sapp.org/include/sigBase/SpscBuffer.h
+// Syntax:        C++11
+//
+// Description:   A circular buffer which can be written to by one thread
+//                and read from by another thread at the same time
+//                without locking (single-producer/single-consumer).
+//                The size of the buffer is always a power of two.
+//                The read and write positions are free-running counters
+//                which are published with release stores and read with
+//                acquire loads, so getCount() is always consistent
+//                with the data which can be extracted.  Only the
+//                producer thread may call insert()/write(), and only
+//                the consumer thread may call extract()/read().
+//                setSize(), resize() and reset() may only be called 
+//                while neither thread is accessing the buffer.
+//
+
+#ifndef _SPSCBUFFER_H_INCLUDED
+#define _SPSCBUFFER_H_INCLUDED
+
+#include <atomic>
+
+#define SPSC_CACHE_LINE (64)
+
+
+template<class type>
+class SpscBuffer {
+   public:
+                    SpscBuffer         (void);
+                    SpscBuffer         (int maxElements);
+                   ~SpscBuffer         ();
+
+      int           capacity           (void) const;
+      int           discard            (int count);
+      int           extract            (type& item);
+      int           extract            (type* items, int count);
+      int           getCount           (void) const;
+      int           getSize            (void) const;
+      int           insert             (const type& anItem);
+      type&         operator[]         (int index);
+      int           read               (type& item);
+      void          reset              (void);
+      void          resize             (int aSize);
+      void          setSize            (int aSize);
+      int           write              (const type& anItem);
+
+   protected:
+      type*         buffer;
+      unsigned int  size;        // always a power of two
+      unsigned int  mask;        // size - 1
+
+      // the producer and consumer indices are kept on separate cache
+      // lines so that the two threads do not fight over them.
+      char          pad0[SPSC_CACHE_LINE];
+      std::atomic<unsigned int> writeIndex;  // written by producer only
+      char          pad1[SPSC_CACHE_LINE];
+      std::atomic<unsigned int> readIndex;   // written by consumer only
+      char          pad2[SPSC_CACHE_LINE];
+
+   private:
+                    SpscBuffer         (const SpscBuffer<type>& anotherBuffer);
+      SpscBuffer<type>& operator=      (const SpscBuffer<type>& anotherBuffer);
+};
+
+
+#include "SpscBuffer.cpp"
+
+
+
+#endif  /* _SPSCBUFFER_H_INCLUDED */
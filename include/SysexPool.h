@@ -0,0 +1,98 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 14:22:15 PDT 2026
+// Last Modified: Sat Oct 17 14:22:15 PDT 2026
+// Filename:      ...sig/maint/code/control/SysexPool/SysexPool.h
+// Web Address:   http://sig.sapp.org/include/sig/SysexPool.h
+// Syntax:        C++11
+//
+// Description:   Storage for incoming system exclusive messages.  A
+//                fixed number of slots is shared between a MIDI input
+//                thread (which stores messages) and the program (which
+//                reads them).  Each slot has a reference count: a slot
+//                is only reused when nobody refers to it any more, so
+//                unread messages are never overwritten.  If all slots
+//                are in use, the new message is refused and counted
+//                as an overflow.  Messages can be stored by swapping
+//                with the vector they were assembled in, so that no
+//                bytes are copied and no memory is allocated once the
+//                slot vectors have grown to the size of the messages.
+//                SysexView is a read-only reference to one slot.
+//
+
+#ifndef _SYSEXPOOL_H_INCLUDED
+#define _SYSEXPOOL_H_INCLUDED
+
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+
+typedef unsigned char uchar;
+
+class SysexView;
+
+
+class SysexPool {
+   public:
+                    SysexPool          (int aSlotCount = 128);
+                   ~SysexPool          ();
+
+      void          addReference       (int slot);
+      void          clear              (int slot);
+      const uchar*  getData            (int slot) const;
+      int           getOverflowCount   (void) const;
+      int           getSize            (int slot) const;
+      int           getSlotCount       (void) const;
+      int           isValid            (int slot) const;
+      void          release            (int slot);
+      int           store              (std::vector<uchar>& message);
+      int           store              (const uchar* data, int size);
+
+   protected:
+      struct Slot {
+         std::vector<uchar> data;       // the sysex message
+         std::atomic<int>   references; // 0 when the slot can be reused
+      };
+
+      Slot*         slots;
+      int           slotCount;
+      std::atomic<int> nextSlot;        // where to start looking for space
+      std::atomic<int> overflowCount;   // messages refused for lack of space
+
+      int           acquire            (void);
+
+   private:
+                    SysexPool          (const SysexPool& aPool);
+      SysexPool&    operator=          (const SysexPool& aPool);
+};
+
+
+
+//////////////////////////////
+//
+// SysexView -- a reference-counted read-only view of one sysex message
+//     in a SysexPool.  The data will not be overwritten while any view
+//     of it exists.
+//
+
+class SysexView {
+   public:
+                    SysexView          (void);
+                    SysexView          (SysexPool* aPool, int aSlot);
+                    SysexView          (const SysexView& aView);
+                   ~SysexView          ();
+
+      const uchar*  data               (void) const;
+      int           isValid            (void) const;
+      SysexView&    operator=          (const SysexView& aView);
+      uchar         operator[]         (int index) const;
+      void          reset              (void);
+      int           size               (void) const;
+
+   protected:
+      SysexPool*    pool;
+      int           slot;
+};
+
+
+#endif  /* _SYSEXPOOL_H_INCLUDED */
@@ -185,6 +185,7 @@ int runImprovInterface(void) {
       t_time = mainTimer.getTime(); 
 
       mainloopalgorithms();               // user defined behavior
+      MidiOutPort::flushAll();            // write any staged output
 
       if (keyboardTimer.expired()) {
          keyboardTimer.reset();
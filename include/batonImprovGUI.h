@@ -220,6 +220,7 @@ int runImprovInterface(void) {
       canvas.processEvents();
 
       mainloopalgorithms();               // user defined behavior
+      MidiOutPort::flushAll();            // write any staged output
 
       if (keyboardTimer.expired()) {
          keyboardTimer.reset();
@@ -23,11 +23,13 @@
 #include "MidiOutPort_unsupported.h"
 #include "MidiOutPort.h"
 #include "MidiOutput.h"
+#include "MidiOutputGroup.h"
 #include "MidiInPort_unsupported.h"
 #include "MidiInPort.h"
 #include "MidiInput.h"
 #include "MidiPort.h"
 #include "MidiIO.h"
+#include "MidiTrace.h"
 #include "RadioBaton.h"
 #include "AdamsStick.h"
 #include "Synthesizer.h"
@@ -6,6 +6,8 @@
 // Last Modified: Fri May  5 19:12:52 PDT 2000 (modified option handling)
 // Last Modified: Sun Nov 20 02:31:43 PST 2005 (allow higher cpu speeds)
 // Last Modified: Sun Jun 21 10:53:47 PDT 2009 (updated for GCC 4.3)
+// Last Modified: Sat Oct 17 13:20:37 PDT 2026 (wake up on MIDI input)
+// Last Modified: Sun Oct 18 10:05:31 PDT 2026 (sleep until the next event)
 // Filename:      ...sig/code/control/improv/synthImprov.h
 // Web Address:   http://improv.sapp.org/include/synthImprov.h
 // Syntax:        C++
@@ -29,6 +31,7 @@
 int    checkKeyboard(void);
 int    chooseSynthInputPort(void);
 int    chooseSynthOutputPort(void);
+double computeSleepTime(SigTimer& keyboardTimer);
 void   echoKeysOn(void);
 void   echoKeysOff(void);
 void   finishup_automatic(void);
@@ -68,7 +71,7 @@ long        t_time = 0;  // global time (in milliseconds) which remains
 
 Options options;                 // for handling command-line options
 KeyboardInput interfaceKeyboard; // for computer keyboard interface
-Idler eventIdler(1.0);           // to control CPU usage for multiprocessing
+Idler eventIdler(10.0);          // longest sleep between loop iterations
 
 
 
@@ -94,7 +97,7 @@ MidiIO x;
 
 int runImprovInterface(void) {
    SigTimer keyboardTimer;       // for controlling the keyboard checking rate
-   keyboardTimer.setPeriod(1);   // check the keyboard for new keys every 1 ms
+   keyboardTimer.setPeriod(10);  // check the keyboard for new keys every 10 ms
    int command = 0;              // a key from the keyboard
 
    initialization_automatic();
@@ -110,6 +113,7 @@ int runImprovInterface(void) {
       t_time = mainTimer.getTime(); 
 
       mainloopalgorithms();           // user defined behavior
+      MidiOutPort::flushAll();        // write any staged output
 
       if (keyboardTimer.expired()) {
          keyboardTimer.reset();
@@ -121,7 +125,10 @@ int runImprovInterface(void) {
       }
 
       #ifndef VISUAL
-         eventIdler.sleep();
+         // sleep until the next event in an EventBuffer is due or the
+         // keyboard should be checked, but wake up as soon as MIDI
+         // input arrives:
+         synth.waitForMessage(computeSleepTime(keyboardTimer));
       #endif
 
    } // end while(1)
@@ -387,6 +394,34 @@ void echoKeysOff(void) {
 
 
 
+//////////////////////////////
+//
+// computeSleepTime -- returns the number of milliseconds that the
+//    main loop can sleep: until the next event in an EventBuffer of
+//    this thread is due, until the keyboard is checked again, or for
+//    the idle period, whichever comes first.  Programs which poll
+//    their own timers in mainloopalgorithms() should set the idle
+//    period (setIdleEventRate) to the resolution that they need.
+//
+
+double computeSleepTime(SigTimer& keyboardTimer) {
+   double output = eventIdler.getPeriod();
+   double wait = keyboardTimer.getPeriod() - keyboardTimer.getTime();
+   if (wait < output) {
+      output = wait;
+   }
+   wait = EventBuffer::getThreadWaitTime();
+   if (wait >= 0.0 && wait < output) {
+      output = wait;
+   }
+   if (output < 0.0) {
+      output = 0.0;
+   }
+   return output;
+}
+
+
+
 //////////////////////////////
 //
 // echoKeysOn -- for compatibility with the Linux terminal.
@@ -417,8 +452,8 @@ void finishup_automatic(void) {
 
 //////////////////////////////
 //
-// getIdleEventRate -- sleep time between each iteration of the main
-//      loop for use with Multi-processing systems.
+// getIdleEventRate -- longest sleep time between each iteration of
+//      the main loop for use with Multi-processing systems.
 //
 
 double getIdleEventRate(void) {
@@ -543,8 +578,9 @@ void print_aux_commands(void) {
 
 //////////////////////////////
 //
-// setIdleEventRate -- sleep time between each iteration of the main
-//      loop
+// setIdleEventRate -- longest sleep time between each iteration of
+//      the main loop, in milliseconds.  The loop wakes up earlier for
+//      MIDI input, for events in EventBuffers and for the keyboard.
 //
 
 void setIdleEventRate(float aRate) {
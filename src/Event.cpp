@@ -4,6 +4,8 @@
 // Last Modified: Fri Jan 16 20:56:18 GMT-0800 1998
 // Last Modified: Thu Nov  5 12:21:23 PST 1998
 // Last Modified: Sun Jun 11 14:26:51 PDT 2000 (added floatValue() function)
+// Last Modified: Sat Oct 17 23:58:12 PDT 2026 (no virtual calls on stored events)
+// Last Modified: Sun Oct 18 01:20:55 PDT 2026 (times stored as 32-bit ints)
 // Filename:      ...sig/src/sigControl/Event/Event.cpp
 // Web Address:   http://sig.sapp.org/src/sig/Event.cpp
 // Syntax:        C++ 
@@ -15,6 +17,8 @@
 
 #include "Event.h"
 
+#include <string.h>
+
 
 //////////////////////////////
 //
@@ -179,7 +183,7 @@ int Event::getStatus(void) const {
 //
 
 int Event::getTime1(void) const {
-   return  (int)(*((long*)&data[4]));
+   return *((int*)&data[4]);
 }
 
 
@@ -190,7 +194,7 @@ int Event::getTime1(void) const {
 //
 
 int Event::getTime2(void) const {
-   return  (int)(*((long*)&data[12]));
+   return *((int*)&data[12]);
 }
 
 
@@ -313,19 +317,21 @@ void Event::kill(int aGroup, EventBuffer* midiOutput) {
 
 //////////////////////////////
 //
-// Event::off -- turn off the Event
+// Event::off -- turn off the Event.  The functions of the derived
+//     classes are called by name, since the event may be stored in an
+//     EventBuffer as a plain Event.
 //
 
 void Event::off(EventBuffer& midiOutput) {
    switch (getType() & 0x7) {
       case EVENT_ONESTAGE:   
-         ((OneStageEvent*)(this))->off(midiOutput);
+         ((OneStageEvent*)(this))->OneStageEvent::off(midiOutput);
          break;
       case EVENT_TWOSTAGE:   
-         ((TwoStageEvent*)(this))->off(midiOutput);
+         ((TwoStageEvent*)(this))->TwoStageEvent::off(midiOutput);
          break;
       case EVENT_MULTISTAGE:   
-         ((MultiStageEvent*)(this))->off(midiOutput);
+         ((MultiStageEvent*)(this))->MultiStageEvent::off(midiOutput);
          break;
       default:  // don't know what it is, so just turn if off
          setStatus(EVENT_STATUS_OFF);
@@ -350,9 +356,7 @@ Event& Event::operator=(const Event& anEvent) {
       return *this;
    }
 
-   for (long i=0; i<3; i++) {
-     ((ulong*)(&data))[i] = ((ulong*)&anEvent.data)[i];
-   }
+   memcpy(data, anEvent.data, sizeof(data));
 
    return *this;
 }
@@ -487,7 +491,7 @@ void Event::setP3(int aValue) {
 //
 
 void Event::setTime1(int aTime) {
-   *(long*)&data[4] = (long)aTime;
+   *((int*)&data[4]) = aTime;
 }
 
 
@@ -498,7 +502,7 @@ void Event::setTime1(int aTime) {
 //
 
 void Event::setTime2(int aTime) {
-   *(long*)&data[12] = (long)aTime;
+   *((int*)&data[12]) = aTime;
 }
 
 
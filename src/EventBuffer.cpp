@@ -4,6 +4,12 @@
 // Last Modified: Mon Feb 16 22:20:34 GMT-0800 1998
 // Last Modified: Thu Nov  5 17:06:33 PST 1998
 // Last Modified: Fri Apr 21 15:12:11 PDT 2000 (revisions finalized)
+// Last Modified: Sat Oct 17 22:47:05 PDT 2026 (events kept in a heap)
+// Last Modified: Sat Oct 17 23:21:40 PDT 2026 (storage grows in chunks)
+// Last Modified: Sat Oct 17 23:58:12 PDT 2026 (dispatch on the type byte)
+// Last Modified: Sun Oct 18 00:41:27 PDT 2026 (submit() from any thread)
+// Last Modified: Sun Oct 18 01:20:55 PDT 2026 (cancel and move event groups)
+// Last Modified: Sun Oct 18 10:05:31 PDT 2026 (getWaitTime)
 // Filename:      ...sig/src/control/EventBuffer/EventBuffer.cpp
 // Web Address:   http://sig.sapp.org/src/sig/EventBuffer.cpp
 // Syntax:        C++ 
@@ -16,23 +22,133 @@
 #include <string.h>
 
 
+// the action() and off() functions for each value of the type byte
+typedef void (*_EBFunction)(Event& event, EventBuffer& buffer);
+struct _EBDispatch {
+   _EBFunction action;
+   _EBFunction off;
+};
+static _EBDispatch dispatchTable[256];
+static int         dispatchTableQ = 0;
+
+EventBuffer* EventBuffer::bufferList = NULL;
+std::mutex   EventBuffer::bufferListLock;
+
+static void eventNothing    (Event& event, EventBuffer& buffer) { }
+static void eventOff        (Event& event, EventBuffer& buffer) {
+   event.setStatus(EVENT_STATUS_OFF);
+}
+static void midiStageAction (Event& event, EventBuffer& buffer) {
+   ((MidiStageEvent&)event).MidiStageEvent::action(buffer);
+}
+static void noteAction      (Event& event, EventBuffer& buffer) {
+   ((NoteEvent&)event).NoteEvent::action(buffer);
+}
+static void noteOff         (Event& event, EventBuffer& buffer) {
+   ((NoteEvent&)event).NoteEvent::off(buffer);
+}
+static void functionAction  (Event& event, EventBuffer& buffer) {
+   ((FunctionEvent&)event).FunctionEvent::action(buffer);
+}
+
+
+//////////////////////////////
+//
+// makeDispatchTable -- fill in the table in the same way as the
+//     switch statements of Event::action() and Event::off() and of
+//     the stage classes: events of a known stage with an unknown
+//     subtype do nothing when they act, and events of an unknown
+//     stage are turned off.
+//
+
+static void makeDispatchTable(void) {
+   for (int i=0; i<256; i++) {
+      switch (i & 0x07) {
+         case EVENT_ONESTAGE:
+         case EVENT_TWOSTAGE:
+         case EVENT_MULTISTAGE:
+            dispatchTable[i].action = eventNothing;
+            break;
+         default:
+            dispatchTable[i].action = eventOff;
+      }
+      dispatchTable[i].off = eventOff;
+   }
+   dispatchTable[EVENT_ONESTAGE | (EVENT_ONESTAGE_MIDI << 3)].action =
+         midiStageAction;
+   dispatchTable[EVENT_TWOSTAGE | EVENT_TWOSTAGE_NOTE].action = noteAction;
+   dispatchTable[EVENT_TWOSTAGE | EVENT_TWOSTAGE_NOTE].off    = noteOff;
+   dispatchTable[EVENT_MULTISTAGE | EVENT_MULTISTAGE_FUNCTION].action =
+         functionAction;
+   dispatchTableQ = 1;
+}
+
+
+// true if event a should act before event b
+static inline int actsBefore(const _EBHeapEntry& a, const _EBHeapEntry& b) {
+   if (a.time != b.time) {
+      return a.time < b.time;
+   }
+   return (int)(a.order - b.order) < 0;
+}
+
+
 //////////////////////////////
 //
 // EventBuffer::EventBuffer --
-//      default value: aSize = 1024;
+//      The size of the submit() queue is rounded up to a power of two.
+//      default values: aSize = 1024; aSubmitSize = EVENTBUFFER_SUBMIT_SIZE
 //
 
-EventBuffer::EventBuffer(int aSize) {
+EventBuffer::EventBuffer(int aSize, int aSubmitSize) {
    if (aSize < 1) {
       cout << "Error: eventBuffer size cannot be less than 1" << endl;
       exit(1);
    }
-   storageSize = aSize;
-   eventStorage = new Event[storageSize];
-   eventList = new _EBPrivate[storageSize + 1];
-   freeSlots.setSize(storageSize);
+   submitSize = 2;
+   while (submitSize < aSubmitSize) {
+      submitSize *= 2;
+   }
+   submitQueue = new _EBQueueCell[submitSize];
+   for (int i=0; i<submitSize; i++) {
+      submitQueue[i].sequence.store(i, std::memory_order_relaxed);
+   }
+   submitTail.store(0);
+   submitHead = 0;
+   submitDropped.store(0);
+   submittedCount = 0;
+
+   chunks          = NULL;
+   chunkCount      = 0;
+   minChunks       = 0;
+   allocatedChunks = 0;
+   emptyChunks     = 0;
+   firstFree       = 0;
+   freeCount       = 0;
+   listSize        = 0;
+   eventHeap       = NULL;
+   heapCount       = 0;
+   dueList         = NULL;
+   activationCount = 0;
+   touchedList     = NULL;
+   touchedCount    = 0;
+   for (int i=0; i<256; i++) {
+      groupHeads[i] = NULL;
+   }
+   usedPeak        = 0;
+   if (!dispatchTableQ) {
+      makeDispatchTable();
+   }
+   grownCount      = 0;
+   releasedCount   = 0;
    pollTimer.setPeriod(10);
+   setBufferSize(aSize);
    reset();
+
+   ownerThread = std::this_thread::get_id();
+   std::lock_guard<std::mutex> lock(bufferListLock);
+   nextBuffer = bufferList;
+   bufferList = this;
 }
 
 
@@ -43,16 +159,49 @@ EventBuffer::EventBuffer(int aSize) {
 //
 
 EventBuffer::~EventBuffer(void) {
-   if (eventStorage != NULL) {
-      delete [] eventStorage;
-       eventStorage = NULL;
-   } 
-   if (eventList != NULL) {
-      delete [] eventList;
-      eventList = NULL;
+   {
+      std::lock_guard<std::mutex> lock(bufferListLock);
+      EventBuffer** link = &bufferList;
+      while (*link != NULL && *link != this) {
+         link = &(*link)->nextBuffer;
+      }
+      if (*link == this) {
+         *link = nextBuffer;
+      }
    }
-
-   storageSize = 0;
+   for (int i=0; i<chunkCount; i++) {
+      if (chunks[i] != NULL) {
+         delete chunks[i];
+      }
+   }
+   if (chunks != NULL) {
+      delete [] chunks;
+      chunks = NULL;
+   }
+   if (eventHeap != NULL) {
+      delete [] eventHeap;
+      eventHeap = NULL;
+   }
+   if (dueList != NULL) {
+      delete [] dueList;
+      dueList = NULL;
+   }
+   if (touchedList != NULL) {
+      delete [] touchedList;
+      touchedList = NULL;
+   }
+   if (submitQueue != NULL) {
+      delete [] submitQueue;
+      submitQueue = NULL;
+   }
+   for (int i=0; i<256; i++) {
+      if (groupHeads[i] != NULL) {
+         delete [] groupHeads[i];
+         groupHeads[i] = NULL;
+      }
+   }
+   chunkCount = 0;
+   allocatedChunks = 0;
 }
    
 
@@ -60,13 +209,12 @@ EventBuffer::~EventBuffer(void) {
 //////////////////////////////
 //
 // EventBuffer::aquire -- reserve a space in the buffer.  Returns
-//     the index in the buffer that can be used.
+//     the index in the buffer that can be used.  The buffer grows if
+//     it is full.
 //
 
 int EventBuffer::aquire(void) {
-   int value = 0;
-   freeSlots.extract(value);
-	return value;
+   return allocateEvent();
 }
 
 
@@ -74,41 +222,62 @@ int EventBuffer::aquire(void) {
 //////////////////////////////
 //
 // EventBuffer::activate -- put an aquired element into the 
-//    event buffer.
+//    event buffer.  The event is scheduled at its current action time.
 //
 
 void EventBuffer::activate(int index) {
-   if (index < 0 || index >= storageSize) {
+   if (!validIndex(index)) {
       cerr << "Error: invalid index in EventBuffer::activate." << endl;
       exit(1);
    }
 
-   if (eventList[index].next != storageSize ||
-         eventList[index].last != storageSize    ) {
+   if (heapPosition(index) != -1) {
       cerr << "Error: trying to reactivate an element in EventBuffer." << endl;
       exit(1);
    }
 
+   _EBHeapEntry entry;
+   entry.time  = eventAt(index).getActionTime();
+   entry.index = index;
+   entry.order = activationCount++;
+   heapInsert(entry);
+   groupLink(index);
+}
 
-   if (eventList[storageSize].last == storageSize) {
-      eventList[storageSize].next = index;
-      eventList[storageSize].last = index;
-      eventList[index].next = storageSize;
-      eventList[index].last = storageSize;
-   } else {
-      eventList[eventList[storageSize].last].next = index;
-      eventList[index].last = eventList[storageSize].last;
-      eventList[index].next = storageSize;
-      eventList[storageSize].last = index;
-   }
+
+
+//////////////////////////////
+//
+// EventBuffer::dispatchAction -- perform the action of an event
+//    according to its type byte, without a virtual function call.
+//
+
+void EventBuffer::dispatchAction(Event& anEvent) {
+   dispatchTable[anEvent.data[0]].action(anEvent, *this);
 }
 
 
 
 //////////////////////////////
 //
-// EventBuffer::xcheck -- look at each element in the 
-// 	buffer to see if they need to be executed.
+// EventBuffer::dispatchOff -- turn off an event according to its
+//    type byte, without a virtual function call.
+//
+
+void EventBuffer::dispatchOff(Event& anEvent) {
+   dispatchTable[anEvent.data[0]].off(anEvent, *this);
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::xcheck -- perform the events whose action time
+// 	has arrived.  Only the events at the top of the heap are
+// 	looked at.  Each event acts at most once in a call; events
+// 	which are still alive afterwards (such as a note which has
+// 	been turned on) are put back into the heap at their new action
+// 	time, and dead events are removed from the buffer.
 //
 
 void EventBuffer::xcheck(void) {
@@ -117,18 +286,81 @@ void EventBuffer::xcheck(void) {
 
 
 void EventBuffer::xcheck(long currentTime) {
-   int item = eventList[storageSize].next;
-   int olditem;
-   while (item < storageSize) {
-      if (eventStorage[item].getActionTime() <= currentTime) {
-         eventStorage[item].action(*this);
+   drainSubmitted();
+   updateTouched();
+
+   int dueCount = 0;
+   int index;
+   int time;
+   while (heapCount > 0 && eventHeap[0].time <= currentTime) {
+      index = eventHeap[0].index;
+      Event& event = eventAt(index);
+      if (event.isdead()) {
+         removeEvent(index);
+         continue;
+      }
+      time = event.getActionTime();
+      if (time > currentTime) {
+         // the event was moved to a later time
+         heapUpdate(0, time);
+         continue;
+      }
+      dueList[dueCount++] = eventHeap[0];
+      heapRemove(0);
+      heapPosition(index) = -2;        // acting, not in the heap
+      dispatchTable[event.data[0]].action(event, *this);
+   }
+
+   // events which are still alive keep their activation order
+   for (int i=0; i<dueCount; i++) {
+      index = dueList[i].index;
+      heapPosition(index) = -1;
+      if (eventAt(index).isdead()) {
+         freeEvent(index);
+      } else {
+         dueList[i].time = eventAt(index).getActionTime();
+         heapInsert(dueList[i]);
+      }
+   }
+
+   // write all of the output for this tick at once
+   flush();
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::cancelGroup -- turn off all of the events in the buffer
+//    which have the given group number, and take them out of the
+//    buffer.  Notes which are sounding are sent their note-offs.
+//    Only the events of the group are visited.  Returns the number of
+//    events which were turned off.
+//
+
+int EventBuffer::cancelGroup(int aGroup) {
+   // events may have been moved to another group through operator[]
+   updateTouched();
+
+   int count = 0;
+   int index = groupFirst(aGroup);
+   int next;
+   while (index >= 0) {
+      next = groupNext(index);
+      Event& event = eventAt(index);
+      if (!event.isdead()) {
+         dispatchOff(event);
+         count++;
       }
-      olditem = item;
-      item = eventList[item].next;
-      if (eventStorage[olditem].isdead()) {
-         removeEvent(olditem);
+      if (heapPosition(index) >= 0) {
+         removeEvent(index);
       }
+      // else the event is acting in xcheck(), which will free it
+      index = next;
    }
+
+   flush();
+   return count;
 }
 
 
@@ -159,9 +391,14 @@ int EventBuffer::checkPoll(void) {
 
 int EventBuffer::countEvents(void) const {
    int count = 0;
-   for (int i = 0; i < getBufferSize(); i++) {
-      if (!eventStorage[i].isdead()) {
-         count++;
+   for (int i=0; i<chunkCount; i++) {
+      if (chunks[i] == NULL) {
+         continue;
+      }
+      for (int j=0; j<EVENTBUFFER_CHUNK_SIZE; j++) {
+         if (!chunks[i]->events[j].isdead()) {
+            count++;
+         }
       }
    }
    return count;
@@ -171,12 +408,12 @@ int EventBuffer::countEvents(void) const {
 
 //////////////////////////////
 //
-// EventBuffer::getBufferSize -- returns the maximum number of events
-//     that can be stored in the event buffer.
+// EventBuffer::getBufferSize -- returns the number of events that
+//     can be stored in the event buffer before it has to grow.
 //
 
 int EventBuffer::getBufferSize(void) const {
-   return storageSize;
+   return allocatedChunks * EVENTBUFFER_CHUNK_SIZE;
 }
 
 
@@ -188,7 +425,7 @@ int EventBuffer::getBufferSize(void) const {
 //
 
 int EventBuffer::getFreeCount(void) const {
-   return freeSlots.getCount();
+   return freeCount;
 }
 
 
@@ -204,25 +441,119 @@ int EventBuffer::getPollPeriod(void) {
 
 
 
+//////////////////////////////
+//
+// EventBuffer::getStatistics -- fill in the usage counts of the
+//     event buffer since it was created or since clearStatistics().
+//
+
+void EventBuffer::getStatistics(EventBufferStatistics& stats) const {
+   stats.size     = getBufferSize();
+   stats.used     = stats.size - freeCount;
+   stats.peak     = usedPeak;
+   stats.chunks   = allocatedChunks;
+   stats.grown    = grownCount;
+   stats.released = releasedCount;
+   stats.submitted = submittedCount;
+   stats.dropped  = submitDropped.load(std::memory_order_relaxed);
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::clearStatistics -- start counting again.  The peak
+//     starts at the number of events now in the buffer.
+//
+
+void EventBuffer::clearStatistics(void) {
+   usedPeak      = getBufferSize() - freeCount;
+   grownCount    = 0;
+   releasedCount = 0;
+   submittedCount = 0;
+   submitDropped.store(0, std::memory_order_relaxed);
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::getThreadWaitTime -- returns the shortest getWaitTime()
+//    of the buffers which were created by the calling thread, or -1 if
+//    none of them have any active events.  Buffers of other threads are
+//    skipped, since only their owners may look at their events.
+//    (static function)
+//
+
+double EventBuffer::getThreadWaitTime(void) {
+   std::thread::id self = std::this_thread::get_id();
+   double output = -1.0;
+   double wait;
+   std::lock_guard<std::mutex> lock(bufferListLock);
+   for (EventBuffer* buffer = bufferList; buffer != NULL;
+         buffer = buffer->nextBuffer) {
+      if (buffer->ownerThread != self) {
+         continue;
+      }
+      wait = buffer->getWaitTime();
+      if (wait >= 0.0 && (output < 0.0 || wait < output)) {
+         output = wait;
+      }
+   }
+   return output;
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::getWaitTime -- returns the number of milliseconds until
+//    an event in the buffer is due to act, 0 if an event is due now or
+//    if events are waiting to be moved into the buffer at the next
+//    xcheck(), or -1 if the buffer has no active events.  The time is
+//    never earlier than the next time that checkPoll() will look at the
+//    buffer.  Events submitted later by other threads are not known.
+//
+
+double EventBuffer::getWaitTime(void) {
+   double output = -1.0;
+   if (touchedCount > 0 || submitQueue[submitHead & (submitSize - 1)].
+         sequence.load(std::memory_order_acquire) == submitHead + 1) {
+      output = 0.0;
+   } else if (heapCount > 0) {
+      output = (double)eventHeap[0].time - timer.getTime();
+      if (output < 0.0) {
+         output = 0.0;
+      }
+   } else {
+      return output;
+   }
+   double poll = pollTimer.getPeriod() - pollTimer.getTime();
+   if (poll > output) {
+      output = poll;
+   }
+   return output;
+}
+
+
+
 //////////////////////////////
 //
 // EventBuffer::insert -- returns the location in the buffer
-//    where item was stored.
+//    where item was stored.  The buffer grows if it is full.
 //
 
 int EventBuffer::insert(const Event* newEvent) {
-   int freeSpot = 0;
-   freeSlots.extract(freeSpot);
-   eventStorage[freeSpot] = *newEvent;
+   int freeSpot = allocateEvent();
+   eventAt(freeSpot) = *newEvent;
    activate(freeSpot);
    return freeSpot;
 }
 
 
 int EventBuffer::insert(const Event& newEvent) {
-   int freeSpot = 0;
-   freeSlots.extract(freeSpot);
-   memcpy((void*)&eventStorage[freeSpot], (void*)&newEvent, sizeof(Event));
+   int freeSpot = allocateEvent();
+   eventAt(freeSpot) = newEvent;
    activate(freeSpot);
    return freeSpot;
 }
@@ -235,13 +566,11 @@ int EventBuffer::insert(const Event& newEvent) {
 //
 
 void EventBuffer::off(void) {
-   int item = eventList[storageSize].next;
-   int olditem;
-   while (item < storageSize) {
-      eventStorage[item].off(*this);
-      olditem = item;
-      item = eventList[item].next;
-      removeEvent(olditem);
+   int index;
+   while (heapCount > 0) {
+      index = eventHeap[heapCount - 1].index;
+      dispatchOff(eventAt(index));
+      removeEvent(index);
    }
 }
 
@@ -249,36 +578,38 @@ void EventBuffer::off(void) {
 
 //////////////////////////////
 //
-// EventBuffer::operator[] --
+// EventBuffer::operator[] -- the event may be changed through the
+//    returned reference, so its place in the heap is checked again
+//    at the next xcheck().
 //
 
 Event& EventBuffer::operator[](int index) {
-   if (index < 0 || index >= storageSize) {
+   if (!validIndex(index)) {
       cout << "Error: invalid index for accessing EventBuffer" << endl;
       exit(1);
    }
-   return eventStorage[index];
+   if (!touchedQ(index)) {
+      touchedQ(index) = 1;
+      touchedList[touchedCount++] = index;
+   }
+   return eventAt(index);
 }
 
 
 
 //////////////////////////////
 //
-// EventBuffer::print -- print a list of the current items
+// EventBuffer::print -- print a list of the current items, in heap
+//    order (the next event to act is first).
 //
 
 void EventBuffer::print(void) const {
-   int counter = 0;
    cout << "Active elements in event buffer: " << '\n';
-   int item = storageSize;
-   item = eventList[item].next;
-   while (item < storageSize) {
-      cout << item << ' ';
-      counter++;
-      if (counter % 20 == 0) {
+   for (int i=0; i<heapCount; i++) {
+      cout << eventHeap[i].index << ' ';
+      if ((i + 1) % 20 == 0) {
          cout << '\n';
       }
-      item = eventList[item].next;
    }
    cout << endl;
 }
@@ -287,25 +618,79 @@ void EventBuffer::print(void) const {
 
 //////////////////////////////
 //
-// EventBuffer::reset --
+// EventBuffer::rescheduleGroup -- move all of the events in the buffer
+//    which have the given group number by delta milliseconds (earlier
+//    if delta is negative).  For notes which are sounding, the note-off
+//    is moved.  Only the events of the group are visited.  Returns the
+//    number of events which were moved.
 //
 
-void EventBuffer::reset(void) {
-   freeSlots.reset();
+int EventBuffer::rescheduleGroup(int aGroup, int delta) {
+   updateTouched();
 
-   for (int i=0; i<storageSize; i++) {
+   int count = 0;
+   int index = groupFirst(aGroup);
+   while (index >= 0) {
+      Event& event = eventAt(index);
+      if (!event.isdead()) {
+         event.setTime1(event.getTime1() + delta);
+         if (heapPosition(index) >= 0) {
+            heapUpdate(heapPosition(index), event.getActionTime());
+         }
+         count++;
+      }
+      index = groupNext(index);
+   }
 
-      // erase all storage cells
-      eventStorage[i].setType(0);
-      eventStorage[i].setStatus(0);
+   return count;
+}
 
-      eventList[i].next = storageSize;
-      eventList[i].last = storageSize;
 
-      freeSlots.insert(i);
+
+//////////////////////////////
+//
+// EventBuffer::reset -- erase all of the events.  Chunks above the
+//     size of the buffer given to setBufferSize() are given back.
+//
+
+void EventBuffer::reset(void) {
+   int i, j;
+   for (i=chunkCount-1; i>=minChunks; i--) {
+      if (chunks[i] != NULL) {
+         releaseChunk(i);
+      }
+   }
+   freeCount = 0;
+   for (i=0; i<minChunks; i++) {
+      _EBChunk& chunk = *chunks[i];
+      for (j=0; j<EVENTBUFFER_CHUNK_SIZE; j++) {
+
+         // erase all storage cells
+         chunk.events[j].setType(0);
+         chunk.events[j].setStatus(0);
+
+         chunk.heapPosition[j] = -1;
+         chunk.touchedQ[j] = 0;
+         chunk.groupOf[j] = -1;
+
+         // the lowest spaces are used first
+         chunk.freeList[j] = EVENTBUFFER_CHUNK_SIZE - 1 - j;
+      }
+      chunk.freeCount = EVENTBUFFER_CHUNK_SIZE;
+      freeCount += EVENTBUFFER_CHUNK_SIZE;
    } 
-   eventList[storageSize].next = storageSize;   // top of list
-   eventList[storageSize].last = storageSize;   // bottom of list
+   for (i=0; i<256; i++) {
+      if (groupHeads[i] != NULL) {
+         delete [] groupHeads[i];
+         groupHeads[i] = NULL;
+      }
+   }
+   emptyChunks = allocatedChunks;
+   firstFree = 0;
+   heapCount = 0;
+   touchedCount = 0;
+   activationCount = 0;
+   clearStatistics();
 
    pollTimer.reset();
 }
@@ -314,7 +699,9 @@ void EventBuffer::reset(void) {
 
 //////////////////////////////
 //
-// EventBuffer::setBufferSize --
+// EventBuffer::setBufferSize -- set the number of events which the
+//     buffer holds without growing.  The buffer never gives back the
+//     chunks below this size.  Events already in the buffer are kept.
 //
 
 void EventBuffer::setBufferSize(int aSize) {
@@ -323,18 +710,55 @@ void EventBuffer::setBufferSize(int aSize) {
       exit(1);
    }
 
-   storageSize = aSize;
-   if (eventStorage != NULL) {
-      delete [] eventStorage;
+   minChunks = (aSize + EVENTBUFFER_CHUNK_SIZE - 1) / EVENTBUFFER_CHUNK_SIZE;
+   for (int i=0; i<minChunks; i++) {
+      if (i >= chunkCount || chunks[i] == NULL) {
+         addChunk();
+      }
    }
-   eventStorage = new Event[storageSize];
-   if (eventList != NULL) {
-      delete [] eventList;
+   releaseEmptyChunks();
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::submit -- schedule an event from any thread.  The event
+//    is copied into the submit() queue, and it is put into the buffer
+//    by the next xcheck() of the owner thread.  The event should be
+//    activated before it is submitted, as for insert().  Returns 1 if
+//    the event was queued, or 0 if the queue was full.  Never blocks.
+//
+
+int EventBuffer::submit(const Event* anEvent) {
+   return submit(*anEvent);
+}
+
+
+int EventBuffer::submit(const Event& anEvent) {
+   uint64_t position = submitTail.load(std::memory_order_relaxed);
+   _EBQueueCell* cell;
+   while (1) {
+      cell = &submitQueue[position & (submitSize - 1)];
+      uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+      int64_t difference = (int64_t)sequence - (int64_t)position;
+      if (difference == 0) {
+         if (submitTail.compare_exchange_weak(position, position + 1,
+               std::memory_order_relaxed)) {
+            break;
+         }
+      } else if (difference < 0) {
+         // the queue is full
+         submitDropped.fetch_add(1, std::memory_order_relaxed);
+         return 0;
+      } else {
+         position = submitTail.load(std::memory_order_relaxed);
+      }
    }
 
-   eventList = new _EBPrivate[storageSize + 1];
-   freeSlots.setSize(storageSize);
-   reset();
+   memcpy(cell->data, anEvent.data, sizeof(cell->data));
+   cell->sequence.store(position + 1, std::memory_order_release);
+   return 1;
 }
 
 
@@ -357,25 +781,448 @@ void EventBuffer::setPollPeriod(double aPeriod) {
 
 //////////////////////////////
 //
-// EventBuffer::removeEvent -- take an event out of the linked list.
+// EventBuffer::addChunk -- allocate a chunk of empty events in the
+//    first unused place in the chunk table.  The heap and the lists
+//    are made larger if needed; the events themselves are never moved.
+//    Returns the chunk number.
+//
+
+int EventBuffer::addChunk(void) {
+   int i;
+   int chunk = 0;
+   while (chunk < chunkCount && chunks[chunk] != NULL) {
+      chunk++;
+   }
+
+   if (chunk == chunkCount) {
+      int newCount = chunkCount == 0 ? 1 : chunkCount * 2;
+      _EBChunk** newChunks = new _EBChunk*[newCount];
+      for (i=0; i<newCount; i++) {
+         newChunks[i] = i < chunkCount ? chunks[i] : NULL;
+      }
+      if (chunks != NULL) {
+         delete [] chunks;
+      }
+      chunks = newChunks;
+      chunkCount = newCount;
+   }
+
+   int newSize = chunkCount * EVENTBUFFER_CHUNK_SIZE;
+   if (newSize > listSize) {
+      _EBHeapEntry* newHeap = new _EBHeapEntry[newSize];
+      _EBHeapEntry* newDue  = new _EBHeapEntry[newSize];
+      int* newTouched       = new int[newSize];
+      if (listSize > 0) {
+         memcpy(newHeap, eventHeap, listSize * sizeof(_EBHeapEntry));
+         memcpy(newDue, dueList, listSize * sizeof(_EBHeapEntry));
+         memcpy(newTouched, touchedList, listSize * sizeof(int));
+         delete [] eventHeap;
+         delete [] dueList;
+         delete [] touchedList;
+      }
+      eventHeap   = newHeap;
+      dueList     = newDue;
+      touchedList = newTouched;
+      listSize    = newSize;
+   }
+
+   _EBChunk* newChunk = new _EBChunk;
+   for (i=0; i<EVENTBUFFER_CHUNK_SIZE; i++) {
+      newChunk->events[i].setType(0);
+      newChunk->events[i].setStatus(0);
+      newChunk->heapPosition[i] = -1;
+      newChunk->touchedQ[i] = 0;
+      newChunk->groupOf[i] = -1;
+      newChunk->freeList[i] = EVENTBUFFER_CHUNK_SIZE - 1 - i;
+   }
+   newChunk->freeCount = EVENTBUFFER_CHUNK_SIZE;
+   chunks[chunk] = newChunk;
+
+   allocatedChunks++;
+   emptyChunks++;
+   freeCount += EVENTBUFFER_CHUNK_SIZE;
+   if (chunk < firstFree) {
+      firstFree = chunk;
+   }
+   return chunk;
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::allocateEvent -- take a free space out of the lowest
+//    chunk which has one, adding a chunk if the buffer is full.
+//
+
+int EventBuffer::allocateEvent(void) {
+   if (freeCount == 0) {
+      addChunk();
+      grownCount++;
+   }
+   while (chunks[firstFree] == NULL || chunks[firstFree]->freeCount == 0) {
+      firstFree++;
+   }
+
+   _EBChunk& chunk = *chunks[firstFree];
+   if (chunk.freeCount == EVENTBUFFER_CHUNK_SIZE) {
+      emptyChunks--;
+   }
+   int index = (firstFree << EVENTBUFFER_CHUNK_BITS) |
+         chunk.freeList[--chunk.freeCount];
+   freeCount--;
+
+   int used = getBufferSize() - freeCount;
+   if (used > usedPeak) {
+      usedPeak = used;
+   }
+   return index;
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::freeEvent -- make the space of an event reuseable.  If
+//    its chunk is then empty, it is given back when there is another
+//    empty chunk and it is above the size of the buffer.
+//
+
+void EventBuffer::freeEvent(int index) {
+   groupUnlink(index);
+   int chunkIndex = index >> EVENTBUFFER_CHUNK_BITS;
+   _EBChunk& chunk = *chunks[chunkIndex];
+   chunk.freeList[chunk.freeCount++] = index & EVENTBUFFER_CHUNK_MASK;
+   freeCount++;
+   if (chunkIndex < firstFree) {
+      firstFree = chunkIndex;
+   }
+   if (chunk.freeCount == EVENTBUFFER_CHUNK_SIZE) {
+      emptyChunks++;
+      if (emptyChunks > 1 && chunkIndex >= minChunks) {
+         releaseChunk(chunkIndex);
+      }
+   }
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::drainSubmitted -- move the events from the submit()
+//    queue into the buffer, in the order in which they were queued.
+//    Called by the owner thread at the start of xcheck().
+//
+
+void EventBuffer::drainSubmitted(void) {
+   _EBQueueCell* cell;
+   int index;
+   while (1) {
+      cell = &submitQueue[submitHead & (submitSize - 1)];
+      if (cell->sequence.load(std::memory_order_acquire) != submitHead + 1) {
+         // empty, or the next event is still being copied
+         break;
+      }
+      index = allocateEvent();
+      memcpy(eventAt(index).data, cell->data, sizeof(cell->data));
+      cell->sequence.store(submitHead + submitSize,
+            std::memory_order_release);
+      submitHead++;
+      submittedCount++;
+      activate(index);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::groupFirst -- returns the first event in the list of a
+//    group, or -1 if the group has no events.
+//
+
+int EventBuffer::groupFirst(int aGroup) const {
+   aGroup &= 0xffff;
+   int* block = groupHeads[aGroup >> 8];
+   if (block == NULL) {
+      return -1;
+   }
+   return block[aGroup & 0xff];
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::groupLink -- add an event to the list of its group.
+//
+
+void EventBuffer::groupLink(int index) {
+   int group = eventAt(index).getGroup();
+   int*& block = groupHeads[group >> 8];
+   if (block == NULL) {
+      block = new int[256];
+      for (int i=0; i<256; i++) {
+         block[i] = -1;
+      }
+   }
+   int first = block[group & 0xff];
+   groupOf(index)   = group;
+   groupPrev(index) = -1;
+   groupNext(index) = first;
+   if (first >= 0) {
+      groupPrev(first) = index;
+   }
+   block[group & 0xff] = index;
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::groupUnlink -- take an event out of the list of its
+//    group, if it is in one.
+//
+
+void EventBuffer::groupUnlink(int index) {
+   int group = groupOf(index);
+   if (group < 0) {
+      return;
+   }
+   int previous = groupPrev(index);
+   int next = groupNext(index);
+   if (previous >= 0) {
+      groupNext(previous) = next;
+   } else {
+      groupHeads[group >> 8][group & 0xff] = next;
+   }
+   if (next >= 0) {
+      groupPrev(next) = previous;
+   }
+   groupOf(index) = -1;
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::heapInsert -- add an event to the heap.
+//
+
+void EventBuffer::heapInsert(const _EBHeapEntry& entry) {
+   int position = heapCount++;
+   eventHeap[position] = entry;
+   heapPosition(entry.index) = position;
+   siftUp(position);
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::heapRemove -- take the event at the given place out of
+//    the heap.  The last event is moved into its place.
+//
+
+void EventBuffer::heapRemove(int position) {
+   heapPosition(eventHeap[position].index) = -1;
+   heapCount--;
+   if (position == heapCount) {
+      return;
+   }
+   eventHeap[position] = eventHeap[heapCount];
+   if (position > 0 && actsBefore(eventHeap[position],
+         eventHeap[(position - 1) / 2])) {
+      siftUp(position);
+   } else {
+      siftDown(position);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::heapUpdate -- change the action time of the event at
+//    the given place in the heap.
+//
+
+void EventBuffer::heapUpdate(int position, int time) {
+   int oldtime = eventHeap[position].time;
+   eventHeap[position].time = time;
+   if (time < oldtime) {
+      siftUp(position);
+   } else if (time > oldtime) {
+      siftDown(position);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::releaseChunk -- give back an empty chunk.
+//
+
+void EventBuffer::releaseChunk(int chunk) {
+   int first = chunk << EVENTBUFFER_CHUNK_BITS;
+   int count = 0;
+   for (int i=0; i<touchedCount; i++) {
+      if (touchedList[i] < first ||
+            touchedList[i] >= first + EVENTBUFFER_CHUNK_SIZE) {
+         touchedList[count++] = touchedList[i];
+      }
+   }
+   touchedCount = count;
+
+   delete chunks[chunk];
+   chunks[chunk] = NULL;
+   allocatedChunks--;
+   emptyChunks--;
+   freeCount -= EVENTBUFFER_CHUNK_SIZE;
+   releasedCount++;
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::releaseEmptyChunks -- give back the empty chunks above
+//    the size of the buffer, except for one kept in reserve.
+//
+
+void EventBuffer::releaseEmptyChunks(void) {
+   for (int i=chunkCount-1; i>=minChunks && emptyChunks>1; i--) {
+      if (chunks[i] != NULL &&
+            chunks[i]->freeCount == EVENTBUFFER_CHUNK_SIZE) {
+         releaseChunk(i);
+      }
+   }
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::removeEvent -- take an event out of the heap
 //    and make its location reuseable.
 //
 
 void EventBuffer::removeEvent(int index) {
-   if (index < 0 || index >= storageSize) {
+   if (!validIndex(index)) {
       cout << "Error: cannot remove event " << index << endl;
       exit(1);
    }
- 
-   eventList[eventList[index].next].last = eventList[index].last;
-   eventList[eventList[index].last].next = eventList[index].next;
 
-   eventList[index].next = storageSize;
-   eventList[index].last = storageSize;
+   if (heapPosition(index) >= 0) {
+      heapRemove(heapPosition(index));
+   }
+   heapPosition(index) = -1;
 
-   freeSlots.insert(index);
+   freeEvent(index);
 }
 
 
 
+//////////////////////////////
+//
+// EventBuffer::siftDown -- move an event down the heap until neither
+//    of its children acts before it.
+//
+
+void EventBuffer::siftDown(int position) {
+   _EBHeapEntry entry = eventHeap[position];
+   int child;
+   while ((child = 2 * position + 1) < heapCount) {
+      if (child + 1 < heapCount &&
+            actsBefore(eventHeap[child + 1], eventHeap[child])) {
+         child++;
+      }
+      if (!actsBefore(eventHeap[child], entry)) {
+         break;
+      }
+      eventHeap[position] = eventHeap[child];
+      heapPosition(eventHeap[position].index) = position;
+      position = child;
+   }
+   eventHeap[position] = entry;
+   heapPosition(entry.index) = position;
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::siftUp -- move an event up the heap until its parent
+//    does not act after it.
+//
+
+void EventBuffer::siftUp(int position) {
+   _EBHeapEntry entry = eventHeap[position];
+   int parent;
+   while (position > 0) {
+      parent = (position - 1) / 2;
+      if (!actsBefore(entry, eventHeap[parent])) {
+         break;
+      }
+      eventHeap[position] = eventHeap[parent];
+      heapPosition(eventHeap[position].index) = position;
+      position = parent;
+   }
+   eventHeap[position] = entry;
+   heapPosition(entry.index) = position;
+}
+
+
+
+//////////////////////////////
+//
+// EventBuffer::updateTouched -- bring the heap up to date for the
+//    events which were reached through operator[] since the last
+//    xcheck(): dead events are removed, the others are moved to
+//    their current action time, and events whose group number was
+//    changed are moved to the list of their new group.
+//
+
+void EventBuffer::updateTouched(void) {
+   int index;
+   // taken from the end, since removing an event may give back a chunk,
+   // which takes the events of the chunk out of the list
+   while (touchedCount > 0) {
+      index = touchedList[--touchedCount];
+      touchedQ(index) = 0;
+      if (groupOf(index) >= 0 && groupOf(index) != eventAt(index).getGroup()) {
+         // the group number was changed
+         groupUnlink(index);
+         groupLink(index);
+      }
+      if (heapPosition(index) < 0) {
+         // not active, or acting in this xcheck()
+         continue;
+      }
+      if (eventAt(index).isdead()) {
+         removeEvent(index);
+      } else {
+         heapUpdate(heapPosition(index), eventAt(index).getActionTime());
+      }
+   }
+}
+
+
+
+
+//////////////////////////////
+//
+// EventBuffer::validIndex -- returns true if the index is a space in
+//    an allocated chunk.
+//
+
+int EventBuffer::validIndex(int index) const {
+   if (index < 0 || (index >> EVENTBUFFER_CHUNK_BITS) >= chunkCount) {
+      return 0;
+   }
+   return chunks[index >> EVENTBUFFER_CHUNK_BITS] != NULL;
+}
+
+
 // md5sum: 3560058918ace3d8710541828823e2f9 EventBuffer.cpp [20050403]
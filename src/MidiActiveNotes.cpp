@@ -0,0 +1,204 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 19:27:03 PDT 2026
+// Last Modified: Sat Oct 17 19:27:03 PDT 2026
+// Filename:      ...sig/maint/code/control/MidiOutput/MidiActiveNotes.cpp
+// Web Address:   http://sig.sapp.org/src/sig/MidiActiveNotes.cpp
+// Syntax:        C++11
+//
+// Description:   Keeps track of the notes which are sounding on a MIDI
+//                output port.
+//
+
+#include "MidiActiveNotes.h"
+
+
+//////////////////////////////
+//
+// MidiActiveNotes::MidiActiveNotes -- no notes are sounding.
+//
+
+MidiActiveNotes::MidiActiveNotes(void) {
+   for (int i=0; i<16; i++) {
+      for (int j=0; j<128; j++) {
+         noteCount[i][j].store(0);
+      }
+      channelCount[i].store(0);
+   }
+   totalCount.store(0);
+}
+
+
+
+//////////////////////////////
+//
+// MidiActiveNotes::clear -- forget the sounding notes on all channels,
+//     or on one channel.
+//
+
+void MidiActiveNotes::clear(void) {
+   for (int i=0; i<16; i++) {
+      clear(i);
+   }
+}
+
+
+void MidiActiveNotes::clear(int channel) {
+   channel &= 0x0f;
+   if (channelCount[channel].load(std::memory_order_relaxed) == 0) {
+      return;
+   }
+   for (int i=0; i<128; i++) {
+      if (noteCount[channel][i].load(std::memory_order_relaxed) != 0 &&
+            noteCount[channel][i].exchange(0) != 0) {
+         channelCount[channel]--;
+         totalCount--;
+      }
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiActiveNotes::getActiveCount -- returns the number of sounding
+//     keys on the port, or on one channel.
+//
+
+int MidiActiveNotes::getActiveCount(void) const {
+   return totalCount.load(std::memory_order_relaxed);
+}
+
+
+int MidiActiveNotes::getActiveCount(int channel) const {
+   return channelCount[channel & 0x0f].load(std::memory_order_relaxed);
+}
+
+
+
+//////////////////////////////
+//
+// MidiActiveNotes::getNoteCount -- returns the number of note-ons for
+//     the key which have not been turned off.  This is more than 1 if
+//     the key was played again before it was released.
+//
+
+int MidiActiveNotes::getNoteCount(int channel, int key) const {
+   return noteCount[channel & 0x0f][key & 0x7f].load(
+         std::memory_order_relaxed);
+}
+
+
+
+//////////////////////////////
+//
+// MidiActiveNotes::isSounding -- returns true if a note-on for the key
+//     has been sent without a matching note-off.
+//
+
+int MidiActiveNotes::isSounding(int channel, int key) const {
+   return getNoteCount(channel, key) != 0;
+}
+
+
+
+//////////////////////////////
+//
+// MidiActiveNotes::update -- follow a MIDI message which was sent on the
+//     port.  Note-ons add to the count for the key and note-offs (or
+//     note-ons with a velocity of 0) take one away.  The All Sound Off,
+//     All Notes Off and mode change controllers clear the channel, and
+//     a system reset clears the port.
+//
+
+void MidiActiveNotes::update(const uchar* data, int size) {
+   if (size < 1) {
+      return;
+   }
+   int channel = data[0] & 0x0f;
+   switch (data[0] & 0xf0) {
+      case 0x80:
+         if (size >= 3) {
+            noteOff(channel, data[1] & 0x7f);
+         }
+         break;
+
+      case 0x90:
+         if (size < 3) {
+            break;
+         }
+         if (data[2] == 0) {
+            noteOff(channel, data[1] & 0x7f);
+         } else {
+            noteOn(channel, data[1] & 0x7f);
+         }
+         break;
+
+      case 0xb0:
+         // 120 = all sound off, 123 = all notes off, 124-127 = omni and
+         // mono/poly mode changes, which also turn off all notes
+         if (size >= 3 && (data[1] == 120 || data[1] >= 123)) {
+            clear(channel);
+         }
+         break;
+
+      case 0xf0:
+         if (data[0] == 0xff) {
+            clear();
+         }
+         break;
+   }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// private functions
+//
+
+
+//////////////////////////////
+//
+// MidiActiveNotes::noteOff -- take one away from the note count of the
+//     key.  A note-off for a key which is not sounding is ignored.
+//
+
+void MidiActiveNotes::noteOff(int channel, int key) {
+   std::atomic<uint8_t>& count = noteCount[channel][key];
+   uint8_t old = count.load(std::memory_order_relaxed);
+   do {
+      if (old == 0) {
+         return;
+      }
+   } while (!count.compare_exchange_weak(old, old - 1));
+   if (old == 1) {
+      channelCount[channel]--;
+      totalCount--;
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiActiveNotes::noteOn -- add one to the note count of the key.
+//     The count stops at 255.
+//
+
+void MidiActiveNotes::noteOn(int channel, int key) {
+   std::atomic<uint8_t>& count = noteCount[channel][key];
+   uint8_t old = count.load(std::memory_order_relaxed);
+   do {
+      if (old == 255) {
+         return;
+      }
+   } while (!count.compare_exchange_weak(old, old + 1));
+   if (old == 0) {
+      channelCount[channel]++;
+      totalCount++;
+   }
+}
+
+
+
@@ -0,0 +1,653 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 21:16:52 PDT 2026
+// Last Modified: Sat Oct 17 21:16:52 PDT 2026
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026 (input recording, binary log)
+// Filename:      ...sig/maint/code/control/MidiFileWrite/MidiFileRecorder.cpp
+// Web Address:   http://sig.sapp.org/src/sig/MidiFileRecorder.cpp
+// Syntax:        C++11
+//
+// Description:   Records MIDI messages into a Standard MIDI File (or a
+//                binary log) on a background thread.
+//
+
+#include "MidiFileRecorder.h"
+#include "SigTimer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <unistd.h>
+
+#ifndef OLDCPP
+   #include <fstream>
+   #include <iostream>
+   using namespace std;
+#else
+   #include <fstream.h>
+   #include <iostream.h>
+#endif
+
+// microseconds that the encoder thread sleeps when the ring is empty
+#define RECORD_IDLE_TIME (5000)
+
+// bytes of a message stored in the first cell, after the header
+#define FIRST_CELL_BYTES ((int)(24 - sizeof(MidiFileRecorder::Header)))
+
+// number of cells used by a message of the given size
+#define CELLS_FOR_SIZE(size) (1 + ((size) > FIRST_CELL_BYTES ? \
+      ((size) - FIRST_CELL_BYTES + 23) / 24 : 0))
+
+// MIDI file time: 1000 ticks per quarter note at 1000000 microseconds
+// per quarter note, so one tick is one millisecond
+#define RECORD_DIVISION (1000)
+#define RECORD_TEMPO    (1000000)
+#define TICK_NANOSECONDS ((int64_t)RECORD_TEMPO * 1000 / RECORD_DIVISION)
+
+// tracks of input ports come after the tracks of output ports
+#define INPUT_TRACK_OFFSET (0x10000)
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::MidiFileRecorder -- allocate the ring of cells.
+//     The number of cells is rounded up to a power of two.
+//     default value: cellCount = MIDI_RECORD_CELLS
+//
+
+MidiFileRecorder::MidiFileRecorder(int cellCount) {
+   this->cellCount = 64;
+   while (this->cellCount < cellCount) {
+      this->cellCount *= 2;
+   }
+   cells = new Cell[this->cellCount];
+   // the sequences are only set up here, since a record() which is
+   // still running after stop() may use a cell at any time
+   for (int i=0; i<this->cellCount; i++) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+   }
+   tail.store(0);
+   head = 0;
+   recording.store(0);
+   running.store(0);
+   lost.store(0);
+   trackMode = MIDI_RECORD_ONE_TRACK;
+   startTime = 0;
+   logTime = 0;
+   writeStatus = 0;
+}
+
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::~MidiFileRecorder -- write the file if the
+//     recording has not been stopped yet.
+//
+
+MidiFileRecorder::~MidiFileRecorder() {
+   stop();
+   delete [] cells;
+   cells = NULL;
+}
+
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::getLostCount -- returns the number of messages
+//     which were not recorded because the ring was full.
+//
+
+int64_t MidiFileRecorder::getLostCount(void) const {
+   return lost.load(std::memory_order_relaxed);
+}
+
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::isRecording -- returns true between start() and
+//     stop().
+//
+
+int MidiFileRecorder::isRecording(void) const {
+   return recording.load(std::memory_order_relaxed);
+}
+
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::record -- add a message sent to an output port to
+//     the recording.  This function may be called from any thread, and
+//     does not block, allocate memory or do I/O.  If the timestamp is
+//     0, the current time is used.  Messages are ignored when not
+//     recording.
+//     default value: timestamp = 0
+//
+
+void MidiFileRecorder::record(int port, const uchar* data, int size,
+      int64_t timestamp) {
+   store(port, 0, data, size, timestamp);
+}
+
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::recordInput -- add a message which arrived on an
+//     input port to the recording.  The timestamp should be the arrival
+//     time of the message (CLOCK_MONOTONIC nanoseconds).
+//     default value: timestamp = 0
+//
+
+void MidiFileRecorder::recordInput(int port, const uchar* data, int size,
+      int64_t timestamp) {
+   store(port, 1, data, size, timestamp);
+}
+
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::start -- start recording into the given file.  The
+//     file is written when stop() is called.  trackMode is one of
+//     MIDI_RECORD_ONE_TRACK, MIDI_RECORD_BY_PORT or
+//     MIDI_RECORD_BY_CHANNEL, or MIDI_RECORD_LOG for a binary log which
+//     is written while recording.  Returns 0 if the log file could not
+//     be opened or the encoder thread could not be started.
+//     default value: trackMode = MIDI_RECORD_ONE_TRACK
+//
+
+int MidiFileRecorder::start(const char* filename, int trackMode) {
+   stop();
+
+   this->filename = filename;
+   this->trackMode = trackMode;
+   tracks.clear();
+   writeStatus = 0;
+   startTime = SigTimer::getMonotonicTime();
+   logTime = 0;
+
+   if (trackMode == MIDI_RECORD_LOG) {
+      logFile.clear();
+      logFile.open(filename, ios::out | ios::binary | ios::trunc);
+      if (!logFile.is_open()) {
+         cerr << "Error: cannot open file " << filename << endl;
+         return 0;
+      }
+      logFile.write("MLOG", 4);
+   }
+
+   running.store(1);
+   int flag = pthread_create(&encoderThread, NULL, encodeMidiFilePrivate,
+         this);
+   if (flag != 0) {
+      running.store(0);
+      if (logFile.is_open()) {
+         logFile.close();
+      }
+      cerr << "Error: cannot start MIDI file recording thread" << endl;
+      return 0;
+   }
+   recording.store(1);
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::stop -- stop recording, encode the messages which
+//     are waiting and write the file (or finish the log).  Returns 1 if
+//     the file was written.
+//
+
+int MidiFileRecorder::stop(void) {
+   recording.store(0);
+   if (!running.load()) {
+      return writeStatus;
+   }
+   running.store(0);
+   pthread_join(encoderThread, NULL);
+   return writeStatus;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// private functions
+//
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::addEvent -- add a MIDI event to the track for the
+//     given port or channel.
+//
+
+void MidiFileRecorder::addEvent(int key, int64_t tick, const uchar* data,
+      int size) {
+   Track& track = tracks[key];
+   if (track.data.empty()) {
+      track.lastTick = 0;
+   }
+   if (tick < track.lastTick) {
+      tick = track.lastTick;
+   }
+   addVLValue(track.data, tick - track.lastTick);
+   track.lastTick = tick;
+   track.data.insert(track.data.end(), data, data + size);
+}
+
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::addVLValue -- append a variable-length value: 7
+//     bits per byte, most significant first, with the top bit set on
+//     all but the last byte.
+//
+
+void MidiFileRecorder::addVLValue(std::vector<uchar>& data, int64_t aValue) {
+   if (aValue < 0) {
+      aValue = 0;
+   } else if (aValue > 0x0fffffff) {
+      aValue = 0x0fffffff;
+   }
+   uchar bytes[4];
+   int count = 0;
+   do {
+      bytes[count++] = (uchar)(aValue & 0x7f);
+      aValue >>= 7;
+   } while (aValue > 0);
+   while (count > 1) {
+      data.push_back(bytes[--count] | 0x80);
+   }
+   data.push_back(bytes[0]);
+}
+
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::drain -- encode all of the complete messages in the
+//     ring.  Only called by the encoder thread.  Returns the number of
+//     messages encoded.
+//
+
+int MidiFileRecorder::drain(void) {
+   std::vector<uchar> message;
+   Header header;
+   int count, amount, offset;
+   int output = 0;
+   while (1) {
+      Cell& first = cells[head & (cellCount - 1)];
+      if (first.sequence.load(std::memory_order_acquire) != head + 1) {
+         break;
+      }
+      memcpy(&header, first.bytes, sizeof(Header));
+      count = CELLS_FOR_SIZE(header.size);
+      message.resize(header.size);
+      amount = header.size < FIRST_CELL_BYTES ? header.size :
+            FIRST_CELL_BYTES;
+      memcpy(message.data(), first.bytes + sizeof(Header), amount);
+      offset = amount;
+      for (int i=1; i<count; i++) {
+         amount = header.size - offset < 24 ? header.size - offset : 24;
+         memcpy(message.data() + offset,
+               cells[(head + i) & (cellCount - 1)].bytes, amount);
+         offset += amount;
+      }
+      for (int i=0; i<count; i++) {
+         cells[(head + i) & (cellCount - 1)].sequence.store(
+               head + i + cellCount, std::memory_order_release);
+      }
+      head += count;
+
+      encode(header, message.data());
+      output++;
+   }
+   return output;
+}
+
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::encode -- add a recorded message to its track.  A
+//     message may contain several channel messages in a row.  Messages
+//     from before the start of the recording are ignored.
+//
+
+void MidiFileRecorder::encode(const Header& header, const uchar* data) {
+   if (header.time < startTime) {
+      return;
+   }
+   if (trackMode == MIDI_RECORD_LOG) {
+      encodeLog(header, data);
+      return;
+   }
+   int64_t tick = (header.time - startTime) / TICK_NANOSECONDS;
+   int size = header.size;
+   int key = 0;
+   int portKey = header.port + (header.input ? INPUT_TRACK_OFFSET : 0);
+
+   if (data[0] == 0xf0) {
+      // sysex: F0, length of the rest of the message, rest of message
+      std::vector<uchar> event;
+      event.push_back(0xf0);
+      addVLValue(event, size - 1);
+      event.insert(event.end(), data + 1, data + size);
+      if (trackMode == MIDI_RECORD_BY_PORT) {
+         key = portKey;
+      } else if (trackMode == MIDI_RECORD_BY_CHANNEL) {
+         key = 16;
+      }
+      addEvent(key, tick, event.data(), (int)event.size());
+      return;
+   }
+
+   int i = 0;
+   int length;
+   while (i < size && data[i] >= 0x80 && data[i] < 0xf0) {
+      length = ((data[i] & 0xf0) == 0xc0 || (data[i] & 0xf0) == 0xd0) ? 2 : 3;
+      if (i + length > size) {
+         break;
+      }
+      if (trackMode == MIDI_RECORD_BY_PORT) {
+         key = portKey;
+      } else if (trackMode == MIDI_RECORD_BY_CHANNEL) {
+         key = data[i] & 0x0f;
+      }
+      addEvent(key, tick, data + i, length);
+      i += length;
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::encodeLog -- write a record for the message into
+//     the binary log.  All messages are kept, including real-time and
+//     system common messages.
+//
+
+void MidiFileRecorder::encodeLog(const Header& header, const uchar* data) {
+   // times are kept in whole microseconds from the start so that
+   // rounding does not add up over the recording
+   int64_t microseconds = (header.time - startTime) / 1000;
+   if (microseconds < logTime) {
+      microseconds = logTime;
+   }
+   std::vector<uchar> record;
+   record.reserve(header.size + 12);
+   addVLValue(record, microseconds - logTime);
+   addVLValue(record, header.port * 2 + header.input);
+   addVLValue(record, header.size);
+   record.insert(record.end(), data, data + header.size);
+   logFile.write((const char*)record.data(), record.size());
+   logTime = microseconds;
+}
+
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::store -- copy a message into the ring for the
+//     encoder thread.  Called by record() and recordInput().
+//
+
+void MidiFileRecorder::store(int port, int input, const uchar* data,
+      int size, int64_t timestamp) {
+   if (!recording.load(std::memory_order_relaxed) || size <= 0 ||
+         size > 0xffff) {
+      return;
+   }
+   if (timestamp == 0) {
+      timestamp = SigTimer::getMonotonicTime();
+   }
+   int count = CELLS_FOR_SIZE(size);
+   if (count > cellCount / 2) {
+      lost.fetch_add(1, std::memory_order_relaxed);
+      return;
+   }
+
+   // claim count cells in a row.  The cells are freed in order, so if
+   // the last one is free then so are the others.
+   uint64_t position = tail.load(std::memory_order_relaxed);
+   uint64_t last;
+   while (1) {
+      last = position + count - 1;
+      uint64_t sequence = cells[last & (cellCount - 1)].sequence.load(
+            std::memory_order_acquire);
+      int64_t difference = (int64_t)sequence - (int64_t)last;
+      if (difference == 0) {
+         if (tail.compare_exchange_weak(position, position + count,
+               std::memory_order_relaxed)) {
+            break;
+         }
+      } else if (difference < 0) {
+         // the ring is full
+         lost.fetch_add(1, std::memory_order_relaxed);
+         return;
+      } else {
+         position = tail.load(std::memory_order_relaxed);
+      }
+   }
+
+   Header header;
+   header.time = timestamp;
+   header.port = (int16_t)port;
+   header.size = (uint16_t)size;
+   header.input = (uint8_t)(input ? 1 : 0);
+   Cell& first = cells[position & (cellCount - 1)];
+   memcpy(first.bytes, &header, sizeof(Header));
+   int amount = size < FIRST_CELL_BYTES ? size : FIRST_CELL_BYTES;
+   memcpy(first.bytes + sizeof(Header), data, amount);
+   int offset = amount;
+   for (int i=1; i<count; i++) {
+      amount = size - offset < 24 ? size - offset : 24;
+      memcpy(cells[(position + i) & (cellCount - 1)].bytes, data + offset,
+            amount);
+      offset += amount;
+   }
+
+   // publish the first cell last, so that the whole message is ready
+   // when the encoder thread sees it
+   for (int i=count-1; i>=0; i--) {
+      cells[(position + i) & (cellCount - 1)].sequence.store(
+            position + i + 1, std::memory_order_release);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiFileRecorder::writeFile -- write the encoded tracks into the MIDI
+//     file.  A type 0 file has one track with the tempo and all of the
+//     messages.  A type 1 file has a tempo track, then a named track
+//     for each port or channel.  A binary log has already been written,
+//     so it is only closed.  Returns 1 if the file was written.
+//
+
+int MidiFileRecorder::writeFile(void) {
+   if (trackMode == MIDI_RECORD_LOG) {
+      logFile.close();
+      if (logFile.fail()) {
+         cerr << "Error: cannot write file " << filename << endl;
+         return 0;
+      }
+      return 1;
+   }
+
+   ofstream outfile(filename.c_str(), ios::out | ios::binary | ios::trunc);
+   if (!outfile.is_open()) {
+      cerr << "Error: cannot open file " << filename << endl;
+      return 0;
+   }
+
+   static const uchar tempo[7] = {0x00, 0xff, 0x51, 0x03,
+         (uchar)(RECORD_TEMPO >> 16), (uchar)((RECORD_TEMPO >> 8) & 0xff),
+         (uchar)(RECORD_TEMPO & 0xff)};
+   static const uchar endOfTrack[4] = {0x00, 0xff, 0x2f, 0x00};
+
+   std::vector<std::vector<uchar> > chunks;
+   if (trackMode == MIDI_RECORD_ONE_TRACK) {
+      chunks.resize(1);
+      chunks[0].assign(tempo, tempo + 7);
+      if (!tracks.empty()) {
+         std::vector<uchar>& data = tracks.begin()->second.data;
+         chunks[0].insert(chunks[0].end(), data.begin(), data.end());
+      }
+   } else {
+      chunks.resize(1 + tracks.size());
+      chunks[0].assign(tempo, tempo + 7);
+      int index = 1;
+      char name[32];
+      std::map<int, Track>::iterator it;
+      for (it=tracks.begin(); it!=tracks.end(); it++, index++) {
+         if (trackMode == MIDI_RECORD_BY_PORT &&
+               it->first >= INPUT_TRACK_OFFSET) {
+            snprintf(name, sizeof(name), "Input %d",
+                  it->first - INPUT_TRACK_OFFSET + 1);
+         } else if (trackMode == MIDI_RECORD_BY_PORT) {
+            snprintf(name, sizeof(name), "Output %d", it->first + 1);
+         } else if (it->first < 16) {
+            snprintf(name, sizeof(name), "Channel %d", it->first + 1);
+         } else {
+            snprintf(name, sizeof(name), "System exclusive");
+         }
+         std::vector<uchar>& chunk = chunks[index];
+         chunk.push_back(0x00);
+         chunk.push_back(0xff);
+         chunk.push_back(0x03);
+         addVLValue(chunk, strlen(name));
+         chunk.insert(chunk.end(), name, name + strlen(name));
+         chunk.insert(chunk.end(), it->second.data.begin(),
+               it->second.data.end());
+      }
+   }
+
+   uchar header[14] = {'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 0, 0, 0,
+         (uchar)(RECORD_DIVISION >> 8), (uchar)(RECORD_DIVISION & 0xff)};
+   header[9]  = trackMode == MIDI_RECORD_ONE_TRACK ? 0 : 1;
+   header[10] = (uchar)(chunks.size() >> 8);
+   header[11] = (uchar)(chunks.size() & 0xff);
+   outfile.write((const char*)header, 14);
+
+   for (int i=0; i<(int)chunks.size(); i++) {
+      std::vector<uchar>& chunk = chunks[i];
+      chunk.insert(chunk.end(), endOfTrack, endOfTrack + 4);
+      uint32_t size = (uint32_t)chunk.size();
+      uchar trackHeader[8] = {'M', 'T', 'r', 'k', (uchar)(size >> 24),
+            (uchar)((size >> 16) & 0xff), (uchar)((size >> 8) & 0xff),
+            (uchar)(size & 0xff)};
+      outfile.write((const char*)trackHeader, 8);
+      outfile.write((const char*)chunk.data(), chunk.size());
+   }
+
+   outfile.close();
+   if (outfile.fail()) {
+      cerr << "Error: cannot write file " << filename << endl;
+      return 0;
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// encodeMidiFilePrivate -- the encoder thread of a MidiFileRecorder.
+//     Encodes the recorded messages while recording, and writes the
+//     file after the recording is stopped.
+//
+
+void *encodeMidiFilePrivate(void* x) {
+   MidiFileRecorder& recorder = *((MidiFileRecorder*)x);
+   while (recorder.running.load()) {
+      if (recorder.drain() == 0) {
+         usleep(RECORD_IDLE_TIME);
+      }
+   }
+   recorder.drain();
+   recorder.writeStatus = recorder.writeFile();
+   recorder.tracks.clear();
+   return NULL;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// MidiRecorderSlot
+//
+
+
+//////////////////////////////
+//
+// MidiRecorderSlot::MidiRecorderSlot -- the slot starts empty.
+//
+
+MidiRecorderSlot::MidiRecorderSlot(void) {
+   recorder.store(NULL);
+   users.store(0);
+}
+
+
+
+//////////////////////////////
+//
+// MidiRecorderSlot::get -- returns the recorder, or NULL if none.
+//
+
+MidiFileRecorder* MidiRecorderSlot::get(void) const {
+   return recorder.load();
+}
+
+
+
+//////////////////////////////
+//
+// MidiRecorderSlot::recordInput -- record an input message if there is
+//     a recorder.  Without a recorder this is a single relaxed load.
+//     default value: timestamp = 0
+//
+
+void MidiRecorderSlot::recordInput(int port, const uchar* data, int size,
+      int64_t timestamp) {
+   if (recorder.load(std::memory_order_relaxed) == NULL) {
+      return;
+   }
+   // set() waits for users to drop to zero after changing the recorder,
+   // so the recorder loaded here is not deleted until this is done.
+   users.fetch_add(1);
+   MidiFileRecorder* current = recorder.load();
+   if (current != NULL) {
+      current->recordInput(port, data, size, timestamp);
+   }
+   users.fetch_sub(1, std::memory_order_release);
+}
+
+
+
+//////////////////////////////
+//
+// MidiRecorderSlot::set -- change the recorder (NULL for none).  Waits
+//     until no input thread is still using the old recorder.
+//
+
+void MidiRecorderSlot::set(MidiFileRecorder* aRecorder) {
+   recorder.store(aRecorder);
+   while (users.load(std::memory_order_acquire) != 0) {
+      sched_yield();
+   }
+}
+
+
+
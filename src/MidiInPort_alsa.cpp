@@ -5,6 +5,18 @@
 // Last Modified: Fri Oct 26 14:41:36 PDT 2001 (running status for 0xa0 and 0xd0
 //                                              fixed by Daniel Gardner)
 // Last Modified: Mon Nov 19 17:52:15 PST 2001 (thread on exit improved)
+// Last Modified: Sat Oct 17 10:12:40 PDT 2026 (poll and read input in blocks)
+// Last Modified: Sat Oct 17 11:04:18 PDT 2026 (one epoll thread for all ports)
+// Last Modified: Sat Oct 17 11:32:40 PDT 2026 (lock-free input buffers)
+// Last Modified: Sat Oct 17 12:05:51 PDT 2026 (use MidiStreamParser)
+// Last Modified: Sat Oct 17 12:48:09 PDT 2026 (nanosecond input timestamps)
+// Last Modified: Sat Oct 17 13:20:37 PDT 2026 (input arrival eventfd)
+// Last Modified: Sat Oct 17 13:51:02 PDT 2026 (input thread callbacks)
+// Last Modified: Sat Oct 17 14:22:15 PDT 2026 (reference-counted sysex pool)
+// Last Modified: Sat Oct 17 14:58:33 PDT 2026 (per-port input filters)
+// Last Modified: Sat Oct 17 15:40:12 PDT 2026 (overflow policies, counters)
+// Last Modified: Sat Oct 17 18:12:40 PDT 2026 (asynchronous trace)
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026 (recording in input thread)
 // Filename:      ...sig/code/control/MidiInPort/linux/MidiInPort_alsa.cpp
 // Web Address:   http://sig.sapp.org/src/sig/MidiInPort_alsa.cpp
 // Syntax:        C++ 
@@ -17,9 +29,16 @@
 #if defined(LINUX) && defined(ALSA)
 
 #include "MidiInPort_alsa.h"
+#include "MidiStreamParser.h"
+#include "MidiTrace.h"
 
 #include <cstdlib>
 #include <pthread.h>
+#include <poll.h>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 #include <vector>
 
@@ -37,20 +56,146 @@
 
 #define DEFAULT_INPUT_BUFFER_SIZE (1024)
 
+// default maximum growth of the input buffer for MIDI_OVERFLOW_GROW,
+// as a multiple of the buffer size
+#define DEFAULT_GROW_FACTOR (16)
+
+// time in microseconds between checks for space in a full input buffer
+// for MIDI_OVERFLOW_BLOCK
+#define BLOCK_WAIT_TIME (200)
+
+// maximum number of bytes read from the driver in one call
+#define INPUT_READ_SIZE (1024)
+
+// poll() timeout in milliseconds for the input thread
+#define INPUT_POLL_TIMEOUT (100)
+
+// maximum number of poll descriptors for one rawmidi input
+#define MAX_INPUT_POLL_DESCRIPTORS (4)
+
+// maximum number of epoll events handled per wakeup of an input thread
+#define MAX_INPUT_EVENTS (32)
+
+// epoll data value for the descriptor used to wake up an input thread
+#define INPUT_WAKE_ID (0xffffffff)
+
+// parsing state for one input device, owned by the input thread
+struct AlsaInputState {
+   int              device;      // input port number
+   MidiStreamParser parser;      // converts bytes into MIDI messages
+   smf::MidiEvent   message;     // holding spot for the current message
+   int64_t          blockTime;   // monotonic time of the last read (ns)
+   int              blockTick;   // SigTimer time of the last read (ms)
+   int              pending;     // messages stored since last signal
+   vector<uchar>    sysex;       // exchanged with the parser and sysex pool
+};
+
+// The DROP_OLDEST and GROW overflow policies let the input thread remove
+// messages from the input buffer or reallocate it, so the reader has
+// to hold the buffer lock of the port while it uses the buffer.  With 
+// the other policies the buffer is lock-free.
+static inline int needsBufferLock(int policy) {
+   return policy == MIDI_OVERFLOW_DROP_OLDEST || policy == MIDI_OVERFLOW_GROW;
+}
+
+// holds the buffer lock of a port during a function, if needed
+class InputBufferGuard {
+   public:
+      InputBufferGuard(std::mutex& aLock, const std::atomic<int>& aPolicy) :
+            lock(aLock) {
+         lockedQ = needsBufferLock(aPolicy.load(std::memory_order_relaxed));
+         if (lockedQ) {
+            lock.lock();
+         }
+      }
+     ~InputBufferGuard() {
+         if (lockedQ) {
+            lock.unlock();
+         }
+      }
+   private:
+      std::mutex& lock;
+      int         lockedQ;
+};
+
+// marks the input thread as using the buffer of a port without the
+// buffer lock, so that InputProducerLock can wait until it has finished.
+// The stores are sequentially consistent, so either the input thread 
+// sees bufferExclusive and takes the buffer lock, or InputProducerLock
+// sees inputWriting and waits.
+class InputWriteMark {
+   public:
+      InputWriteMark(std::atomic<int>& aFlag) : flag(aFlag) {
+         flag.store(1);
+      }
+     ~InputWriteMark() {
+         flag.store(0);
+      }
+      void clear(void) {
+         flag.store(0);
+      }
+   private:
+      std::atomic<int>& flag;
+};
+
+// gives a user thread the producer side of the input buffer of a port
+// during a function, for insert() and setBufferSize().  The input thread
+// is told to take the buffer lock while any user thread needs it, and
+// the input thread's lock-free write (if any) is allowed to finish.
+class InputProducerLock {
+   public:
+      InputProducerLock(std::atomic<int>& anExclusive, 
+            const std::atomic<int>& aWriting, std::mutex& aLock) :
+            exclusive(anExclusive), lock(aLock) {
+         exclusive.fetch_add(1);
+         while (aWriting.load()) {
+            sched_yield();
+         }
+         lock.lock();
+      }
+     ~InputProducerLock() {
+         lock.unlock();
+         exclusive.fetch_sub(1);
+      }
+   private:
+      std::atomic<int>& exclusive;
+      std::mutex&       lock;
+};
+
+// add to a counter which has only one writer at a time (the input thread,
+// or a user thread which holds an InputProducerLock)
+static inline void addCount(std::atomic<int64_t>& counter, int64_t amount) {
+   counter.store(counter.load(std::memory_order_relaxed) + amount, 
+         std::memory_order_relaxed);
+}
+
 // initialized static variables
 
 int       MidiInPort_alsa::numDevices                     = 0;
 int       MidiInPort_alsa::objectCount                    = 0;
 int*      MidiInPort_alsa::portObjectCount                = NULL;
-CircularBuffer<smf::MidiEvent>** MidiInPort_alsa::midiBuffer = NULL;
+SpscBuffer<MidiInputRecord>** MidiInPort_alsa::midiBuffer = NULL;
 int       MidiInPort_alsa::channelOffset                  = 0;
 SigTimer  MidiInPort_alsa::midiTimer;
 int*      MidiInPort_alsa::pauseQ                         = NULL;
 int*      MidiInPort_alsa::trace                          = NULL;
 ostream*  MidiInPort_alsa::tracedisplay                   = &cout;
 vector<pthread_t> MidiInPort_alsa::midiInThread;    
-int*      MidiInPort_alsa::sysexWriteBuffer               = NULL;
-vector<uchar>** MidiInPort_alsa::sysexBuffers             = NULL;
+vector<int> MidiInPort_alsa::inputWakeFd;
+std::atomic<int> MidiInPort_alsa::inputThreadStop(0);
+vector<int> MidiInPort_alsa::inputEventFd;
+std::atomic<MidiInputCallback*>* MidiInPort_alsa::inputCallback = NULL;
+MidiInputFilter* MidiInPort_alsa::inputFilter             = NULL;
+MidiRecorderSlot* MidiInPort_alsa::inputRecorder          = NULL;
+MidiInPort_alsa::PortCounters* MidiInPort_alsa::inputCounters = NULL;
+std::atomic<int>* MidiInPort_alsa::overflowPolicy         = NULL;
+int*      MidiInPort_alsa::growLimit                      = NULL;
+std::mutex* MidiInPort_alsa::bufferLock                   = NULL;
+std::atomic<int>* MidiInPort_alsa::inputWriting           = NULL;
+std::atomic<int>* MidiInPort_alsa::bufferExclusive         = NULL;
+vector<MidiInputCallback*> MidiInPort_alsa::oldCallbacks;
+int       MidiInPort_alsa::inputThreadCount               = 1;
+SysexPool** MidiInPort_alsa::sysexPool                    = NULL;
 
 vector<int> MidiInPort_alsa::threadinitport;
 
@@ -93,6 +238,7 @@ MidiInPort_alsa::MidiInPort_alsa(int aPort, int autoOpen) {
 //
 
 MidiInPort_alsa::~MidiInPort_alsa() {
+   releaseSysex();
    objectCount--;
    if (objectCount == 0) {
       deinitialize();
@@ -105,37 +251,75 @@ MidiInPort_alsa::~MidiInPort_alsa() {
 
 
 
+//////////////////////////////
+//
+// MidiInPort_alsa::clearCallback -- stop calling the callback function
+//	for the port.  Messages are stored in the input buffer again.
+//
+
+void MidiInPort_alsa::clearCallback(void) {
+   setCallback(NULL);
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_alsa::clearSysex -- clears the data from a sysex
 //      message and sets the allocation size to the default size (of 32
-//      bytes).
+//      bytes).  This object stops holding the buffer, and buffers which
+//      are still referenced by a SysexView are not cleared.
 //
 
 void MidiInPort_alsa::clearSysex(int buffer) {
-   buffer = 0x7f | buffer;    // limit buffer range from 0 to 127
- 
    if (getPort() == -1) {
       return;
    }
-   
-   sysexBuffers[getPort()][buffer].clear();
-   if (sysexBuffers[getPort()][buffer].capacity() != 32) {
-      // shrink the storage buffer's size if necessary
-      sysexBuffers[getPort()][buffer].reserve(32);
+
+   for (int i=0; i<(int)heldSysex.size(); i++) {
+      if (heldSysex[i] == buffer) {
+         sysexPool[getPort()]->release(buffer);
+         heldSysex.erase(heldSysex.begin() + i);
+         break;
+      }
    }
+   sysexPool[getPort()]->clear(buffer);
 }
 
 
 void MidiInPort_alsa::clearSysex(void) {
+   if (getPort() == -1) {
+      return;
+   }
+
    // clear all sysex buffers
-   for (int i=0; i<128; i++) {
-      clearSysex(i);
+   releaseSysex();
+   for (int i=0; i<sysexPool[getPort()]->getSlotCount(); i++) {
+      sysexPool[getPort()]->clear(i);
    }
 }
 
 
 
+//////////////////////////////
+//
+// MidiInPort_alsa::clearStatistics -- set the input counters of the
+//	port to zero.  The peak is set to the number of messages which
+//	are currently waiting.
+//
+
+void MidiInPort_alsa::clearStatistics(void) {
+   if (getPort() == -1)   return;
+
+   PortCounters& counters = inputCounters[getPort()];
+   counters.received.store(0);
+   counters.dropped.store(0);
+   counters.bytes.store(0);
+   counters.peak.store(getCount());
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_alsa::close
@@ -146,6 +330,7 @@ void MidiInPort_alsa::close(void) {
 
    pauseQ[getPort()] = 1;
    Sequencer_alsa::closeInput(getPort());
+   wakeInputThread(getPort());
 }
 
 
@@ -159,6 +344,7 @@ void MidiInPort_alsa::closeAll(void) {
    for (int i=0; i<getNumPorts(); i++) {
       pauseQ[i] = 1;
       Sequencer_alsa::closeInput(i);
+      wakeInputThread(i);
    }
 }
 
@@ -167,17 +353,70 @@ void MidiInPort_alsa::closeAll(void) {
 //////////////////////////////
 //
 // MidiInPort_alsa::extract -- returns the next MIDI message
-//	received since that last extracted message.
+//	received since that last extracted message.  If there is no
+//	message waiting, event is set to an empty message.  The
+//	optional timestamp is the CLOCK_MONOTONIC arrival time of the
+//	message in nanoseconds (see SigTimer::getMonotonicTime()).
 //
 
 void MidiInPort_alsa::extract(smf::MidiEvent& event) {
+   int64_t timestamp;
+   extract(event, timestamp);
+}
+
+
+void MidiInPort_alsa::extract(smf::MidiEvent& event, int64_t& timestamp) {
+   timestamp = 0;
    if (getPort() == -1) {
       smf::MidiEvent temp;
       event = temp;
       return;
    }
 
-   midiBuffer[getPort()]->extract(event);
+   InputBufferGuard guard(bufferLock[getPort()], overflowPolicy[getPort()]);
+   MidiInputRecord record;
+   if (!midiBuffer[getPort()]->extract(record)) {
+      smf::MidiEvent temp;
+      event = temp;
+      return;
+   }
+   event = record.event;
+   timestamp = record.timestamp;
+   if (event.getP0() == 0xf0) {
+      holdSysex(&event, 1);
+   }
+}
+
+
+//
+// Bulk version: extracts up to count waiting messages into the
+//	events array, and returns the number of messages extracted.
+//	If timestamps is not NULL, the arrival time of each message
+//	is stored in it.
+//
+
+int MidiInPort_alsa::extract(smf::MidiEvent* events, int count, 
+      int64_t* timestamps) {
+   if (getPort() == -1)   return 0;
+
+   InputBufferGuard guard(bufferLock[getPort()], overflowPolicy[getPort()]);
+   SpscBuffer<MidiInputRecord>& buffer = *midiBuffer[getPort()];
+   MidiInputRecord record;
+   int output = 0;
+   while (output < count && buffer.extract(record)) {
+      events[output] = record.event;
+      if (timestamps != NULL) {
+         timestamps[output] = record.timestamp;
+      }
+      output++;
+   }
+   for (int i=0; i<output; i++) {
+      if (events[i].getP0() == 0xf0) {
+         holdSysex(events, output);
+         break;
+      }
+   }
+   return output;
 }
 
 
@@ -191,6 +430,7 @@ void MidiInPort_alsa::extract(smf::MidiEvent& event) {
 int MidiInPort_alsa::getBufferSize(void) {
    if (getPort() == -1)   return 0;
 
+   InputBufferGuard guard(bufferLock[getPort()], overflowPolicy[getPort()]);
    return (int)midiBuffer[getPort()]->getSize();
 }
 
@@ -216,11 +456,63 @@ int MidiInPort_alsa::getChannelOffset(void) const {
 
 int MidiInPort_alsa::getCount(void) {
    if (getPort() == -1)   return 0;
+
+   InputBufferGuard guard(bufferLock[getPort()], overflowPolicy[getPort()]);
    return midiBuffer[getPort()]->getCount();
 }
 
 
 
+//////////////////////////////
+//
+// MidiInPort_alsa::getFilter -- returns the filter which decides which
+//	incoming messages are stored in the input buffer of the port.
+//	The filter is shared by all objects using the same port, and
+//	it can be changed while the port is open.  For example, to 
+//	ignore polyphonic aftertouch on all channels:
+//	   midiin.getFilter().setChannel(0xa0, -1, 0);
+//
+
+MidiInputFilter& MidiInPort_alsa::getFilter(void) {
+   if (getPort() == -1) {
+      static MidiInputFilter nullFilter;
+      return nullFilter;
+   }
+   return inputFilter[getPort()];
+}
+
+
+
+//////////////////////////////
+//
+// MidiInPort_alsa::getInputEventFd -- returns a file descriptor (an
+//	eventfd) which becomes readable when new messages have been
+//	placed in the input buffer of the given port.  Wait for it
+//	with poll(), then read() eight bytes from it to clear it before
+//	checking getCount().  Returns -1 if the port is invalid.
+//
+
+int MidiInPort_alsa::getInputEventFd(int aPort) {
+   if (aPort < 0 || aPort >= (int)inputEventFd.size()) {
+      return -1;
+   }
+   return inputEventFd[aPort];
+}
+
+
+
+//////////////////////////////
+//
+// MidiInPort_alsa::getInputThreadCount -- returns the number of threads
+//     which are used to read MIDI input from the ports.
+//
+
+int MidiInPort_alsa::getInputThreadCount(void) {
+   return inputThreadCount;
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_alsa::getName -- returns the name of the port.
@@ -254,6 +546,21 @@ int MidiInPort_alsa::getNumPorts(void) {
 
 
 
+//////////////////////////////
+//
+// MidiInPort_alsa::getOverflowPolicy -- returns what is done with new
+//	messages when the input buffer of the port is full.  See
+//	setOverflowPolicy().
+//
+
+int MidiInPort_alsa::getOverflowPolicy(void) {
+   if (getPort() == -1)   return MIDI_OVERFLOW_DROP_NEWEST;
+
+   return overflowPolicy[getPort()].load();
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_alsa::getPort -- returns the port to which this
@@ -277,6 +584,48 @@ int MidiInPort_alsa::getPortStatus(void) {
 
 
 
+//////////////////////////////
+//
+// MidiInPort_alsa::getRecorder -- returns the recorder of the port, or
+//	NULL if the input of the port is not being recorded.
+//
+
+MidiFileRecorder* MidiInPort_alsa::getRecorder(void) {
+   if (getPort() == -1 || inputRecorder == NULL) {
+      return NULL;
+   }
+   return inputRecorder[getPort()].get();
+}
+
+
+
+//////////////////////////////
+//
+// MidiInPort_alsa::getStatistics -- fill in the input counters of the
+//	port: the number of messages and bytes received, the number of
+//	messages lost because the input buffer was full, the most 
+//	messages ever waiting in the buffer, and the buffer size.
+//	Messages rejected by the input filter are counted as received
+//	but not as dropped (see MidiInputFilter::getDropCount()).
+//
+
+void MidiInPort_alsa::getStatistics(MidiInputStatistics& stats) {
+   if (getPort() == -1) {
+      stats.received = stats.dropped = stats.bytes = 0;
+      stats.peak = stats.size = 0;
+      return;
+   }
+
+   PortCounters& counters = inputCounters[getPort()];
+   stats.received = counters.received.load();
+   stats.dropped  = counters.dropped.load();
+   stats.bytes    = counters.bytes.load();
+   stats.peak     = counters.peak.load();
+   stats.size     = getBufferSize();
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_alsa::getSysex -- returns the sysex message contents
@@ -286,20 +635,35 @@ int MidiInPort_alsa::getPortStatus(void) {
 //
 
 uchar* MidiInPort_alsa::getSysex(int buffer) {
-   buffer &= 0x7f;     // limit the buffer access to indices 0 to 127.
    if (getPort() == -1) {
       return NULL;
    }
 
-   if ((int)sysexBuffers[getPort()][buffer].size() < 2) {
+   if (sysexPool[getPort()]->getSize(buffer) < 2) {
       return NULL;
    } else {
-      return sysexBuffers[getPort()][buffer].data();
+      return (uchar*)sysexPool[getPort()]->getData(buffer);
    }
 }
 
 
 
+//////////////////////////////
+//
+// MidiInPort_alsa::getSysexOverflowCount -- returns the number of
+//    sysex messages which were dropped because all of the sysex 
+//    buffers for the port were still holding unread messages.
+//
+
+int MidiInPort_alsa::getSysexOverflowCount(void) {
+   if (getPort() == -1) {
+      return 0;
+   }
+   return sysexPool[getPort()]->getOverflowCount();
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_alsa::getSysexSize -- returns the sysex message byte
@@ -311,8 +675,26 @@ int MidiInPort_alsa::getSysexSize(int buffer) {
    if (getPort() == -1) {
       return 0;
    } else {
-      return (int)sysexBuffers[getPort()][buffer & 0x7f].size();
+      return sysexPool[getPort()]->getSize(buffer);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiInPort_alsa::getSysexView -- returns a reference to the data
+//    in a sysex buffer which keeps the data from being overwritten
+//    for as long as the view exists.  The buffer must be one of the
+//    most recently extracted sysex messages, or the one given to an
+//    input callback (while the callback is running).
+//
+
+SysexView MidiInPort_alsa::getSysexView(int buffer) {
+   if (getPort() == -1) {
+      return SysexView();
    }
+   return SysexView(sysexPool[getPort()], buffer);
 }
 
 
@@ -334,13 +716,34 @@ int MidiInPort_alsa::getTrace(void) {
 
 //////////////////////////////
 //
-// MidiInPort_alsa::insert
+// MidiInPort_alsa::insert -- add a message to the input buffer.
+//	The input buffer only allows one writer, so the input thread
+//	of the port is held at the buffer lock while the message is 
+//	stored.  This can be called from any thread while the port is
+//	open and receiving MIDI data.  The message is dropped (and 
+//	counted as dropped) if the buffer is full.
 //
 
 void MidiInPort_alsa::insert(const smf::MidiEvent& aMessage) {
    if (getPort() == -1)   return;
 
-   midiBuffer[getPort()]->insert(aMessage);
+   int aPort = getPort();
+   MidiInputRecord record;
+   record.event = aMessage;
+   record.timestamp = SigTimer::getMonotonicTime();
+   {
+      InputProducerLock lock(bufferExclusive[aPort], inputWriting[aPort],
+            bufferLock[aPort]);
+      if (!midiBuffer[aPort]->insert(record)) {
+         addCount(inputCounters[aPort].dropped, 1);
+         if (aMessage.getP0() == 0xf0) {
+            // the message will never be extracted, so free its sysex
+            sysexPool[aPort]->release(aMessage.getP1());
+         }
+         return;
+      }
+   }
+   signalInput(aPort);
 }
 
 
@@ -348,7 +751,10 @@ void MidiInPort_alsa::insert(const smf::MidiEvent& aMessage) {
 //////////////////////////////
 //
 // MidiInPort_alsa::installSysex -- put a sysex message into a
-//      buffer.  The buffer number that it is put into is returned.
+//      buffer.  The buffer number that it is put into is returned,
+//      or -1 if all buffers are in use.  The buffer is held until
+//      a 0xf0 message with the buffer number in P1 is inserted into
+//      the input buffer and extracted again.
 //
 
 int MidiInPort_alsa::installSysex(uchar* anArray, int aSize) {
@@ -363,30 +769,13 @@ int MidiInPort_alsa::installSysex(uchar* anArray, int aSize) {
 
 //////////////////////////////
 //
-// MidiInPort_alsa::installSysexPrivate -- put a sysex message into a
-//      buffer.  The buffer number that it is put into is returned.
+// MidiInPort_alsa::installSysexPrivate -- copy a sysex message into a
+//      buffer.  The buffer number that it is put into is returned,
+//      or -1 if all buffers are in use.
 //
 
 int MidiInPort_alsa::installSysexPrivate(int port, uchar* anArray, int aSize) {
-   // choose a buffer to install sysex data into:
-   int bufferNumber = sysexWriteBuffer[port];
-   sysexWriteBuffer[port]++;
-   if (sysexWriteBuffer[port] >= 128) {
-      sysexWriteBuffer[port] = 0;
-   }
-
-   // copy contents of sysex message into the chosen buffer
-   sysexBuffers[port][bufferNumber].resize(aSize);
-   uchar* dataptr = sysexBuffers[port][bufferNumber].data();
-   uchar* indataptr = anArray;
-   for (int i=0; i<aSize; i++) { 
-      *dataptr = *indataptr;
-      dataptr++;
-      indataptr++;
-   }
-
-   // return the buffer number that was used
-   return bufferNumber;
+   return sysexPool[port]->store(anArray, aSize);
 }
 
 
@@ -403,8 +792,11 @@ smf::MidiEvent& MidiInPort_alsa::message(int index) {
       return x;
    }
 
-   CircularBuffer<smf::MidiEvent>& temp = *midiBuffer[getPort()];
-   return temp[index];
+   // with the MIDI_OVERFLOW_GROW policy, the returned message is only
+   // valid until the input thread enlarges the buffer.
+   InputBufferGuard guard(bufferLock[getPort()], overflowPolicy[getPort()]);
+   SpscBuffer<MidiInputRecord>& temp = *midiBuffer[getPort()];
+   return temp[index].event;
 }
 
 
@@ -421,6 +813,7 @@ int MidiInPort_alsa::open(void) {
    int status = Sequencer_alsa::openInput(getPort());
    if (status) {
       pauseQ[getPort()] = 0;
+      wakeInputThread(getPort());
       return 1;
    } else {
       pauseQ[getPort()] = 1;
@@ -450,13 +843,63 @@ void MidiInPort_alsa::pause(void) {
 //////////////////////////////
 //
 // MidiInPort_alsa::setBufferSize -- sets the allocation
-//	size of the MIDI input buffer.
+//	size of the MIDI input buffer.  The size is rounded up to
+//	a power of two, and any waiting messages are discarded.
+//	The storage of the buffer is replaced, so this waits until
+//	the input thread is not writing to it, and holds the buffer
+//	lock of the port so that the input thread cannot start again
+//	until the new storage is in place.
 //
 
 void MidiInPort_alsa::setBufferSize(int aSize) {
    if (getPort() == -1)  return;
 
-   midiBuffer[getPort()]->setSize(aSize);
+   int aPort = getPort();
+   InputProducerLock lock(bufferExclusive[aPort], inputWriting[aPort],
+         bufferLock[aPort]);
+   // the discarded messages will not be extracted, so free their sysex
+   MidiInputRecord record;
+   while (midiBuffer[aPort]->extract(record)) {
+      if (record.event.getP0() == 0xf0) {
+         sysexPool[aPort]->release(record.event.getP1());
+      }
+   }
+   midiBuffer[aPort]->setSize(aSize);
+}
+
+
+
+//////////////////////////////
+//
+// MidiInPort_alsa::setCallback -- call aFunction from the MIDI input
+//	thread as soon as each message for this port has been decoded,
+//	before the main program sees it.  The function receives the
+//	message, the port number and userdata.  If callbackOnly is true,
+//	messages are only passed to the function and are not placed
+//	into the input buffer.  The function should return quickly, since
+//	it delays the input of all ports which share the input thread.
+//	Only one callback can be set for each port; setting a new one
+//	replaces the old one.
+//	default values: userdata = NULL, callbackOnly = 0
+//
+
+void MidiInPort_alsa::setCallback(MIDI_Message_function aFunction, 
+      void* userdata, int callbackOnly) {
+   if (getPort() == -1 || inputCallback == NULL)   return;
+
+   MidiInputCallback* entry = NULL;
+   if (aFunction != NULL) {
+      entry = new MidiInputCallback;
+      entry->function = aFunction;
+      entry->userdata = userdata;
+      entry->callbackOnly = callbackOnly;
+   }
+   MidiInputCallback* old = inputCallback[getPort()].exchange(entry, 
+         std::memory_order_acq_rel);
+   if (old != NULL) {
+      // the input thread may still be using the old entry
+      oldCallbacks.push_back(old);
+   }
 }
 
 
@@ -479,6 +922,71 @@ void MidiInPort_alsa::setChannelOffset(int anOffset) {
 
 
 
+//////////////////////////////
+//
+// MidiInPort_alsa::setInputThreadCount -- sets the number of threads
+//     used to read MIDI input.  The ports are divided evenly between
+//     the threads.  Must be called before the first MidiInPort_alsa
+//     object is created, since the threads are started at that time.
+//     The default is a single thread which services all ports.
+//
+
+void MidiInPort_alsa::setInputThreadCount(int aCount) {
+   if (objectCount > 0) {
+      cerr << "Warning: MIDI input threads are already running; "
+           << "thread count not changed." << endl;
+      return;
+   }
+   if (aCount < 1) {
+      aCount = 1;
+   }
+   inputThreadCount = aCount;
+}
+
+
+
+//////////////////////////////
+//
+// MidiInPort_alsa::setOverflowPolicy -- choose what the input thread
+//	does with a new message when the input buffer of the port is full:
+//	   MIDI_OVERFLOW_DROP_NEWEST: discard the new message (the default).
+//	   MIDI_OVERFLOW_DROP_OLDEST: discard the oldest waiting message.
+//	   MIDI_OVERFLOW_GROW:        double the buffer size, up to aLimit
+//	                              messages (default 16 times the current
+//	                              size); then discard the new message.
+//	   MIDI_OVERFLOW_BLOCK:       wait until the program extracts a 
+//	                              message.  This stops input from all
+//	                              ports read by the same input thread,
+//	                              so the driver may drop bytes instead.
+//	Dropped messages are counted (see getStatistics()).  DROP_OLDEST
+//	and GROW need a lock which is shared with the reader of the buffer,
+//	so call this function from the thread which extracts messages.
+//	default value: aLimit = 0
+//
+
+void MidiInPort_alsa::setOverflowPolicy(int aPolicy, int aLimit) {
+   if (getPort() == -1)   return;
+
+   if (aPolicy < MIDI_OVERFLOW_DROP_NEWEST || aPolicy > MIDI_OVERFLOW_BLOCK) {
+      cerr << "Warning: unknown MIDI input overflow policy: " << aPolicy 
+           << endl;
+      return;
+   }
+
+   std::lock_guard<std::mutex> lock(bufferLock[getPort()]);
+   int size = midiBuffer[getPort()]->getSize();
+   if (aLimit <= 0) {
+      aLimit = size * DEFAULT_GROW_FACTOR;
+   }
+   if (aLimit < size) {
+      aLimit = size;
+   }
+   growLimit[getPort()] = aLimit;
+   overflowPolicy[getPort()].store(aPolicy);
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_alsa::setPort --
@@ -493,6 +1001,7 @@ void MidiInPort_alsa::setPort(int aPort) {
    }
 
    if (port != -1) {
+      releaseSysex();
       portObjectCount[port]--;
    }
    port = aPort;
@@ -503,6 +1012,25 @@ void MidiInPort_alsa::setPort(int aPort) {
 
 
 
+//////////////////////////////
+//
+// MidiInPort_alsa::setRecorder -- record the messages which arrive on
+//	the port (after the input filter) with their arrival times, or
+//	stop recording if aRecorder is NULL.  The recording is done by the
+//	input thread, and is shared by all objects using the same port.
+//	When this function returns the input thread is no longer using the
+//	previous recorder.
+//
+
+void MidiInPort_alsa::setRecorder(MidiFileRecorder* aRecorder) {
+   if (getPort() == -1 || inputRecorder == NULL) {
+      return;
+   }
+   inputRecorder[getPort()].set(aRecorder);
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_alsa::setTrace -- if false, then don't print MIDI messages
@@ -517,6 +1045,7 @@ int MidiInPort_alsa::setTrace(int aState) {
    if (aState == 0) {
       trace[getPort()] = 0;
    } else {
+      MidiTrace::start();
       trace[getPort()] = 1;
    }
    return oldtrace;
@@ -533,6 +1062,9 @@ int MidiInPort_alsa::setTrace(int aState) {
 void MidiInPort_alsa::toggleTrace(void) {
    if (getPort() == -1)   return;
 
+   if (!trace[getPort()]) {
+      MidiTrace::start();
+   }
    trace[getPort()] = !trace[getPort()];
 }
    
@@ -562,31 +1094,90 @@ void MidiInPort_alsa::unpause(void) {
 
 //////////////////////////////
 //
-// MidiInPort_alsa::deinitialize -- sets up storage if necessary
-//	This function should be called if the current object is
-//	the first object to be created.
+// MidiInPort_alsa::deinitialize -- stops the input threads and frees
+//	the storage for the ports.  This function should be called when
+//	the last object is destroyed.
 //
 
 void MidiInPort_alsa::deinitialize(void) {
+   // the input threads use everything below, so stop them first
+   stopInputThreads();
    closeAll();
 
    for (int i=0; i<getNumPorts(); i++) {
-      if (sysexBuffers != NULL && sysexBuffers[i] != NULL) {
-         delete [] sysexBuffers[i];
-         sysexBuffers[i] = NULL;
+      if (sysexPool != NULL && sysexPool[i] != NULL) {
+         delete sysexPool[i];
+         sysexPool[i] = NULL;
       }
    }
 
-   if (sysexBuffers != NULL) {
-      delete [] sysexBuffers;
-      sysexBuffers = NULL;
+   if (sysexPool != NULL) {
+      delete [] sysexPool;
+      sysexPool = NULL;
    }
 
    if (midiBuffer != NULL) {
+      for (int i=0; i<getNumPorts(); i++) {
+         delete midiBuffer[i];
+      }
       delete [] midiBuffer;
       midiBuffer = NULL;
    }
 
+   if (inputCallback != NULL) {
+      for (int i=0; i<getNumPorts(); i++) {
+         if (inputCallback[i].load() != NULL) {
+            oldCallbacks.push_back(inputCallback[i].load());
+         }
+      }
+      delete [] inputCallback;
+      inputCallback = NULL;
+   }
+
+   if (inputFilter != NULL) {
+      delete [] inputFilter;
+      inputFilter = NULL;
+   }
+
+   if (inputRecorder != NULL) {
+      delete [] inputRecorder;
+      inputRecorder = NULL;
+   }
+
+   if (inputCounters != NULL) {
+      delete [] inputCounters;
+      inputCounters = NULL;
+   }
+
+   if (overflowPolicy != NULL) {
+      delete [] overflowPolicy;
+      overflowPolicy = NULL;
+   }
+
+   if (growLimit != NULL) {
+      delete [] growLimit;
+      growLimit = NULL;
+   }
+
+   if (bufferLock != NULL) {
+      delete [] bufferLock;
+      bufferLock = NULL;
+   }
+
+   if (inputWriting != NULL) {
+      delete [] inputWriting;
+      inputWriting = NULL;
+   }
+
+   if (bufferExclusive != NULL) {
+      delete [] bufferExclusive;
+      bufferExclusive = NULL;
+   }
+   for (int i=0; i<(int)oldCallbacks.size(); i++) {
+      delete oldCallbacks[i];
+   }
+   oldCallbacks.clear();
+
    if (portObjectCount != NULL) {
       delete [] portObjectCount;
       portObjectCount = NULL;
@@ -605,6 +1196,24 @@ void MidiInPort_alsa::deinitialize(void) {
 
 
 
+//////////////////////////////
+//
+// MidiInPort_alsa::holdSysex -- take over the references to the sysex
+//	buffers of the extracted messages from the input thread, and
+//	release the buffers of the previously extracted sysex messages.
+//
+
+void MidiInPort_alsa::holdSysex(smf::MidiEvent* events, int count) {
+   releaseSysex();
+   for (int i=0; i<count; i++) {
+      if (events[i].getP0() == 0xf0) {
+         heldSysex.push_back(events[i].getP1());
+      }
+   }
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_alsa::initialize -- sets up storage if necessary
@@ -642,43 +1251,113 @@ void MidiInPort_alsa::initialize(void) {
       if (midiBuffer != NULL) {
          delete [] midiBuffer;
       }
-      midiBuffer = new CircularBuffer<smf::MidiEvent>*[numDevices];
+      midiBuffer = new SpscBuffer<MidiInputRecord>*[numDevices];
+
+      // allocate space for the input callback functions
+      if (inputCallback != NULL) {
+         delete [] inputCallback;
+      }
+      inputCallback = new std::atomic<MidiInputCallback*>[numDevices];
+
+      // allocate space for the input filters
+      if (inputFilter != NULL) {
+         delete [] inputFilter;
+      }
+      inputFilter = new MidiInputFilter[numDevices];
 
-      // allocate space for Midi input sysex buffer write indices
-      if (sysexWriteBuffer != NULL) {
-         delete [] sysexWriteBuffer;
+      // allocate space for the recorders of the ports
+      if (inputRecorder != NULL) {
+         delete [] inputRecorder;
       }
-      sysexWriteBuffer = new int[numDevices];
+      inputRecorder = new MidiRecorderSlot[numDevices];
+
+      // allocate space for the input counters and overflow handling
+      if (inputCounters != NULL) {
+         delete [] inputCounters;
+      }
+      inputCounters = new PortCounters[numDevices];
+      if (overflowPolicy != NULL) {
+         delete [] overflowPolicy;
+      }
+      overflowPolicy = new std::atomic<int>[numDevices];
+      if (growLimit != NULL) {
+         delete [] growLimit;
+      }
+      growLimit = new int[numDevices];
+      if (bufferLock != NULL) {
+         delete [] bufferLock;
+      }
+      bufferLock = new std::mutex[numDevices];
+      if (inputWriting != NULL) {
+         delete [] inputWriting;
+      }
+      inputWriting = new std::atomic<int>[numDevices];
+      if (bufferExclusive != NULL) {
+         delete [] bufferExclusive;
+      }
+      bufferExclusive = new std::atomic<int>[numDevices];
 
       // allocate space for Midi input sysex buffers
-      if (sysexBuffers != NULL) {
+      if (sysexPool != NULL) {
          cout << "Error: memory leak on sysex buffers initialization" << endl;
          exit(1);
       }
-      sysexBuffers = new vector<uchar>*[numDevices];
+      sysexPool = new SysexPool*[numDevices];
    
-      int flag;
-      midiInThread.resize(getNumPorts());
-      threadinitport.resize(getNumPorts());
       // initialize the static arrays
       for (int i=0; i<getNumPorts(); i++) {
          portObjectCount[i] = 0;
          trace[i] = 0;
          pauseQ[i] = 0;
-         midiBuffer[i] = new CircularBuffer<smf::MidiEvent>;
+         midiBuffer[i] = new SpscBuffer<MidiInputRecord>;
          midiBuffer[i]->setSize(DEFAULT_INPUT_BUFFER_SIZE);
+         inputCallback[i].store(NULL);
+         sysexPool[i] = new SysexPool(128);
+         inputCounters[i].received.store(0);
+         inputCounters[i].dropped.store(0);
+         inputCounters[i].bytes.store(0);
+         inputCounters[i].peak.store(0);
+         overflowPolicy[i].store(MIDI_OVERFLOW_DROP_NEWEST);
+         growLimit[i] = DEFAULT_INPUT_BUFFER_SIZE * DEFAULT_GROW_FACTOR;
+         inputWriting[i].store(0);
+         bufferExclusive[i].store(0);
+      }
+
+      // create the descriptors which are signaled when input arrives.
+      // These are never closed since an input thread may still be
+      // writing to them.
+      if ((int)inputEventFd.size() != getNumPorts()) {
+         inputEventFd.resize(getNumPorts());
+         for (int i=0; i<getNumPorts(); i++) {
+            inputEventFd[i] = eventfd(0, EFD_NONBLOCK);
+            if (inputEventFd[i] < 0) {
+               cout << "Unable to create MIDI input event descriptor." 
+                    << endl;
+               exit(1);
+            }
+         }
+      }
 
-         sysexWriteBuffer[i] = 0;
-         sysexBuffers[i] = new vector<uchar>[128];
-         for (int n=0; n<128; n++) {
-            sysexBuffers[i][n].reserve(32);
-            sysexBuffers[i][n].clear();
+      // start the input threads, no more threads than ports
+      int threadCount = inputThreadCount;
+      if (threadCount > getNumPorts()) {
+         threadCount = getNumPorts();
+      }
+      int flag;
+      inputThreadStop.store(0);
+      midiInThread.resize(threadCount);
+      threadinitport.resize(threadCount);
+      inputWakeFd.resize(threadCount);
+      for (int t=0; t<threadCount; t++) {
+         inputWakeFd[t] = eventfd(0, EFD_NONBLOCK);
+         if (inputWakeFd[t] < 0) {
+            cout << "Unable to create MIDI input wakeup descriptor." << endl;
+            exit(1);
          }
-    
-         threadinitport[i] = i;
-         flag = pthread_create(&midiInThread[i], NULL, 
-            interpretMidiInputStreamPrivateALSA, &threadinitport[i]);
-         if (flag == -1) {
+         threadinitport[t] = t;
+         flag = pthread_create(&midiInThread[t], NULL, 
+            interpretMidiInputStreamPrivateALSA, &threadinitport[t]);
+         if (flag != 0) {
             cout << "Unable to create MIDI input thread." << endl;
             exit(1);
          }
@@ -689,6 +1368,88 @@ void MidiInPort_alsa::initialize(void) {
 
 
 
+//////////////////////////////
+//
+// MidiInPort_alsa::releaseSysex -- give up the sysex buffers of the
+//	previously extracted sysex messages, so they can be reused.
+//
+
+void MidiInPort_alsa::releaseSysex(void) {
+   if (port != -1 && sysexPool != NULL) {
+      for (int i=0; i<(int)heldSysex.size(); i++) {
+         sysexPool[port]->release(heldSysex[i]);
+      }
+   }
+   heldSysex.clear();
+}
+
+
+
+//////////////////////////////
+//
+// MidiInPort_alsa::signalInput -- tell anyone waiting on the input
+//     event descriptor of the port that there are new messages.
+//
+
+void MidiInPort_alsa::signalInput(int aPort) {
+   if (aPort < 0 || aPort >= (int)inputEventFd.size()) {
+      return;
+   }
+   uint64_t one = 1;
+   if (::write(inputEventFd[aPort], &one, sizeof(one)) < 0) {
+      // the counter is already at its maximum value, so still readable
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiInPort_alsa::stopInputThreads -- tell the input threads to exit,
+//     wake them up in case they are waiting for input, and wait until
+//     they have finished.  Their wakeup descriptors are then closed.
+//
+
+void MidiInPort_alsa::stopInputThreads(void) {
+   inputThreadStop.store(1, std::memory_order_release);
+   uint64_t one = 1;
+   int t;
+   for (t=0; t<(int)inputWakeFd.size(); t++) {
+      if (::write(inputWakeFd[t], &one, sizeof(one)) < 0) {
+         // the thread will notice the stop flag at its next timeout
+      }
+   }
+   for (t=0; t<(int)midiInThread.size(); t++) {
+      pthread_join(midiInThread[t], NULL);
+   }
+   for (t=0; t<(int)inputWakeFd.size(); t++) {
+      ::close(inputWakeFd[t]);
+   }
+   midiInThread.clear();
+   inputWakeFd.clear();
+}
+
+
+
+//////////////////////////////
+//
+// MidiInPort_alsa::wakeInputThread -- tell the input thread which
+//     watches the given port to update its list of open ports.
+//
+
+void MidiInPort_alsa::wakeInputThread(int aPort) {
+   if (aPort < 0 || inputWakeFd.size() == 0) {
+      return;
+   }
+   uint64_t one = 1;
+   if (::write(inputWakeFd[aPort % inputWakeFd.size()], &one, 
+         sizeof(one)) < 0) {
+      // the thread will notice the change at its next timeout
+   }
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////
 //
 // friendly functions 
@@ -700,6 +1461,17 @@ void MidiInPort_alsa::initialize(void) {
 // interpretMidiInputStreamPrivateALSA -- handles the MIDI input stream
 //     for the various input devices from the ALSA MIDI driver.
 //
+//  Note about input threads:
+//     Each input thread watches the rawmidi descriptors of every
+//     port whose number modulo the thread count equals the thread
+//     index, so with the default of one thread, a single thread 
+//     waits in epoll_wait() for all of the input ports.  Ports are
+//     added to (or removed from) the epoll set when they are opened 
+//     (or closed).  The parsing state for each port is kept separately
+//     since the bytes from different ports are interleaved in time.
+//     The threads exit when deinitialize() sets inputThreadStop and
+//     wakes them through their wakeup descriptors.
+//
 //  Note about system exclusive messages:
 //     System Exclusive messages are stored in a separate buffer from
 //     Other Midi messages since they can be variable in length.  If
@@ -707,7 +1479,15 @@ void MidiInPort_alsa::initialize(void) {
 //     the getP1() byte indicates the system exclusive buffer number that is
 //     holding the system exclusive data for that Midi message.  There
 //     are 128 system exclusive buffers that are numbered between
-//     0 and 127.  These buffers are filled in a cycle.
+//     0 and 127.  The buffers are filled in a cycle, but a buffer
+//     is skipped while its message is still in use.  A message is in
+//     use from the time it arrives until another sysex message is
+//     extracted after it (or until the input callback returns, if the
+//     message is not stored in the input buffer).  If all of the buffers
+//     are in use, new sysex messages are dropped rather than overwriting
+//     unread ones; getSysexOverflowCount() returns the number dropped.
+//     The parser assembles each sysex in place, and its storage is
+//     exchanged with the buffer storage, so the bytes are not copied.
 //     To extract a System exclusive message from MidiInPort_alsa,
 //     you first will receive a Message with a command byte of 0xf0.
 //     you can then access the data for that sysex by the command:
@@ -731,7 +1511,10 @@ void MidiInPort_alsa::initialize(void) {
 //     will resize the sysex buffer to its default size (currently 32 bytes).
 //     clearSysex() without arguments will resize all buffers so that
 //     they are allocated to the default size and will erase data from
-//     all buffers.  You can spoof a system exclusive message coming in
+//     all buffers.  To keep a sysex message for longer, use 
+//     getSysexView(buffer_number), which holds the buffer until the 
+//     returned SysexView (and all copies of it) are destroyed.
+//     You can spoof a system exclusive message coming in
 //     by installing a system exclusive message and then inserting
 //     the system message command into the input buffer of the MidiInPort
 //     class,  int sysex_buffer = MidiInPort_alsa::installSysex(
@@ -742,62 +1525,79 @@ void MidiInPort_alsa::initialize(void) {
 //     as a running status messages.
 //
 // Note about MidiEvent time stamps:
-//     The MidiEvent::tick field is a recording of the time that the 
-//     first byte of the MidiEvent arrived.  If the message is from
-//     running status mode, then the time that the first parameter byte
-//     arrived is stored.   System exclusive message arrival times are
-//     recoreded at the time of the last byte (0xf7) arriving.  This is
-//     because other system messages can be coming in while the sysex
-//     message is coming in.  Anyway, sysex messages are not really to
-//     be used for real time MIDI messaging, so the exact moment that the
-//     first byte of the sysex came in is not important to me.
+//     Each message is stamped with the CLOCK_MONOTONIC time in 
+//     nanoseconds that its first byte arrived, which is returned by
+//     extract(event, timestamp).  If the driver supports timestamped
+//     reads (ALSA 1.2.6 and later), the time recorded by the driver
+//     is used; otherwise the time that epoll_wait() returned for the
+//     block of bytes is used.  The MidiEvent::tick field holds the same
+//     time in milliseconds on the midiTimer clock.  If the message is 
+//     from running status mode, then the time that the first parameter 
+//     byte arrived is stored.   System exclusive message arrival times 
+//     are the time that the starting 0xf0 byte arrived.
 //
 //
 
 void *interpretMidiInputStreamPrivateALSA(void * arg) {
-   int portToWatch = *(int*)arg;
-   if (portToWatch < 0 || portToWatch > 1000) {
-      // the port to watch is invalid -- because the program has died 
+   int threadIndex = *(int*)arg;
+   int threadCount = (int)MidiInPort_alsa::midiInThread.size();
+   if (threadIndex < 0 || threadIndex >= threadCount) {
+      // the thread index is invalid -- because the program has died 
       // before the thread function could start.  Cause of invalid port 
       // data should be examined more carefully.
       return NULL;
    }
 
-   int* argsExpected = NULL;     // MIDI parameter bytes expected to follow
-   int* argsLeft     = NULL;     // MIDI parameter bytes left to wait for
-   uchar packet[1];              // bytes for sequencer driver
-   smf::MidiEvent* message = NULL;  // holder for current MIDI message
+   uchar packet[INPUT_READ_SIZE]; // bytes for sequencer driver
    int newSigTime = 0;           // for millisecond timer
-   // int lastSigTime = -1;      // for millisecond timer
    int zeroSigTime = -1;         // for timing incoming events
    int device = -1;              // for sorting out the bytes by input device
-   vector<uchar>* sysexIn;       // MIDI Input sysex temporary storage
-
-   // Note on the use of argsExpected and argsLeft for sysexs:
-   // If argsExpected is -1, then a sysex message is coming in.
-   // If argsLeft < 0, then the sysex message has not finished comming
-   // in.  If argsLeft == 0 and argsExpected == -1, then the sysex
-   // has finished coming in and is to be sent to the correct
-   // location.
-
-   // allocate space for MIDI messages, each device has a different message
-   // holding spot in case the messages overlap in the input stream
-   message      = new smf::MidiEvent[MidiInPort_alsa::numDevices];
-   argsExpected = new int[MidiInPort_alsa::numDevices];
-   argsLeft     = new int[MidiInPort_alsa::numDevices];
-
-   sysexIn = new vector<uchar>[MidiInPort_alsa::numDevices];
+
+   // each device has its own parser and message holding spot since
+   // the messages from different devices overlap in time.
+   AlsaInputState* state = new AlsaInputState[MidiInPort_alsa::numDevices];
    for (int j=0; j<MidiInPort_alsa::numDevices; j++) {
-      sysexIn[j].clear();
-      sysexIn[j].reserve(32);
+      state[j].device = j;
+      state[j].blockTime = 0;
+      state[j].blockTick = 0;
+      state[j].pending = 0;
+      state[j].parser.setCallback(MidiInPort_alsa::storeParsedInput, 
+            &state[j]);
+   }
+
+   // rawmidi handles which are currently in the epoll set of this
+   // thread, and the file descriptors which were added for them
+   vector<snd_rawmidi_t*> watched(MidiInPort_alsa::numDevices, NULL);
+   vector<vector<int> > watchedfds(MidiInPort_alsa::numDevices);
+
+   int epfd = epoll_create1(0);
+   if (epfd < 0) {
+      cerr << "Error: cannot create MIDI input event descriptor" << endl;
+      delete [] state;
+      return NULL;
    }
+   struct epoll_event ev;
+   ev.events = EPOLLIN;
+   ev.data.u32 = INPUT_WAKE_ID;
+   epoll_ctl(epfd, EPOLL_CTL_ADD, 
+         MidiInPort_alsa::inputWakeFd[threadIndex], &ev);
 
    // interpret MIDI bytes as they come into the computer
    // and repackage them as MIDI messages.
+   struct epoll_event events[MAX_INPUT_EVENTS];
+   struct pollfd pfds[MAX_INPUT_POLL_DESCRIPTORS];
+   snd_rawmidi_t* handle = NULL;
+   int pfdcount;
+   int eventCount;
    int packetReadCount;
-   while (1) {
-top_of_loop:
-      packetReadCount = 0;
+   int tstampQ;
+   struct timespec tstamp;
+   int64_t wakeTime;
+   int64_t arrivalTime;
+   int port;
+   int e, j;
+   uint64_t wakecount;
+   while (!MidiInPort_alsa::inputThreadStop.load(std::memory_order_acquire)) {
 
       // If the all Sequencer_alsa classes have been deleted,
       // then Sequencer_alsa::rawmidi_in will have zero size.
@@ -805,235 +1605,325 @@ top_of_loop:
       // killed soon, and we do not want any processing to happen
       // in this thread.  If the port to watch is NULL, then that
       // means that the MIDI input is not open, and we should not
-      // add any MIDI data to the input buffers.  These cases are
-      // handled by the following if-else statement:
-      if (Sequencer_alsa::rawmidi_in.size() > 0 && 
-            Sequencer_alsa::rawmidi_in[portToWatch] != NULL) {
-         packetReadCount = snd_rawmidi_read(
-               Sequencer_alsa::rawmidi_in[portToWatch], packet, 1);
-      } else {
-         usleep(100000);  // sleep for 1/10th of a second if the Input 
-                          // port is not open.         
-         continue;
-      }
-
-
-      if (packetReadCount != 1) {
-         // this if statement is used to prevent cases where the
-         // read function above will time out and return 0 bytes 
-         // read.  This if statment will also take care of -1 
-         // error return values by ignoring them.
-         continue;
+      // add any MIDI data to the input buffers.  Keep the epoll set 
+      // up to date with the ports which are currently open:
+      for (port=threadIndex; port<MidiInPort_alsa::numDevices; 
+            port+=threadCount) {
+         handle = NULL;
+         if (port < (int)Sequencer_alsa::rawmidi_in.size()) {
+            handle = Sequencer_alsa::rawmidi_in[port];
+         }
+         if (handle == watched[port]) {
+            continue;
+         }
+         for (j=0; j<(int)watchedfds[port].size(); j++) {
+            epoll_ctl(epfd, EPOLL_CTL_DEL, watchedfds[port][j], NULL);
+         }
+         watchedfds[port].clear();
+         watched[port] = handle;
+         if (handle == NULL) {
+            continue;
+         }
+         pfdcount = snd_rawmidi_poll_descriptors(handle, pfds, 
+               MAX_INPUT_POLL_DESCRIPTORS);
+         for (j=0; j<pfdcount; j++) {
+            ev.events = EPOLLIN;
+            ev.data.u32 = port;
+            if (epoll_ctl(epfd, EPOLL_CTL_ADD, pfds[j].fd, &ev) == 0) {
+               watchedfds[port].push_back(pfds[j].fd);
+            }
+         }
       }
 
-      if (Sequencer_alsa::initialized == 0) {
-         continue;
-      }
+      // sleep until there is input to read on any of the ports.  The 
+      // timeout allows the thread to notice when a port has been closed.
+      eventCount = epoll_wait(epfd, events, MAX_INPUT_EVENTS, 
+            INPUT_POLL_TIMEOUT);
+      wakeTime = SigTimer::getMonotonicTime();
+
+      for (e=0; e<eventCount; e++) {
+         if (events[e].data.u32 == INPUT_WAKE_ID) {
+            // a port was opened or closed: rescan the port list
+            if (::read(MidiInPort_alsa::inputWakeFd[threadIndex], 
+                  &wakecount, sizeof(wakecount)) < 0) {
+               // nothing to do: the counter was already cleared
+            }
+            continue;
+         }
 
-      // determination of a full MIDI message from the input MIDI
-      // stream is based here on the observation that MIDI status
-      // bytes and subsequent data bytes are NOT returned in the same
-      // read() call.  Rather, they are spread out over multiple read()
-      // returns, with only a single value per return.  So if we
-      // find a status byte, we then determine the number of expected
-      // operands and process that number of subsequent read()s to
-      // to determine the complete midi message.
-
-      // store the MIDI input device to which the incoming MIDI
-      // byte belongs.
-      device = portToWatch;
-     
-      // ignore the active sensing 0xfe and MIDI clock 0xf8 commands:
-      if (packet[0] == 0xfe || packet[0] == 0xf8) {
-         continue;
-      }
+         // store the MIDI input device to which the incoming MIDI
+         // bytes belong.
+         device = (int)events[e].data.u32;
+         if (device >= (int)Sequencer_alsa::rawmidi_in.size() ||
+               Sequencer_alsa::rawmidi_in[device] == NULL) {
+            continue;
+         }
 
-      if (packet[0] & 0x80) {   // a command byte has arrived
-         switch (packet[0] & 0xf0) {
-            case 0xf0:   
-               if (packet[0] == 0xf0) {
-                  argsExpected[device] = -1;
-                  argsLeft[device] = -1;
-                  if (sysexIn[device].size() != 0) {
-                     // ignore the command for now.  It is most
-                     // likely an active sensing message.
-                     goto top_of_loop;
-                  } else {
-                     uchar datum = 0xf0;
-                     sysexIn[device].push_back(datum);
-                  }
-               } if (packet[0] == 0xf7) {
-                  argsLeft[device] = 0;         // indicates sysex is done
-                  uchar datum = 0xf7;
-                  sysexIn[device].push_back(datum);
-               } else if (argsExpected[device] != -1) {
-                  // this is a system message that may or may
-                  // not be coming while a sysex is coming in
-                  argsExpected[device] = 0;
-               } else {
-                  // this is a system message that is not coming
-                  // while a system exclusive is coming in
-                  //argsExpected[device] = 0;
-               }
-               break;
-            case 0xc0:   
-               if (argsExpected[device] < 0) {
-                  cout << "Error: received program change during sysex" 
-                       << endl;
-                  exit(1);
-               } else {
-                  argsExpected[device] = 1;    
-               }
+         handle = Sequencer_alsa::rawmidi_in[device];
+         tstampQ = Sequencer_alsa::rawmidi_in_tstamp[device];
+
+         // read everything which is waiting in the driver.  If the
+         // driver does not stamp the bytes, the first block is stamped 
+         // with the time that epoll_wait() returned, and later blocks
+         // with the time just before they were read.
+         arrivalTime = wakeTime;
+         while (1) {
+#if SND_LIB_VERSION >= 0x010206
+            if (tstampQ) {
+               packetReadCount = snd_rawmidi_tread(handle, &tstamp, 
+                     packet, INPUT_READ_SIZE);
+            } else {
+               packetReadCount = snd_rawmidi_read(handle, packet, 
+                     INPUT_READ_SIZE);
+            }
+#else
+            packetReadCount = snd_rawmidi_read(handle, packet, 
+                  INPUT_READ_SIZE);
+#endif
+            if (packetReadCount <= 0) {
+               // This if statment will take care of -EAGAIN and 
+               // other error return values by ignoring them.
                break;
-            case 0xd0:   
-               if (argsExpected[device] < 0) {
-                  cout << "Error: received aftertouch message during" 
-                          " sysex" << endl;
-                  exit(1);
-               } else {
-                  argsExpected[device] = 1;    
-               }
+            }
+
+            if (Sequencer_alsa::initialized == 0 || 
+                  MidiInPort_alsa::inputThreadStop.load(
+                  std::memory_order_relaxed)) {
                break;
-            default:     
-               if (argsExpected[device] < 0) {
-                  cout << "Error: received another message during sysex" 
-                       << endl;
-                  exit(1);
-               } else {
-                  argsExpected[device] = 2;    
+            }
+
+            addCount(MidiInPort_alsa::inputCounters[device].bytes, 
+                  packetReadCount);
+            newSigTime = MidiInPort_alsa::midiTimer.getTime();
+            state[device].blockTick = newSigTime - zeroSigTime;
+            state[device].blockTime = SigTimer::getMonotonicTime();
+            if (tstampQ && (tstamp.tv_sec != 0 || tstamp.tv_nsec != 0)) {
+               // the time that the driver received the first byte
+               arrivalTime = (int64_t)tstamp.tv_sec * 1000000000 + 
+                     tstamp.tv_nsec;
+               if (arrivalTime > state[device].blockTime) {
+                  arrivalTime = state[device].blockTime;
                }
-               break;
-         }
-         if (argsExpected[device] >= 0) {
-            argsLeft[device] = argsExpected[device];
+            }
+
+            // A single read() can return several complete messages, or
+            // a message may be split across two reads, so the parser for
+            // each device keeps its state between reads.
+            state[device].parser.parse(packet, packetReadCount, 
+                  arrivalTime);
+            if (state[device].pending) {
+               // wake up one time for all of the messages in the block
+               state[device].pending = 0;
+               MidiInPort_alsa::signalInput(device);
+            }
+
+            arrivalTime = SigTimer::getMonotonicTime();
          }
+      } // end for (e)
 
-         newSigTime = MidiInPort_alsa::midiTimer.getTime();
-         message[device].tick = newSigTime - zeroSigTime;
+   } // end while (!inputThreadStop)
+
+   // deinitialize() has stopped the thread, and is waiting for it to
+   // finish before freeing the port storage
+
+   if (state != NULL) {
+      delete [] state;
+      state = NULL;
+   }
+
+   ::close(epfd);
+
+   return NULL;
+}
 
-         if (packet[0] != 0xf7) {
-            message[device].setP0(packet[0]);
-         } 
-         message[device].setP1(0);
-         message[device].setP2(0);
-         message[device].setP3(0);
 
-         if (packet[0] == 0xf7) {
-            goto sysex_done;
-         }
-      } else if (argsLeft[device]) {   // not a command byte coming in
-         if (message[device].tick == 0) {
-            // store the receipt time of the first message byte
-            newSigTime = MidiInPort_alsa::midiTimer.getTime();
-            message[device].tick = newSigTime - zeroSigTime;
-         }
-            
-         if (argsExpected[device] < 0) {
-            // continue processing a sysex message
-            sysexIn[device].push_back(packet[0]);
-         } else {
-            // handle a message other than a sysex message
-            if (argsLeft[device] == argsExpected[device]) {
-               message[device].setP1(packet[0]);
-            } else {
-               message[device].setP2(packet[0]);
-            }
-            argsLeft[device]--;
-         }
 
-         // if MIDI message is complete, setup for running status, and 
-         // insert note into proper buffer.
-
-         if (argsExpected[device] >= 0 && !argsLeft[device]) {
-
-            // store parameter data for running status
-            switch (message[device].getP0() & 0xf0) {
-               case 0xc0:      argsLeft[device] = 1;      break;
-               case 0xd0:      argsLeft[device] = 1;      break;  // fix by dan
-               default:        argsLeft[device] = 2;      break;
-                  // 0x80 expects two arguments
-                  // 0x90 expects two arguments
-                  // 0xa0 expects two arguments
-                  // 0xb0 expects two arguments
-                  // 0xe0 expects two arguments
-            }
 
-            // lastSigTime = newSigTime;
-
-            sysex_done:      // come here when a sysex is completely done
-
-            // insert the MIDI message into the appropriate buffer
-            // do not insert into buffer if the MIDI input device
-            // is paused (which can mean closed).  Or if the
-            // pauseQ array is pointing to NULL (which probably means that
-            // things are about to shut down).
-            if (MidiInPort_alsa::pauseQ != NULL &&
-                  MidiInPort_alsa::pauseQ[device] == 0) {
-               if (argsExpected[device] < 0) {
-                  // store the sysex in the MidiInPort_alsa
-                  // buffer for sysexs and return the storage
-                  // location:
-                  int sysexlocation = 
-                     MidiInPort_alsa::installSysexPrivate(device,
-                        sysexIn[device].data(),
-                        sysexIn[device].size());
-
-                  message[device].setP0(0xf0);
-                  message[device].setP1(sysexlocation);
-
-                  sysexIn[device].clear(); // empty the sysex storage
-                  argsExpected[device] = 0;   // no run status for sysex
-                  argsLeft[device] = 0;       // turn off sysex input flag
+//////////////////////////////
+//
+// MidiInPort_alsa::bufferInput -- place a message and its arrival time
+//     into the input buffer of the device, following the overflow 
+//     policy of the device if the buffer is full.  Returns 1 if the 
+//     message was stored, or 0 if it was dropped.  Called only from the
+//     input thread.
+//
+
+int MidiInPort_alsa::bufferInput(int device, const smf::MidiEvent& message,
+      int64_t timestamp) {
+   PortCounters& counters = inputCounters[device];
+   SpscBuffer<MidiInputRecord>& events = *midiBuffer[device];
+   int policy = overflowPolicy[device].load(std::memory_order_relaxed);
+
+   // insert() and setBufferSize() write to the buffer while holding
+   // the buffer lock, so take the lock if either is doing so.  The lock
+   // keeps them out, so they do not have to wait for the mark then.
+   InputWriteMark mark(inputWriting[device]);
+   std::unique_lock<std::mutex> lock(bufferLock[device], std::defer_lock);
+   if (needsBufferLock(policy) || bufferExclusive[device].load() > 0) {
+      mark.clear();
+      lock.lock();
+      // the policy can only change while the lock is held
+      policy = overflowPolicy[device].load(std::memory_order_relaxed);
+   }
+
+   if (events.capacity() <= 0) {
+      switch (policy) {
+         case MIDI_OVERFLOW_DROP_OLDEST:
+            {
+               // the reader is locked out, so the input thread can 
+               // remove the oldest message itself
+               MidiInputRecord oldest;
+               events.extract(oldest);
+               if (oldest.event.getP0() == 0xf0) {
+                  sysexPool[device]->release(oldest.event.getP1());
                }
-               MidiInPort_alsa::midiBuffer[device]->insert(
-                     message[device]);
-//                   if (MidiInPort_alsa::callbackFunction != NULL) {
-//                      MidiInPort_alsa::callbackFunction(device);
-//                   }
-               if (MidiInPort_alsa::trace[device]) {
-                  cout << '[' << hex << (int)message[device].getP0()
-                       << ':' << dec << (int)message[device].getP1()
-                       << ',' << (int)message[device].getP2() << ']'
-                       << flush;
+               addCount(counters.dropped, 1);
+            }
+            break;
+         case MIDI_OVERFLOW_GROW:
+            if (events.getSize() < growLimit[device]) {
+               int newsize = events.getSize() * 2;
+               if (newsize > growLimit[device]) {
+                  newsize = growLimit[device];
                }
-               message[device].tick = 0;
-            } else {
-               if (MidiInPort_alsa::trace[device]) {
-                  cout << '[' << hex << (int)message[device].getP0()
-                       << 'P' << dec << (int)message[device].getP1()
-                       << ',' << (int)message[device].getP2() << ']'
-                       << flush;
+               events.resize(newsize);
+            }
+            break;
+         case MIDI_OVERFLOW_BLOCK:
+            // wake up the reader and wait for it to make some space
+            while (events.capacity() <= 0) {
+               if (pauseQ == NULL || pauseQ[device] || 
+                     Sequencer_alsa::initialized == 0 ||
+                     inputThreadStop.load(std::memory_order_relaxed) ||
+                     bufferExclusive[device].load() > 0) {
+                  break;
                }
+               signalInput(device);
+               usleep(BLOCK_WAIT_TIME);
             }
-         }
+            break;
+      }
+      if (events.capacity() <= 0) {
+         addCount(counters.dropped, 1);
+         return 0;
       }
+   }
 
-   } // end while (1)
+   // the message and its arrival time are stored in one slot, so the
+   // reader always sees them together
+   MidiInputRecord record;
+   record.event = message;
+   record.timestamp = timestamp;
+   events.insert(record);
 
-   // This code is not yet reached, but should be made to do so eventually
+   int count = events.getCount();
+   if (count > counters.peak.load(std::memory_order_relaxed)) {
+      counters.peak.store(count, std::memory_order_relaxed);
+   }
+   return 1;
+}
 
-   if (message != NULL) {
-      delete message;
-      message = NULL;
+
+
+//////////////////////////////
+//
+// MidiInPort_alsa::storeParsedInput -- called by the input parser
+//     for each complete MIDI message.  The message is placed in the 
+//     input buffer of the device, unless the device is paused (which
+//     can mean closed), or the pauseQ array is NULL (which probably 
+//     means that things are about to shut down), or the input filter
+//     of the device rejects the message.  Filtered messages are not 
+//     passed to the input callback either.
+//
+
+void MidiInPort_alsa::storeParsedInput(const uchar* data, int size, 
+      int64_t timestamp, void* userdata) {
+   AlsaInputState& state = *(AlsaInputState*)userdata;
+   int device = state.device;
+   smf::MidiEvent& message = state.message;
+
+   addCount(inputCounters[device].received, 1);
+
+   // ignore unwanted messages (by default active sensing 0xfe 
+   // and MIDI clock 0xf8):
+   if (inputFilter == NULL || !inputFilter[device].accept(data, size)) {
+      return;
    }
 
-   if (argsExpected != NULL) {
-      delete argsExpected;
-      argsExpected = NULL;
+   message.setP0(data[0]);
+   if (data[0] == 0xf0) {
+      message.setP1(0);
+      message.setP2(0);
+   } else {
+      message.setP1(size > 1 ? data[1] : 0);
+      message.setP2(size > 2 ? data[2] : 0);
+   }
+   message.setP3(0);
+   // millisecond time for compatibility with older programs
+   message.tick = state.blockTick - 
+         (int)((state.blockTime - timestamp) / 1000000);
+
+   if (pauseQ == NULL || pauseQ[device] != 0) {
+      if (trace != NULL && trace[device]) {
+         MidiTrace::record(MIDI_TRACE_INPUT, device, data, size, 
+               MIDI_TRACE_PAUSED, timestamp);
+      }
+      return;
    }
 
-   if (argsLeft != NULL) {
-      delete argsLeft;
-      argsLeft = NULL;
+   // record the message with its arrival time before the sysex data
+   // is handed over to the sysex pool
+   if (inputRecorder != NULL) {
+      inputRecorder[device].recordInput(device, data, size, timestamp);
    }
 
-   if (sysexIn != NULL) { 
-      delete sysexIn;
-      sysexIn = NULL;
+   int sysexBuffer = -1;
+   if (data[0] == 0xf0) {
+      // move the sysex from the parser into the MidiInPort_alsa buffer
+      // for sysexs and return the storage location:
+      state.parser.swapSysex(state.sysex);
+      sysexBuffer = sysexPool[device]->store(state.sysex);
+      if (sysexBuffer < 0) {
+         // all sysex buffers hold unread messages: drop the message
+         if (trace[device]) {
+            MidiTrace::record(MIDI_TRACE_INPUT, device, data, size, 
+                  MIDI_TRACE_DROPPED, timestamp);
+         }
+         return;
+      }
+      message.setP1(sysexBuffer);
    }
 
+   if (trace[device]) {
+      // record the trace before anyone else can see the message, since
+      // the sysex data now belongs to the sysex pool
+      MidiTrace::record(MIDI_TRACE_INPUT, device, sysexBuffer < 0 ? data :
+            sysexPool[device]->getData(sysexBuffer), size, 0, timestamp);
+   }
 
-   return NULL;
+   // let the user respond to the message immediately
+   MidiInputCallback* callback = NULL;
+   if (inputCallback != NULL) {
+      callback = inputCallback[device].load(std::memory_order_acquire);
+   }
+   if (callback != NULL) {
+      callback->function(message, device, callback->userdata);
+   }
+
+   if (callback == NULL || !callback->callbackOnly) {
+      if (!bufferInput(device, message, timestamp)) {
+         // buffer is full: the message was dropped
+         if (sysexBuffer >= 0) {
+            sysexPool[device]->release(sysexBuffer);
+         }
+         return;
+      }
+      // The reference to the sysex buffer is passed on to the object 
+      // which extracts the message.
+      state.pending = 1;
+   } else if (sysexBuffer >= 0) {
+      sysexPool[device]->release(sysexBuffer);
+   }
 }
 
 
@@ -8,6 +8,9 @@
 // Last Modified: Wed May 10 17:10:05 PDT 2000 (name change from _linux to _oss)
 // Last Modified: Fri Oct 26 14:41:36 PDT 2001 (running status for 0xa0 and 0xd0 
 //                                              fixed by Daniel Gardner)
+// Last Modified: Sat Oct 17 12:05:51 PDT 2026 (use MidiStreamParser)
+// Last Modified: Sat Oct 17 14:58:33 PDT 2026 (per-port input filters)
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026 (recording in input thread)
 // Filename:      ...sig/code/control/MidiInPort/linux/MidiInPort_oss.cpp
 // Web Address:   http://sig.sapp.org/src/sig/MidiInPort_oss.cpp
 // Syntax:        C++ 
@@ -21,6 +24,7 @@
 
 using namespace std;
 #include "MidiInPort_oss.h"
+#include "MidiStreamParser.h"
 #include <stdlib.h>
 #include <pthread.h>
 #include <linux/soundcard.h>
@@ -34,6 +38,13 @@ using namespace std;
 
 #define DEFAULT_INPUT_BUFFER_SIZE (1024)
 
+// parsing state for one input device, owned by the input thread
+struct OssInputState {
+   int              device;      // input port number
+   MidiStreamParser parser;      // converts bytes into MIDI messages
+   smf::MidiEvent   message;     // holding spot for the current message
+};
+
 // initialized static variables
 int       MidiInPort_oss::numDevices                     = 0;
 int       MidiInPort_oss::objectCount                    = 0;
@@ -47,6 +58,8 @@ ostream*  MidiInPort_oss::tracedisplay                   = &cout;
 pthread_t MidiInPort_oss::midiInThread;    
 int*      MidiInPort_oss::sysexWriteBuffer               = NULL;
 Array<uchar>** MidiInPort_oss::sysexBuffers              = NULL;
+MidiInputFilter* MidiInPort_oss::inputFilter              = NULL;
+MidiRecorderSlot* MidiInPort_oss::inputRecorder           = NULL;
 
 
 //////////////////////////////
@@ -170,6 +183,37 @@ void MidiInPort_oss::extract(smf::MidiEvent& event) {
 }
 
 
+//
+// Version with a timestamp: this driver does not record arrival times,
+//	so the timestamp is the millisecond tick time in nanoseconds.
+//
+
+void MidiInPort_oss::extract(smf::MidiEvent& event, int64_t& timestamp) {
+   extract(event);
+   timestamp = (int64_t)event.tick * 1000000;
+}
+
+
+//
+// Bulk version: extracts up to count waiting messages into the
+//	events array, and returns the number of messages extracted.
+//
+
+int MidiInPort_oss::extract(smf::MidiEvent* events, int count, 
+      int64_t* timestamps) {
+   int i = 0;
+   while (i < count && getCount() > 0) {
+      if (timestamps != NULL) {
+         extract(events[i], timestamps[i]);
+      } else {
+         extract(events[i]);
+      }
+      i++;
+   }
+   return i;
+}
+
+
 
 //////////////////////////////
 //
@@ -211,6 +255,22 @@ int MidiInPort_oss::getCount(void) {
 
 
 
+//////////////////////////////
+//
+// MidiInPort_oss::getFilter -- returns the filter which decides which
+//	incoming messages are stored in the input buffer of the port.
+//
+
+MidiInputFilter& MidiInPort_oss::getFilter(void) {
+   if (getPort() == -1) {
+      static MidiInputFilter nullFilter;
+      return nullFilter;
+   }
+   return inputFilter[getPort()];
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_oss::getName -- returns the name of the port.
@@ -267,6 +327,21 @@ int MidiInPort_oss::getPortStatus(void) {
 
 
 
+//////////////////////////////
+//
+// MidiInPort_oss::getRecorder -- returns the recorder of the port, or
+//	NULL if the input of the port is not being recorded.
+//
+
+MidiFileRecorder* MidiInPort_oss::getRecorder(void) {
+   if (getPort() == -1 || inputRecorder == NULL) {
+      return NULL;
+   }
+   return inputRecorder[getPort()].get();
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_oss::getSysex -- returns the sysex message contents
@@ -483,6 +558,24 @@ void MidiInPort_oss::setPort(int aPort) {
 
 
 
+//////////////////////////////
+//
+// MidiInPort_oss::setRecorder -- record the messages which arrive on
+//	the port (after the input filter), or stop recording if aRecorder
+//	is NULL.  The recording is done by the input thread, and is shared
+//	by all objects using the same port.  When this function returns
+//	the input thread is no longer using the previous recorder.
+//
+
+void MidiInPort_oss::setRecorder(MidiFileRecorder* aRecorder) {
+   if (getPort() == -1 || inputRecorder == NULL) {
+      return;
+   }
+   inputRecorder[getPort()].set(aRecorder);
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_oss::setTrace -- if false, then don't print MIDI messages
@@ -567,6 +660,16 @@ void MidiInPort_oss::deinitialize(void) {
       midiBuffer = NULL;
    }
 
+   if (inputFilter != NULL) {
+      delete [] inputFilter;
+      inputFilter = NULL;
+   }
+
+   if (inputRecorder != NULL) {
+      delete [] inputRecorder;
+      inputRecorder = NULL;
+   }
+
    if (portObjectCount != NULL) {
       delete [] portObjectCount;
       portObjectCount = NULL;
@@ -624,6 +727,18 @@ void MidiInPort_oss::initialize(void) {
       }
       midiBuffer = new CircularBuffer<smf::MidiEvent>*[numDevices];
 
+      // allocate space for the input filters
+      if (inputFilter != NULL) {
+         delete [] inputFilter;
+      }
+      inputFilter = new MidiInputFilter[numDevices];
+
+      // allocate space for the recorders of the ports
+      if (inputRecorder != NULL) {
+         delete [] inputRecorder;
+      }
+      inputRecorder = new MidiRecorderSlot[numDevices];
+
       // allocate space for Midi input sysex buffer write indices
       if (sysexWriteBuffer != NULL) {
          delete [] sysexWriteBuffer;
@@ -724,50 +839,30 @@ void MidiInPort_oss::initialize(void) {
 //     first byte of the MidiEvent arrived.  If the message is from
 //     running status mode, then the time that the first parameter byte
 //     arrived is stored.   System exclusive message arrival times are
-//     recoreded at the time of the last byte (0xf7) arriving.  This is
-//     because other system messages can be coming in while the sysex
-//     message is coming in.  Anyway, sysex messages are not really to
-//     be used for real time MIDI messaging, so the exact moment that the
-//     first byte of the sysex came in is not important to me.
+//     the time that the starting 0xf0 byte arrived.
 //
 //
 
 void *interpretMidiInputStreamPrivate(void *) {
 
-   int* argsExpected = NULL;     // MIDI parameter bytes expected to follow
-   int* argsLeft     = NULL;     // MIDI parameter bytes left to wait for
    uchar packet[4];              // bytes for sequencer driver
-   smf::MidiEvent* message = NULL;  // holder for current MIDI message
    int newSigTime = 0;           // for millisecond timer
-   // int lastSigTime = -1;         // for millisecond timer
    int zeroSigTime = -1;         // for timing incoming events
    int device = -1;              // for sorting out the bytes by input device
-   Array<uchar>* sysexIn;        // MIDI Input sysex temporary storage
-
-   // Note on the use of argsExpected and argsLeft for sysexs:
-   // If argsExpected is -1, then a sysex message is coming in.
-   // If argsLeft < 0, then the sysex message has not finished comming
-   // in.  If argsLeft == 0 and argsExpected == -1, then the sysex
-   // has finished coming in and is to be sent to the correct
-   // location.
+   OssInputState* state = NULL;  // parsing state for each input device
 
    static int count = 0;
    if (count != 0) {
       cerr << "Cannot run this function more than once" << endl;
       exit(1);
    } else {
-      // allocate space for MIDI messages, each device has a different message
-      // holding spot in case the messages overlap in the input stream
-      message      = new smf::MidiEvent[MidiInPort_oss::numDevices];
-      argsExpected = new int[MidiInPort_oss::numDevices];
-      argsLeft     = new int[MidiInPort_oss::numDevices];
-
-      sysexIn = new Array<uchar>[MidiInPort_oss::numDevices];
+      // each device has its own parser and message holding spot since
+      // the messages from different devices overlap in the input stream
+      state = new OssInputState[MidiInPort_oss::numDevices];
       for (int j=0; j<MidiInPort_oss::numDevices; j++) {
-         sysexIn[j].allowGrowth();
-         sysexIn[j].setSize(32);
-         sysexIn[j].setSize(0);
-         sysexIn[j].setGrowth(512);
+         state[j].device = j;
+         state[j].parser.setCallback(MidiInPort_oss::storeParsedInput, 
+               &state[j]);
       }
 
       count++;
@@ -777,7 +872,6 @@ void *interpretMidiInputStreamPrivate(void *) {
    // and repackage them as MIDI messages.
    int packetReadCount;
    while (1) {
-top_of_loop:
       packetReadCount = ::read(MidiInPort_oss::sequencer_fd, 
          &packet, sizeof(packet));
 
@@ -819,14 +913,11 @@ top_of_loop:
             break;
 
          case SEQ_MIDIPUTC:          // SEQ_MIDIPUTC = 5
-            // determination of a full MIDI message from the input MIDI
-            // stream is based here on the observation that MIDI status
-            // bytes and subsequent data bytes are NOT returned in the same
-            // read() call.  Rather, they are spread out over multiple read()
-            // returns, with only a single value per return.  So if we
-            // find a status byte, we then determine the number of expected
-            // operands and process that number of subsequent read()s to
-            // to determine the complete midi message.
+            // MIDI status bytes and subsequent data bytes are NOT
+            // returned in the same read() call.  Rather, they are spread
+            // out over multiple read() returns, with only a single value
+            // per return, so the parser for each device keeps its state 
+            // between reads.
 
 /*
             cout << "MIDI byte: " << (int)packet[1] << endl;
@@ -835,171 +926,13 @@ top_of_loop:
             // store the MIDI input device to which the incoming MIDI
             // byte belongs.
             device = packet[2];
-           
-            // ignore the active sensing 0xfe and MIDI clock 0xf8 commands:
-            if (packet[1] == 0xfe || packet[1] == 0xf8) {
+            if (device >= MidiInPort_oss::numDevices) {
                break;
             }
 
-            if (packet[1] & 0x80) {   // a command byte has arrived
-               switch (packet[1] & 0xf0) {
-                  case 0xf0:   
-                     if (packet[1] == 0xf0) {
-                        argsExpected[device] = -1;
-                        argsLeft[device] = -1;
-                        if (sysexIn[device].getSize() != 0) {
-                           // ignore the command for now.  It is most
-                           // likely an active sensing message.
-                           goto top_of_loop;
-                        } else {
-                           uchar datum = 0xf0;
-                           sysexIn[device].append(datum);
-                        }
-                     } if (packet[1] == 0xf7) {
-                        argsLeft[device] = 0;         // indicates sysex is done
-                        uchar datum = 0xf7;
-                        sysexIn[device].append(datum);
-                     } else if (argsExpected[device] != -1) {
-                        // this is a system message that may or may
-                        // not be coming while a sysex is coming in
-                        argsExpected[device] = 0;
-                     } else {
-                        // this is a system message that is not coming
-                        // while a system exclusive is coming in
-                        //argsExpected[device] = 0;
-                     }
-                     break;
-                  case 0xc0:   
-                     if (argsExpected[device] < 0) {
-                        cout << "Error: received program change during sysex" 
-                             << endl;
-                        exit(1);
-                     } else {
-                        argsExpected[device] = 1;    
-                     }
-                     break;
-                  case 0xd0:   
-                     if (argsExpected[device] < 0) {
-                        cout << "Error: received aftertouch message during" 
-                                " sysex" << endl;
-                        exit(1);
-                     } else {
-                        argsExpected[device] = 1;    
-                     }
-                     break;
-                  default:     
-                     if (argsExpected[device] < 0) {
-                        cout << "Error: received another message during sysex" 
-                             << endl;
-                        exit(1);
-                     } else {
-                        argsExpected[device] = 2;    
-                     }
-                     break;
-               }
-               if (argsExpected[device] >= 0) {
-                  argsLeft[device] = argsExpected[device];
-               }
-
-               newSigTime = MidiInPort_oss::midiTimer.getTime();
-               message[device].tick = newSigTime - zeroSigTime;
-
-               if (packet[1] != 0xf7) {
-                  message[device].setP0(packet[1]);
-               } 
-               message[device].setP1(0);
-               message[device].setP2(0);
-               message[device].setP3(0);
-
-               if (packet[1] == 0xf7) {
-                  goto sysex_done;
-               }
-            } else if (argsLeft[device]) {   // not a command byte coming in
-               if (message[device].tick == 0) {
-                  // store the receipt time of the first message byte
-                  newSigTime = MidiInPort_oss::midiTimer.getTime();
-                  message[device].tick = newSigTime - zeroSigTime;
-               }
-                  
-               if (argsExpected[device] < 0) {
-                  // continue processing a sysex message
-                  sysexIn[device].append(packet[1]);
-               } else {
-                  // handle a message other than a sysex message
-                  if (argsLeft[device] == argsExpected[device]) {
-                     message[device].setP1(packet[1]);
-                  } else {
-                     message[device].setP2(packet[1]);
-                  }
-                  argsLeft[device]--;
-               }
-
-               // if MIDI message is complete, setup for running status, and 
-               // insert note into proper buffer.
-
-               if (argsExpected[device] >= 0 && !argsLeft[device]) {
-
-                  // store parameter data for running status
-                  switch (message[device].getP0() & 0xf0) {
-                     case 0xc0:  argsLeft[device] = 1;    break;
-                     case 0xd0:  argsLeft[device] = 1;    break;  // fix by dan
-                     default:    argsLeft[device] = 2;    break;
-                        // 0x80 expects two arguments
-                        // 0x90 expects two arguments
-                        // 0xa0 expects two arguments
-                        // 0xb0 expects two arguments
-                        // 0xe0 expects two arguments
-                  }
-
-                  // lastSigTime = newSigTime;
-
-                  sysex_done:      // come here when a sysex is completely done
-
-                  // insert the MIDI message into the appropriate buffer
-                  // do not insert into buffer if the MIDI input device
-                  // is paused (which can mean closed).  Or if the
-                  // pauseQ array is pointing to NULL (which probably means that
-                  // things are about to shut down).
-                  if (MidiInPort_oss::pauseQ != NULL &&
-                        MidiInPort_oss::pauseQ[device] == 0) {
-                     if (argsExpected[device] < 0) {
-                        // store the sysex in the MidiInPort_oss
-                        // buffer for sysexs and return the storage
-                        // location:
-                        int sysexlocation = 
-                           MidiInPort_oss::installSysexPrivate(device,
-                              sysexIn[device].getBase(),
-                              sysexIn[device].getSize());
-
-                        message[device].setP0(0xf0);
-                        message[device].setP1(sysexlocation);
-
-                        sysexIn[device].setSize(0); // empty the sysex storage
-                        argsExpected[device] = 0;   // no run status for sysex
-                        argsLeft[device] = 0;       // turn off sysex input flag
-                     }
-                     MidiInPort_oss::midiBuffer[device]->insert(
-                           message[device]);
-//                   if (MidiInPort_oss::callbackFunction != NULL) {
-//                      MidiInPort_oss::callbackFunction(device);
-//                   }
-                     if (MidiInPort_oss::trace[device]) {
-                        cout << '[' << hex << (int)message[device].getP0()
-                             << ':' << dec << (int)message[device].getP1()
-                             << ',' << (int)message[device].getP2() << ']'
-                             << flush;
-                     }
-                     message[device].tick = 0;
-                  } else {
-                     if (MidiInPort_oss::trace[device]) {
-                        cout << '[' << hex << (int)message[device].getP0()
-                             << 'P' << dec << (int)message[device].getP1()
-                             << ',' << (int)message[device].getP2() << ']'
-                             << flush;
-                     }
-                  }
-               }
-            }
+            newSigTime = MidiInPort_oss::midiTimer.getTime();
+            state[device].parser.parse(&packet[1], 1, 
+                  newSigTime - zeroSigTime);
             break;
 
          default:
@@ -1009,26 +942,81 @@ top_of_loop:
 
    // This code is not yet reached, but should be made to do so eventually
 
-   if (message != NULL) {
-      delete message;
-      message = NULL;
+   if (state != NULL) {
+      delete [] state;
+      state = NULL;
    }
 
-   if (argsExpected != NULL) {
-      delete argsExpected;
-      argsExpected = NULL;
+   return NULL;
+}
+
+
+
+
+//////////////////////////////
+//
+// MidiInPort_oss::storeParsedInput -- called by the input parser
+//     for each complete MIDI message.  The message is placed in the 
+//     input buffer of the device, unless the device is paused (which
+//     can mean closed), or the pauseQ array is NULL (which probably 
+//     means that things are about to shut down).
+//
+
+void MidiInPort_oss::storeParsedInput(const uchar* data, int size, 
+      int64_t timestamp, void* userdata) {
+   OssInputState& state = *(OssInputState*)userdata;
+   int device = state.device;
+   smf::MidiEvent& message = state.message;
+
+   // ignore unwanted messages (by default active sensing 0xfe 
+   // and MIDI clock 0xf8):
+   if (inputFilter == NULL || !inputFilter[device].accept(data, size)) {
+      return;
    }
 
-   if (argsLeft != NULL) {
-      delete argsLeft;
-      argsLeft = NULL;
+   message.setP0(data[0]);
+   if (data[0] == 0xf0) {
+      message.setP1(0);
+      message.setP2(0);
+   } else {
+      message.setP1(size > 1 ? data[1] : 0);
+      message.setP2(size > 2 ? data[2] : 0);
+   }
+   message.setP3(0);
+   message.tick = (int)timestamp;
+
+   if (pauseQ == NULL || pauseQ[device] != 0) {
+      if (trace != NULL && trace[device]) {
+         cout << '[' << hex << (int)message.getP0()
+              << 'P' << dec << (int)message.getP1()
+              << ',' << (int)message.getP2() << ']'
+              << flush;
+      }
+      return;
+   }
+
+   // the parser times are not CLOCK_MONOTONIC, so the recorder
+   // uses the current time
+   if (inputRecorder != NULL) {
+      inputRecorder[device].recordInput(device, data, size);
    }
 
-   if (sysexIn != NULL) { 
-      delete sysexIn;
-      sysexIn = NULL;
+   if (data[0] == 0xf0) {
+      // store the sysex in the MidiInPort_oss buffer for sysexs 
+      // and return the storage location:
+      message.setP1(installSysexPrivate(device, (uchar*)data, size));
    }
 
+   midiBuffer[device]->insert(message);
+//   if (callbackFunction != NULL) {
+//      callbackFunction(device);
+//   }
+   if (trace[device]) {
+      cout << '[' << hex << (int)message.getP0()
+           << ':' << dec << (int)message.getP1()
+           << ',' << (int)message.getP2() << ']'
+           << flush;
+   }
 }
 
 
@@ -2,6 +2,8 @@
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Thu Jun 11 17:28:22 PDT 2009
 // Last Modified: Thu Mar 24 03:11:39 PDT 2011 some fixes for 64-bit compiling
+// Last Modified: Sat Oct 17 14:58:33 PDT 2026 (per-port input filters)
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026 (recording in input thread)
 // Filename:      ...sig/code/control/MidiInPort/linux/MidiInPort_osx.cpp
 // Web Address:   http://sig.sapp.org/src/sig/MidiInPort_osx.cpp
 // Syntax:        C++
@@ -39,6 +41,8 @@ int*                MidiInPort_osx::trace                = NULL;
 ostream*            MidiInPort_osx::tracedisplay         = &cout;
 int*                MidiInPort_osx::sysexWriteBuffer     = NULL;
 Array<uchar>**      MidiInPort_osx::sysexBuffers         = NULL;
+MidiInputFilter*    MidiInPort_osx::inputFilter          = NULL;
+MidiRecorderSlot* MidiInPort_osx::inputRecorder          = NULL;
 Array<Array<char> > MidiInPort_osx::inputnames;
 MIDIClientRef       MidiInPort_osx::midiclient           = 0;
 Array<MIDIPortRef>  MidiInPort_osx::midiinputs;
@@ -168,6 +172,37 @@ void MidiInPort_osx::extract(smf::MidiEvent& event) {
 }
 
 
+//
+// Version with a timestamp: this driver does not record arrival times,
+//	so the timestamp is the millisecond tick time in nanoseconds.
+//
+
+void MidiInPort_osx::extract(smf::MidiEvent& event, int64_t& timestamp) {
+   extract(event);
+   timestamp = (int64_t)event.tick * 1000000;
+}
+
+
+//
+// Bulk version: extracts up to count waiting messages into the
+//	events array, and returns the number of messages extracted.
+//
+
+int MidiInPort_osx::extract(smf::MidiEvent* events, int count, 
+      int64_t* timestamps) {
+   int i = 0;
+   while (i < count && getCount() > 0) {
+      if (timestamps != NULL) {
+         extract(events[i], timestamps[i]);
+      } else {
+         extract(events[i]);
+      }
+      i++;
+   }
+   return i;
+}
+
+
 
 //////////////////////////////
 //
@@ -209,6 +244,22 @@ int MidiInPort_osx::getCount(void) {
 
 
 
+//////////////////////////////
+//
+// MidiInPort_osx::getFilter -- returns the filter which decides which
+//	incoming messages are stored in the input buffer of the port.
+//
+
+MidiInputFilter& MidiInPort_osx::getFilter(void) {
+   if (getPort() == -1) {
+      static MidiInputFilter nullFilter;
+      return nullFilter;
+   }
+   return inputFilter[getPort()];
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_osx::getName -- returns the name of the port.
@@ -266,6 +317,21 @@ int MidiInPort_osx::getPortStatus(void) {
 
 
 
+//////////////////////////////
+//
+// MidiInPort_osx::getRecorder -- returns the recorder of the port, or
+//	NULL if the input of the port is not being recorded.
+//
+
+MidiFileRecorder* MidiInPort_osx::getRecorder(void) {
+   if (getPort() == -1 || inputRecorder == NULL) {
+      return NULL;
+   }
+   return inputRecorder[getPort()].get();
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_osx::is_open --
@@ -506,6 +572,24 @@ void MidiInPort_osx::setPort(int aPort) {
 
 
 
+//////////////////////////////
+//
+// MidiInPort_osx::setRecorder -- record the messages which arrive on
+//	the port (after the input filter), or stop recording if aRecorder
+//	is NULL.  The recording is done by the input thread, and is shared
+//	by all objects using the same port.  When this function returns
+//	the input thread is no longer using the previous recorder.
+//
+
+void MidiInPort_osx::setRecorder(MidiFileRecorder* aRecorder) {
+   if (getPort() == -1 || inputRecorder == NULL) {
+      return;
+   }
+   inputRecorder[getPort()].set(aRecorder);
+}
+
+
+
 //////////////////////////////
 //
 // MidiInPort_osx::setTrace -- if false, then don't print MIDI messages
@@ -590,6 +674,16 @@ void MidiInPort_osx::deinitialize(void) {
       midiBuffer = NULL;
    }
 
+   if (inputFilter != NULL) {
+      delete [] inputFilter;
+      inputFilter = NULL;
+   }
+
+   if (inputRecorder != NULL) {
+      delete [] inputRecorder;
+      inputRecorder = NULL;
+   }
+
    if (portObjectCount != NULL) {
       delete [] portObjectCount;
       portObjectCount = NULL;
@@ -649,6 +743,18 @@ void MidiInPort_osx::initialize(void) {
    }
    midiBuffer = new CircularBuffer<smf::MidiEvent>*[numDevices];
 
+   // allocate space for the input filters
+   if (inputFilter != NULL) {
+      delete [] inputFilter;
+   }
+   inputFilter = new MidiInputFilter[numDevices];
+
+   // allocate space for the recorders of the ports
+   if (inputRecorder != NULL) {
+      delete [] inputRecorder;
+   }
+   inputRecorder = new MidiRecorderSlot[numDevices];
+
    // allocate space for Midi input sysex buffer write indices
    if (sysexWriteBuffer != NULL) {
       delete [] sysexWriteBuffer;
@@ -781,6 +887,15 @@ void improvReadProc(const MIDIPacketList *packetList, void* readProcRefCon,
    int i;
    int count = packetList->numPackets;
    for (i=0; i<count; i++) {
+      if (p->length == 0 || 
+            !MidiInPort_osx::inputFilter[port].accept(p->data, p->length)) {
+         p = MIDIPacketNext(p);
+         continue;
+      }
+      if (MidiInPort_osx::inputRecorder != NULL) {
+         MidiInPort_osx::inputRecorder[port].recordInput((int)port, p->data,
+               p->length);
+      }
       if (p->length > 0) { message.setP0(p->data[0]); }
       if (p->length > 1) { message.setP1(p->data[1]); }
       if (p->length > 2) { message.setP2(p->data[2]); }
@@ -129,6 +129,37 @@ void MidiInPort_unsupported::extract(smf::MidiEvent& event) {
 }
 
 
+//
+// Version with a timestamp: this driver does not record arrival times,
+//	so the timestamp is the millisecond tick time in nanoseconds.
+//
+
+void MidiInPort_unsupported::extract(smf::MidiEvent& event, int64_t& timestamp) {
+   extract(event);
+   timestamp = (int64_t)event.tick * 1000000;
+}
+
+
+//
+// Bulk version: extracts up to count waiting messages into the
+//	events array, and returns the number of messages extracted.
+//
+
+int MidiInPort_unsupported::extract(smf::MidiEvent* events, int count, 
+      int64_t* timestamps) {
+   int i = 0;
+   while (i < count && getCount() > 0) {
+      if (timestamps != NULL) {
+         extract(events[i], timestamps[i]);
+      } else {
+         extract(events[i]);
+      }
+      i++;
+   }
+   return i;
+}
+
+
 
 //////////////////////////////
 //
@@ -3,6 +3,10 @@
 // Creation Date: 18 December 1997
 // Last Modified: Sun Jan 25 15:31:49 GMT-0800 1998
 // Last Modified: Thu Apr 27 17:56:03 PDT 2000 (added scale function)
+// Last Modified: Sat Oct 17 11:32:40 PDT 2026 (bulk extract)
+// Last Modified: Sat Oct 17 12:48:09 PDT 2026 (nanosecond timestamps)
+// Last Modified: Sat Oct 17 13:20:37 PDT 2026 (waitForMessage/waitAny)
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026 (recordStart/recordStop)
 // Filename:      ...sig/code/control/MidiInput/MidiInput.cpp
 // Web Address:   http://sig.sapp.org/src/sig/MidiInput.cpp
 // Syntax:        C++
@@ -14,7 +18,12 @@
 //
 
 #include "MidiInput.h"
+#include "SigTimer.h"
+#include "Idler.h"
 #include <stdlib.h>
+#include <poll.h>
+#include <unistd.h>
+#include <vector>
 
 #ifndef OLDCPP
    #include <iostream>
@@ -32,11 +41,19 @@
 
 MidiInput::MidiInput(void) : MidiInPort() {
    orphanBuffer = NULL;
+   lastTimestamp = 0;
+   inputRecordQ = 0;
+   midiRecorder = NULL;
+   midiRecorderOwnerQ = 0;
 }
 
 
 MidiInput::MidiInput(int aPort, int autoOpen) : MidiInPort(aPort, autoOpen) {
    orphanBuffer = NULL;
+   lastTimestamp = 0;
+   inputRecordQ = 0;
+   midiRecorder = NULL;
+   midiRecorderOwnerQ = 0;
 }
 
 
@@ -47,6 +64,12 @@ MidiInput::MidiInput(int aPort, int autoOpen) : MidiInPort(aPort, autoOpen) {
 //
 
 MidiInput::~MidiInput() {
+   recordStop();
+   if (midiRecorderOwnerQ) {
+      delete midiRecorder;
+      midiRecorder = NULL;
+      midiRecorderOwnerQ = 0;
+   }
    if (orphanBuffer != NULL) {
       delete orphanBuffer;
       orphanBuffer = NULL;
@@ -87,15 +110,56 @@ int MidiInput::getCount(void) {
 
 //////////////////////////////
 //
-// MidiInput::extract --
+// MidiInput::extract -- returns the next MIDI message.  The arrival 
+//    time of the message is stored for getTimestamp(), and can also be
+//    returned in the timestamp argument.  Timestamps are CLOCK_MONOTONIC
+//    nanoseconds (the same clock as getCurrentTimestamp()).  Messages
+//    from an orphan buffer, or from drivers which do not record arrival
+//    times, use the MidiEvent::tick millisecond time instead.
 //
 
 void MidiInput::extract(smf::MidiEvent& event) {
+   extract(event, lastTimestamp);
+}
+
+
+void MidiInput::extract(smf::MidiEvent& event, int64_t& timestamp) {
    if (isOrphan()) {
       orphanBuffer->extract(event);
+      timestamp = (int64_t)event.tick * 1000000;
+   } else {
+      MidiInPort::extract(event, timestamp);
+   }
+   lastTimestamp = timestamp;
+}
+
+
+//
+// Bulk version: extracts up to count waiting messages into the
+//    events array, and returns the number of messages extracted.
+//    If timestamps is not NULL, the arrival time of each message
+//    is stored in it.
+//
+
+int MidiInput::extract(smf::MidiEvent* events, int count, 
+      int64_t* timestamps) {
+   int output;
+   if (isOrphan()) {
+      output = 0;
+      while (output < count && orphanBuffer->getCount() > 0) {
+         orphanBuffer->extract(events[output]);
+         if (timestamps != NULL) {
+            timestamps[output] = (int64_t)events[output].tick * 1000000;
+         }
+         output++;
+      }
    } else {
-      MidiInPort::extract(event);
+      output = MidiInPort::extract(events, count, timestamps);
+   }
+   if (output > 0 && timestamps != NULL) {
+      lastTimestamp = timestamps[output-1];
    }
+   return output;
 }
 
 
@@ -125,6 +189,31 @@ double MidiInput::fscale14(int value, double min, double max) {
 
 
 
+//////////////////////////////
+//
+// MidiInput::getCurrentTimestamp -- returns the current time on the
+//    clock used for input timestamps, in nanoseconds.  Subtract a
+//    message timestamp from this value to find how long ago it arrived.
+//
+
+int64_t MidiInput::getCurrentTimestamp(void) {
+   return SigTimer::getMonotonicTime();
+}
+
+
+
+//////////////////////////////
+//
+// MidiInput::getTimestamp -- returns the arrival time in nanoseconds
+//    of the last message returned by extract().
+//
+
+int64_t MidiInput::getTimestamp(void) const {
+   return lastTimestamp;
+}
+
+
+
 //////////////////////////////
 //
 // MidiInput::insert --
@@ -132,6 +221,9 @@ double MidiInput::fscale14(int value, double min, double max) {
 
 void MidiInput::insert(const smf::MidiEvent& aMessage) {
    if (isOrphan()) {
+      if (inputRecordQ && aMessage.size() > 0) {
+         midiRecorder->recordInput(0, aMessage.data(), (int)aMessage.size());
+      }
       orphanBuffer->insert(aMessage);
    } else {
       MidiInPort::insert(aMessage);
@@ -173,6 +265,82 @@ void MidiInput::makeOrphanBuffer(int aSize) {
 
 
 
+//////////////////////////////
+//
+// MidiInput::recordStart -- record the messages which arrive on the
+//    port into a file.  The messages are recorded by the input thread
+//    as they arrive (after the input filter), with their arrival times,
+//    whether or not they are extracted.  format is one of:
+//       MIDI_RECORD_ONE_TRACK  = type 0 MIDI file
+//       MIDI_RECORD_BY_PORT    = type 1 MIDI file, a track for each port
+//       MIDI_RECORD_BY_CHANNEL = type 1 MIDI file, a track for each channel
+//       MIDI_RECORD_LOG        = compact binary log of all messages
+//    The second form records into a recorder which can be shared with
+//    other MidiInput and MidiOutput objects, so that all of the ports of
+//    a session are recorded into one file on one time line; the caller
+//    stops the recorder after calling recordStop() on all of them.
+//    The recording of a port is shared by all objects using the port.
+//    The first form returns 0 if the recording could not be started.
+//    default value: format = MIDI_RECORD_ONE_TRACK
+//
+
+int MidiInput::recordStart(const char* filename, int format) {
+   recordStop();
+   if (!midiRecorderOwnerQ) {
+      midiRecorder = new MidiFileRecorder;
+      midiRecorderOwnerQ = 1;
+   }
+   if (!midiRecorder->start(filename, format)) {
+      return 0;
+   }
+   inputRecordQ = 1;
+   if (!isOrphan()) {
+      MidiInPort::setRecorder(midiRecorder);
+   }
+   return 1;
+}
+
+
+void MidiInput::recordStart(MidiFileRecorder& recorder) {
+   recordStop();
+   if (midiRecorderOwnerQ) {
+      delete midiRecorder;
+      midiRecorderOwnerQ = 0;
+   }
+   midiRecorder = &recorder;
+   inputRecordQ = 1;
+   if (!isOrphan()) {
+      MidiInPort::setRecorder(midiRecorder);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiInput::recordStop -- stop recording the input.  If the recording
+//    was started with a filename, the file is written at this point.
+//    Returns 0 if the file could not be written.
+//
+
+int MidiInput::recordStop(void) {
+   if (!inputRecordQ) {
+      return 1;
+   }
+   inputRecordQ = 0;
+   // another object on the same port may have started its own recording
+   if (!isOrphan() && MidiInPort::getRecorder() == midiRecorder) {
+      MidiInPort::setRecorder(NULL);
+   }
+   if (midiRecorderOwnerQ) {
+      return midiRecorder->stop();
+   }
+   midiRecorder = NULL;
+   return 1;
+}
+
+
+
 //////////////////////////////
 //
 // MidiInput::removeOrphanBuffer --
@@ -227,4 +395,115 @@ void MidiInput::setBufferSize(int aSize) {
 
 
 
+//////////////////////////////
+//
+// MidiInput::waitForMessage -- sleep until a message is waiting in
+//    the input buffer, or until timeout milliseconds have passed.
+//    A negative timeout waits forever.  Returns 1 if a message is
+//    waiting, or 0 if the timeout expired.
+//    default value: timeout = -1.0
+//
+
+int MidiInput::waitForMessage(double timeout) {
+   MidiInput* self = this;
+   return waitAny(&self, 1, timeout) >= 0 ? 1 : 0;
+}
+
+
+
+//////////////////////////////
+//
+// MidiInput::waitAny -- sleep until a message is waiting in any of
+//    the given inputs, or until timeout milliseconds have passed.
+//    A negative timeout waits forever.  Returns the index of the
+//    first input with a waiting message, or -1 if the timeout expired
+//    or if all of the inputs are NULL.  Inputs with no event 
+//    descriptor (orphan buffers and drivers which do not support 
+//    them) are checked every millisecond.
+//    Only one thread should wait on a particular input port.
+//    default value: timeout = -1.0
+//
+
+int MidiInput::waitAny(MidiInput** inputs, int count, double timeout) {
+   if (inputs == NULL || count <= 0) {
+      return -1;
+   }
+   int i;
+   for (i=0; i<count; i++) {
+      if (inputs[i] != NULL) {
+         break;
+      }
+   }
+   if (i >= count) {
+      // nothing to wait for, which would otherwise sleep forever
+      return -1;
+   }
+   vector<struct pollfd> pfds;
+   pfds.reserve(count);
+   int64_t deadline = 0;
+   if (timeout >= 0.0) {
+      deadline = SigTimer::getMonotonicTime() + (int64_t)(timeout * 1000000);
+   }
+   int fd;
+   int polled;
+   int waittime;
+   int64_t remaining;
+   uint64_t value;
+   while (1) {
+      pfds.clear();
+      polled = 1;
+      for (i=0; i<count; i++) {
+         if (inputs[i] == NULL) {
+            continue;
+         }
+         if (inputs[i]->getCount() > 0) {
+            return i;
+         }
+         fd = inputs[i]->isOrphan() ? -1 : inputs[i]->getInputEventFd();
+         if (fd < 0) {
+            polled = 0;
+            continue;
+         }
+         struct pollfd pfd;
+         pfd.fd = fd;
+         pfd.events = POLLIN;
+         pfd.revents = 0;
+         pfds.push_back(pfd);
+      }
+
+      // milliseconds to wait, rounded up so that the deadline is passed
+      waittime = -1;
+      if (timeout >= 0.0) {
+         remaining = deadline - SigTimer::getMonotonicTime();
+         if (remaining <= 0) {
+            return -1;
+         }
+         waittime = (int)((remaining + 999999) / 1000000);
+      }
+      if (!polled && (waittime < 0 || waittime > 1)) {
+         waittime = 1;
+      }
+
+      if (pfds.size() == 0) {
+         Idler::millisleep(waittime);
+         continue;
+      }
+      if (poll(pfds.data(), pfds.size(), waittime) <= 0) {
+         continue;
+      }
+      for (i=0; i<(int)pfds.size(); i++) {
+         if (pfds[i].revents & POLLIN) {
+            // clear the event counter; the buffers are checked above
+            if (::read(pfds[i].fd, &value, sizeof(value)) < 0) {
+               // another reader already cleared it
+            }
+         }
+      }
+   }
+
+   return -1;
+}
+
+
+
 // md5sum: b9d2adeeb556a979282c13e422e20678 MidiInput.cpp [20050403]
@@ -0,0 +1,286 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 14:58:33 PDT 2026
+// Last Modified: Sat Oct 17 14:58:33 PDT 2026
+// Last Modified: Sun Oct 18 11:02:47 PDT 2026 (atomic drop counts)
+// Filename:      ...sig/maint/code/control/MidiInputFilter/MidiInputFilter.cpp
+// Web Address:   http://sig.sapp.org/src/sig/MidiInputFilter.cpp
+// Syntax:        C++11
+//
+// Description:   Selects which incoming MIDI messages are stored in the
+//                input buffer of a port.
+//
+
+#include "MidiInputFilter.h"
+
+
+//////////////////////////////
+//
+// MidiInputFilter::MidiInputFilter --
+//
+
+MidiInputFilter::MidiInputFilter(void) {
+   reset();
+   clearDropCounts();
+}
+
+
+
+//////////////////////////////
+//
+// MidiInputFilter::~MidiInputFilter --
+//
+
+MidiInputFilter::~MidiInputFilter() {
+   // do nothing
+}
+
+
+
+//////////////////////////////
+//
+// MidiInputFilter::accept -- returns true if the message should be
+//     stored, or false (after counting it) if it should be dropped.
+//     data[0] is the status byte of the message.  This function is
+//     called by the MIDI input thread for every incoming message.
+//
+
+int MidiInputFilter::accept(const uchar* data, int size) {
+   int status = data[0];
+   if (status >= 0xf0) {
+      if ((systemMask.load(std::memory_order_relaxed) >> (status & 0x0f))
+            & 1) {
+         return 1;
+      }
+      return drop(7 + (status & 0x0f));
+   }
+
+   int index = (status >> 4) - 8;
+   if (!((channelMask[index].load(std::memory_order_relaxed) >> 
+         (status & 0x0f)) & 1)) {
+      return drop(index);
+   }
+   if (size < 2) {
+      return 1;
+   }
+   switch (status & 0xf0) {
+      case 0x80:
+      case 0x90:
+      case 0xa0:
+         if (data[1] < lowKey.load(std::memory_order_relaxed) ||
+               data[1] > highKey.load(std::memory_order_relaxed)) {
+            return drop(index);
+         }
+         break;
+      case 0xb0:
+         if (!((controllerMask[data[1] >> 6].load(std::memory_order_relaxed)
+               >> (data[1] & 0x3f)) & 1)) {
+            return drop(index);
+         }
+         break;
+   }
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// MidiInputFilter::acceptAll -- let all messages through, including
+//     MIDI clock and active sensing.
+//
+
+void MidiInputFilter::acceptAll(void) {
+   for (int i=0; i<7; i++) {
+      channelMask[i].store(0xffff);
+   }
+   systemMask.store(0xffff);
+   controllerMask[0].store(~(uint64_t)0);
+   controllerMask[1].store(~(uint64_t)0);
+   lowKey.store(0);
+   highKey.store(127);
+}
+
+
+
+//////////////////////////////
+//
+// MidiInputFilter::clearDropCounts -- set the counts of rejected 
+//     messages to zero.  May be called while MIDI input is running;
+//     a message rejected at the same time is counted either before
+//     or after the clear, never lost in between.
+//
+
+void MidiInputFilter::clearDropCounts(void) {
+   for (int i=0; i<23; i++) {
+      dropCount[i].store(0);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiInputFilter::getDropCount -- returns the number of messages which
+//     were rejected by the filter.  With a status byte, returns the
+//     number of rejected messages of that type: for channel messages 
+//     only the command nibble is used (0x93 gives the count for all
+//     note-on messages), while system messages are counted separately
+//     for each status byte.
+//
+
+int64_t MidiInputFilter::getDropCount(void) const {
+   int64_t sum = 0;
+   for (int i=0; i<23; i++) {
+      sum += dropCount[i].load(std::memory_order_relaxed);
+   }
+   return sum;
+}
+
+
+int64_t MidiInputFilter::getDropCount(int statusByte) const {
+   statusByte &= 0xff;
+   if (statusByte < 0x80) {
+      return 0;
+   } else if (statusByte < 0xf0) {
+      return dropCount[(statusByte >> 4) - 8].load(std::memory_order_relaxed);
+   } else {
+      return dropCount[7 + (statusByte & 0x0f)].load(
+            std::memory_order_relaxed);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiInputFilter::reset -- return to the default filter, which accepts
+//     everything except MIDI clock (0xf8) and active sensing (0xfe).
+//
+
+void MidiInputFilter::reset(void) {
+   acceptAll();
+   setSystem(0xf8, 0);
+   setSystem(0xfe, 0);
+}
+
+
+
+//////////////////////////////
+//
+// MidiInputFilter::setChannel -- accept (state = 1) or reject (state = 0)
+//     messages with the given command nibble (0x80 to 0xe0) on the given
+//     channel (0 to 15).  A channel of -1 sets all channels.
+//
+
+void MidiInputFilter::setChannel(int command, int channel, int state) {
+   int index = ((command & 0xf0) >> 4) - 8;
+   if (index < 0 || index > 6) {
+      return;
+   }
+   if (channel < 0) {
+      channelMask[index].store(state ? 0xffff : 0);
+   } else if (state) {
+      channelMask[index].fetch_or((uint16_t)(1 << (channel & 0x0f)));
+   } else {
+      channelMask[index].fetch_and((uint16_t)~(1 << (channel & 0x0f)));
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiInputFilter::setChannelMask -- set the accepted channels of a
+//     command (0x80 to 0xe0) all at once: bit 0 is channel 0, etc.
+//
+
+void MidiInputFilter::setChannelMask(int command, int aMask) {
+   int index = ((command & 0xf0) >> 4) - 8;
+   if (index < 0 || index > 6) {
+      return;
+   }
+   channelMask[index].store((uint16_t)aMask);
+}
+
+
+
+//////////////////////////////
+//
+// MidiInputFilter::setController -- accept (state = 1) or reject 
+//     (state = 0) controller messages for the given controller number.
+//     A controller of -1 sets all controllers.  Whether controller
+//     messages are accepted at all on a channel is set with setChannel().
+//
+
+void MidiInputFilter::setController(int controller, int state) {
+   if (controller < 0) {
+      controllerMask[0].store(state ? ~(uint64_t)0 : 0);
+      controllerMask[1].store(state ? ~(uint64_t)0 : 0);
+      return;
+   }
+   controller &= 0x7f;
+   uint64_t bit = (uint64_t)1 << (controller & 0x3f);
+   if (state) {
+      controllerMask[controller >> 6].fetch_or(bit);
+   } else {
+      controllerMask[controller >> 6].fetch_and(~bit);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiInputFilter::setNoteRange -- accept note-off, note-on and
+//     polyphonic aftertouch messages only for keys from lowKey to
+//     highKey inclusive.
+//
+
+void MidiInputFilter::setNoteRange(int aLowKey, int aHighKey) {
+   if (aLowKey > aHighKey) {
+      int temp = aLowKey;
+      aLowKey = aHighKey;
+      aHighKey = temp;
+   }
+   lowKey.store(aLowKey);
+   highKey.store(aHighKey);
+}
+
+
+
+//////////////////////////////
+//
+// MidiInputFilter::setSystem -- accept (state = 1) or reject (state = 0)
+//     system messages with the given status byte (0xf0 to 0xff).
+//
+
+void MidiInputFilter::setSystem(int statusByte, int state) {
+   if ((statusByte & 0xf0) != 0xf0) {
+      return;
+   }
+   uint16_t bit = (uint16_t)(1 << (statusByte & 0x0f));
+   if (state) {
+      systemMask.fetch_or(bit);
+   } else {
+      systemMask.fetch_and((uint16_t)~bit);
+   }
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+//////////////////////////////
+//
+// MidiInputFilter::drop -- count a rejected message.  The increment is
+//     atomic since clearDropCounts() may write the count from another
+//     thread.  Always returns 0.
+//
+
+int MidiInputFilter::drop(int index) {
+   dropCount[index].fetch_add(1, std::memory_order_relaxed);
+   return 0;
+}
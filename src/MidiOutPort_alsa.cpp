@@ -2,6 +2,10 @@
 // Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
 // Creation Date: Wed May 10 16:16:21 PDT 2000
 // Last Modified: Sun May 14 20:44:12 PDT 2000
+// Last Modified: Sat Oct 17 16:21:48 PDT 2026 (output write coalescing)
+// Last Modified: Sat Oct 17 16:58:07 PDT 2026 (running status output)
+// Last Modified: Sat Oct 17 18:12:40 PDT 2026 (asynchronous trace)
+// Last Modified: Sun Oct 18 11:48:30 PDT 2026 (atomic stage settings)
 // Filename:      ...sig/code/control/MidiOutPort/alsa/MidiOutPort_alsa.cpp
 // Web Address:   http://sig.sapp.org/src/sig/MidiOutPort_alsa.cpp
 // Syntax:        C++ 
@@ -15,6 +19,8 @@
 #if defined(LINUX) && defined(ALSA)
 
 #include "MidiOutPort_alsa.h"
+#include "MidiTrace.h"
+#include "SigTimer.h"
 #include <stdlib.h>
 
 #ifndef OLDCPP
@@ -24,6 +30,12 @@
    #include <iostream.h>
 #endif
 
+// default number of staged output bytes which causes a write
+#define DEFAULT_FLUSH_BYTES (256)
+
+// default age in nanoseconds of staged output which causes a write
+#define DEFAULT_FLUSH_AGE (1000000)
+
 // initialized static variables
 int       MidiOutPort_alsa::numDevices      = 0;
 int       MidiOutPort_alsa::objectCount     = 0;
@@ -31,6 +43,15 @@ int*      MidiOutPort_alsa::portObjectCount = NULL;
 int       MidiOutPort_alsa::channelOffset   = 0;
 int*      MidiOutPort_alsa::trace           = NULL;
 ostream*  MidiOutPort_alsa::tracedisplay    = &cout;
+std::atomic<int>* MidiOutPort_alsa::coalesceQ = NULL;
+vector<uchar>* MidiOutPort_alsa::stageBuffer = NULL;
+int64_t*  MidiOutPort_alsa::stageTime       = NULL;
+std::mutex* MidiOutPort_alsa::stageLock     = NULL;
+std::atomic<int>* MidiOutPort_alsa::runningStatusQ = NULL;
+int*      MidiOutPort_alsa::lastStatus      = NULL;
+int64_t*  MidiOutPort_alsa::statusSavings   = NULL;
+std::atomic<int> MidiOutPort_alsa::flushBytes(DEFAULT_FLUSH_BYTES);
+std::atomic<int64_t> MidiOutPort_alsa::flushAge(DEFAULT_FLUSH_AGE);
 
 
 //////////////////////////////
@@ -90,6 +111,11 @@ MidiOutPort_alsa::~MidiOutPort_alsa() {
 //
 
 void MidiOutPort_alsa::close(void) {
+   flush();
+   if (getPort() != -1 && lastStatus != NULL) {
+      std::lock_guard<std::mutex> lock(stageLock[getPort()]);
+      lastStatus[getPort()] = 0;
+   }
    Sequencer_alsa::closeOutput(getPort());
 }
 
@@ -101,14 +127,59 @@ void MidiOutPort_alsa::close(void) {
 //
 
 void MidiOutPort_alsa::closeAll(void) {
+   flushAll();
    int i;
    for (i=0; i<getNumPorts(); i++) {
+      if (lastStatus != NULL) {
+         std::lock_guard<std::mutex> lock(stageLock[i]);
+         lastStatus[i] = 0;
+      }
       Sequencer_alsa::closeOutput(i);
    }
 }
 
 
 
+//////////////////////////////
+//
+// MidiOutPort_alsa::flush -- write any output which is staged for the
+//     port (see setCoalescing()).  Returns 1 if successful or if there
+//     was nothing to write, otherwise returns 0.
+//
+
+int MidiOutPort_alsa::flush(void) {
+   if (getPort() == -1 || coalesceQ == NULL) return 1;
+
+   std::lock_guard<std::mutex> lock(stageLock[getPort()]);
+   return writeStage(getPort());
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutPort_alsa::flushAll -- write the staged output of all ports.
+//     This is called at the end of each pass through the main loop
+//     of the improv environments.  The sender thread of a port may be
+//     staging output at the same time, so the stage is only looked at
+//     while holding its lock.  Returns 0 if any write failed.
+//
+
+int MidiOutPort_alsa::flushAll(void) {
+   if (coalesceQ == NULL) return 1;
+
+   int status = 1;
+   for (int i=0; i<getNumPorts(); i++) {
+      std::lock_guard<std::mutex> lock(stageLock[i]);
+      if (!writeStage(i)) {
+         status = 0;
+      }
+   }
+   return status;
+}
+
+
+
 //////////////////////////////
 //
 // MidiOutPort_alsa::getChannelOffset -- returns zero if MIDI channel 
@@ -121,6 +192,20 @@ int MidiOutPort_alsa::getChannelOffset(void) const {
 
 
 
+//////////////////////////////
+//
+// MidiOutPort_alsa::getCoalescing -- returns true if output to the
+//     port is being staged and written in blocks.
+//
+
+int MidiOutPort_alsa::getCoalescing(void) {
+   if (getPort() == -1) return 0;
+
+   return coalesceQ[getPort()].load(std::memory_order_relaxed);
+}
+
+
+
 //////////////////////////////
 //
 // MidiOutPort_alsa::getName -- returns the name of the port.
@@ -176,6 +261,37 @@ int MidiOutPort_alsa::getPortStatus(void) {
 
 
 
+//////////////////////////////
+//
+// MidiOutPort_alsa::getRunningStatus -- returns true if repeated
+//     channel status bytes are being left out of the output to 
+//     the port.
+//
+
+int MidiOutPort_alsa::getRunningStatus(void) {
+   if (getPort() == -1) return 0;
+
+   return runningStatusQ[getPort()].load(std::memory_order_relaxed);
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutPort_alsa::getRunningStatusSavings -- returns the number of
+//     status bytes which were not sent to the port because of
+//     running status.
+//
+
+int64_t MidiOutPort_alsa::getRunningStatusSavings(void) {
+   if (getPort() == -1) return 0;
+
+   std::lock_guard<std::mutex> lock(stageLock[getPort()]);
+   return statusSavings[getPort()];
+}
+
+
+
 //////////////////////////////
 //
 // MidiOutPort_alsa::getTrace -- returns true if trace is on or
@@ -197,88 +313,31 @@ int MidiOutPort_alsa::getTrace(void) {
 //
 
 int MidiOutPort_alsa::rawsend(int command, int p1, int p2) {
-   if (getPort() == -1) return 0;
-
-   int status;
    uchar mdata[3] = {(uchar)command, (uchar)p1, (uchar)p2};
-   status = write(getPort(), mdata, 3);   
-
-   if (getTrace()) {
-      if (status == 1) {
-         cout << "(" << hex << (int)mdata[0] << dec << ":"
-              << (int)mdata[1] << "," << (int)mdata[2] << ")";
-         cout.flush();
-      } else {
-         cout << "(" << hex << (int)mdata[0] << dec << "X"
-              << (int)mdata[1] << "," << (int)mdata[2] << ")";
-         cout.flush();
-      }
-   }      
-
-   return status;
+   return rawsend(mdata, 3);
 }
 
 
 int MidiOutPort_alsa::rawsend(int command, int p1) {
-   if (getPort() == -1) return 0;   
-
-   int status;
    uchar mdata[2] = {(uchar)command, (uchar)p1};
-
-   status = write(getPort(), mdata, 2);   
-
-   if (getTrace()) {
-      if (status == 1) {
-         cout << "(" << hex << (int)mdata[0] << dec << ":"
-              << (int)mdata[1] << ")";
-         cout.flush();
-      } else {
-         cout << "(" << hex << (int)mdata[0] << dec << "X"
-              << (int)mdata[1] << ")";
-         cout.flush();
-      }
-   }
- 
-   return status;
+   return rawsend(mdata, 2);
 }
 
 
 int MidiOutPort_alsa::rawsend(int command) {
-   if (getPort() == -1) return 0;   
-
-   int status;
    uchar mdata[1] = {(uchar)command};
-
-   status = write(getPort(), mdata, 1);
-
-   if (getTrace()) {
-      if (status == 1) {
-         cout << "(" << hex << (int)mdata[0] << ")";
-         cout.flush();
-      } else {
-         cout << "(" << hex << (int)mdata[0] << ")";
-         cout.flush();
-      }
-   }
-
-   return status;
+   return rawsend(mdata, 1);
 }
 
 
 int MidiOutPort_alsa::rawsend(uchar* array, int size) {
    if (getPort() == -1) return 0;   
 
-   int status;
-   status = write(getPort(), array, size);
-   
+   int status = sendBytes(array, size);
+
    if (getTrace()) {
-      if (status == 1) {
-         cout << "(array)";
-         cout.flush();
-      } else {
-         cout << "(XarrayX)";
-         cout.flush();
-      }
+      MidiTrace::record(MIDI_TRACE_OUTPUT, getPort(), array, size,
+            status == 1 ? 0 : MIDI_TRACE_FAILED);
    }
 
    return status;
@@ -320,6 +379,56 @@ void MidiOutPort_alsa::setChannelOffset(int anOffset) {
 
 
 
+//////////////////////////////
+//
+// MidiOutPort_alsa::setCoalescing -- if true, output messages for the
+//     port are collected and written to the driver together, instead 
+//     of with one write() for each message.  The staged bytes are 
+//     written when flush() is called (the improv environments call
+//     flushAll() once per pass through the main loop), or when more
+//     than the flush limit in bytes is staged, or when a message is
+//     sent after the oldest staged byte has been waiting longer than
+//     the flush time limit (see setFlushLimits()).  Nothing writes the
+//     stage on a timer, so a program which sends output outside of the
+//     improv main loop should call flush() when it stops sending.  The setting is 
+//     shared by all objects which use the port.  Turning coalescing 
+//     off writes any staged output.
+//
+
+void MidiOutPort_alsa::setCoalescing(int aState) {
+   if (getPort() == -1) return;
+
+   std::lock_guard<std::mutex> lock(stageLock[getPort()]);
+   if (!aState) {
+      writeStage(getPort());
+   }
+   coalesceQ[getPort()].store(aState ? 1 : 0);
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutPort_alsa::setFlushLimits -- set the maximum number of
+//     bytes and the maximum time in milliseconds that output will be
+//     staged before it is written when coalescing is on.  The limits
+//     apply to all ports.  The time limit is checked when a message is
+//     sent, not by a timer (see sendBytes()).
+//
+
+void MidiOutPort_alsa::setFlushLimits(int maxBytes, double maxMilliseconds) {
+   if (maxBytes < 1) {
+      maxBytes = 1;
+   }
+   if (maxMilliseconds < 0.0) {
+      maxMilliseconds = 0.0;
+   }
+   flushBytes.store(maxBytes);
+   flushAge.store((int64_t)(maxMilliseconds * 1000000.0));
+}
+
+
+
 //////////////////////////////
 //
 // MidiOutPort_alsa::setPort --
@@ -345,6 +454,27 @@ void MidiOutPort_alsa::setPort(int aPort) {
 
 
 
+//////////////////////////////
+//
+// MidiOutPort_alsa::setRunningStatus -- if true, a channel message 
+//     which has the same command byte as the previous channel message
+//     sent to the port is sent without its command byte.  System 
+//     common messages and sysex cancel the running status, and 
+//     realtime messages leave it alone.  The setting is shared by all
+//     objects which use the port, and the receiving device must 
+//     understand running status (all DIN MIDI devices should).
+//
+
+void MidiOutPort_alsa::setRunningStatus(int aState) {
+   if (getPort() == -1) return;
+
+   std::lock_guard<std::mutex> lock(stageLock[getPort()]);
+   runningStatusQ[getPort()].store(aState ? 1 : 0);
+   lastStatus[getPort()] = 0;
+}
+
+
+
 //////////////////////////////
 //
 // MidiOutPort_alsa::setTrace -- if false, then won't print
@@ -358,6 +488,7 @@ int MidiOutPort_alsa::setTrace(int aState) {
    if (aState == 0) {
       trace[getPort()] = 0;
    } else {
+      MidiTrace::start();
       trace[getPort()] = 1;
    }
    return oldtrace;
@@ -395,6 +526,9 @@ int MidiOutPort_alsa::sysex(uchar* array, int size) {
 void MidiOutPort_alsa::toggleTrace(void) {
    if (getPort() == -1) return;
 
+   if (!trace[getPort()]) {
+      MidiTrace::start();
+   }
    trace[getPort()] = !trace[getPort()];
 }
 
@@ -420,6 +554,20 @@ void MidiOutPort_alsa::deinitialize(void) {
    portObjectCount = NULL;
    if (trace != NULL) delete [] trace;
    trace = NULL;
+   if (coalesceQ != NULL) delete [] coalesceQ;
+   coalesceQ = NULL;
+   if (stageBuffer != NULL) delete [] stageBuffer;
+   stageBuffer = NULL;
+   if (stageTime != NULL) delete [] stageTime;
+   stageTime = NULL;
+   if (stageLock != NULL) delete [] stageLock;
+   stageLock = NULL;
+   if (runningStatusQ != NULL) delete [] runningStatusQ;
+   runningStatusQ = NULL;
+   if (lastStatus != NULL) delete [] lastStatus;
+   lastStatus = NULL;
+   if (statusSavings != NULL) delete [] statusSavings;
+   statusSavings = NULL;
 }
 
 
@@ -446,17 +594,123 @@ void MidiOutPort_alsa::initialize(void) {
       // allocate space for trace variable for each port:
       if (trace != NULL) delete [] trace;
       trace = new int[numDevices];
+
+      // allocate space for output staging for each port:
+      if (coalesceQ != NULL) delete [] coalesceQ;
+      coalesceQ = new std::atomic<int>[numDevices];
+      if (stageBuffer != NULL) delete [] stageBuffer;
+      stageBuffer = new vector<uchar>[numDevices];
+      if (stageTime != NULL) delete [] stageTime;
+      stageTime = new int64_t[numDevices];
+      if (stageLock != NULL) delete [] stageLock;
+      stageLock = new std::mutex[numDevices];
+
+      // allocate space for running status for each port:
+      if (runningStatusQ != NULL) delete [] runningStatusQ;
+      runningStatusQ = new std::atomic<int>[numDevices];
+      if (lastStatus != NULL) delete [] lastStatus;
+      lastStatus = new int[numDevices];
+      if (statusSavings != NULL) delete [] statusSavings;
+      statusSavings = new int64_t[numDevices];
    
       // initialize the static arrays
       for (int i=0; i<getNumPorts(); i++) {
          portObjectCount[i] = 0;
          trace[i] = 0;
+         coalesceQ[i].store(0);
+         stageBuffer[i].reserve(DEFAULT_FLUSH_BYTES);
+         stageTime[i] = 0;
+         runningStatusQ[i].store(0);
+         lastStatus[i] = 0;
+         statusSavings[i] = 0;
       }
    }
 }
 
 
 
+//////////////////////////////
+//
+// MidiOutPort_alsa::sendBytes -- write the bytes to the port, or add
+//     them to the staged output of the port if coalescing is on.
+//     When running status is on, the bytes always pass through the
+//     stage so that repeated status bytes can be removed.  The
+//     settings of the port are read again under the stage lock, since
+//     another thread may change them.  The age limit of the stage is
+//     only checked here and there is no timer which writes old output:
+//     staged bytes wait until the next message to the port or until
+//     flush() or flushAll() is called.  (The improv environments, the
+//     EventBuffer and the send queue thread flush after each pass.)
+//     Returns 1 if successful.
+//
+
+int MidiOutPort_alsa::sendBytes(uchar* data, int count) {
+   int aPort = getPort();
+   if (!coalesceQ[aPort].load(std::memory_order_relaxed) &&
+         !runningStatusQ[aPort].load(std::memory_order_relaxed)) {
+      return write(aPort, data, count);
+   }
+
+   std::lock_guard<std::mutex> lock(stageLock[aPort]);
+   vector<uchar>& stage = stageBuffer[aPort];
+   int coalescing = coalesceQ[aPort].load(std::memory_order_relaxed);
+   int maxBytes = flushBytes.load(std::memory_order_relaxed);
+   int status = 1;
+   if (!stage.empty() && (int)stage.size() + count > maxBytes) {
+      // write what is already staged so that the limit is not exceeded
+      status = writeStage(aPort);
+   }
+   int64_t now = SigTimer::getMonotonicTime();
+   if (stage.empty()) {
+      stageTime[aPort] = now;
+   }
+   if (runningStatusQ[aPort].load(std::memory_order_relaxed)) {
+      stageRunningStatus(aPort, data, count);
+   } else {
+      stage.insert(stage.end(), data, data + count);
+   }
+   if (!coalescing || (int)stage.size() >= maxBytes || 
+         now - stageTime[aPort] >= flushAge.load(std::memory_order_relaxed)) {
+      if (!writeStage(aPort)) {
+         status = 0;
+      }
+   }
+   return status;
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutPort_alsa::stageRunningStatus -- add the bytes to the staged
+//     output of the port, leaving out any channel status byte which 
+//     matches the running status of the port.  Channel status bytes 
+//     set the running status, system common and sysex bytes clear it,
+//     and realtime bytes (which may occur anywhere) do not change it.
+//     The stage lock of the port must be held by the caller.
+//
+
+void MidiOutPort_alsa::stageRunningStatus(int aPort, uchar* data, 
+      int count) {
+   vector<uchar>& stage = stageBuffer[aPort];
+   for (int i=0; i<count; i++) {
+      if (data[i] >= 0xf8) {
+         // realtime message
+      } else if (data[i] >= 0xf0) {
+         lastStatus[aPort] = 0;
+      } else if (data[i] >= 0x80) {
+         if (data[i] == lastStatus[aPort]) {
+            statusSavings[aPort]++;
+            continue;
+         }
+         lastStatus[aPort] = data[i];
+      }
+      stage.push_back(data[i]);
+   }
+}
+
+
+
 //////////////////////////////
 //
 // MidiOutPort_alsa::setPortStatus --
@@ -467,6 +721,29 @@ void MidiOutPort_alsa::setPortStatus(int aStatus) {
 }
 
 
+
+//////////////////////////////
+//
+// MidiOutPort_alsa::writeStage -- write the staged output of a port
+//     to the driver with a single write.  The stage lock of the port
+//     must be held by the caller.  Returns 1 if successful.
+//
+
+int MidiOutPort_alsa::writeStage(int aPort) {
+   vector<uchar>& stage = stageBuffer[aPort];
+   if (stage.empty()) {
+      return 1;
+   }
+   int status = write(aPort, stage.data(), (int)stage.size());
+   stage.clear();
+   if (status != 1 && lastStatus != NULL) {
+      // the device may not have received the last status byte
+      lastStatus[aPort] = 0;
+   }
+   return status;
+}
+
+
 #endif  /* LINUX and ALSA */
 
 
@@ -7,6 +7,13 @@
 // Last Modified: Sun Dec  9 15:01:33 PST 2001 switched con/des code
 // Last Modified: Wed Jun  4 20:06:46 PDT 2003 initial MIDI file recording
 // Last Modified: Sun Feb 17 14:11:15 PST 2013 added MidiEvent send
+// Last Modified: Sat Oct 17 16:21:48 PDT 2026 flush staged output on silence
+// Last Modified: Sat Oct 17 17:34:26 PDT 2026 added sendAt
+// Last Modified: Sat Oct 17 18:49:55 PDT 2026 redundant send suppression
+// Last Modified: Sat Oct 17 19:27:03 PDT 2026 active note tracking
+// Last Modified: Sat Oct 17 20:41:18 PDT 2026 output pacing
+// Last Modified: Sat Oct 17 21:16:52 PDT 2026 background MIDI file recording
+// Last Modified: Sat Oct 17 22:03:18 PDT 2026 binary log recording
 // Filename:      ...sig/code/control/MidiOutput/MidiOutput.cpp
 // Web Address:   http://sig.sapp.org/src/sig/MidiOutput.cpp
 // Syntax:        C++
@@ -18,6 +25,9 @@
 
 #include "MidiOutput.h"
 
+#include <mutex>
+#include <string.h>
+
 #ifndef OLDCPP
    #include <iostream>
    #include <iomanip>
@@ -32,6 +42,16 @@ SigTimer    MidiOutput::timer;
 Array<int>* MidiOutput::rpn_lsb_status = NULL;
 Array<int>* MidiOutput::rpn_msb_status = NULL;
 int         MidiOutput::objectCount    = 0;
+MidiSendQueue** MidiOutput::sendQueue  = NULL;
+MidiStateCache* MidiOutput::outputState = NULL;
+MidiActiveNotes* MidiOutput::activeNotes = NULL;
+
+// added to the NRPN numbers stored in rpn_msb_status and rpn_lsb_status
+// so that they are not mistaken for the same RPN numbers
+#define NRPN_SELECTED (0x100)
+
+// for creating the send queues when they are first needed
+static std::mutex sendQueueLock;
 
 
 //////////////////////////////
@@ -42,9 +62,13 @@ int         MidiOutput::objectCount    = 0;
 
 MidiOutput::MidiOutput(void) : MidiOutPort() {
    outputRecordQ = 0;
+   midiRecorder = NULL;
+   midiRecorderOwnerQ = 0;
 
    if (objectCount == 0) {
       initializeRPN();
+      initializeStateCache();
+      initializeActiveNotes();
    }
    objectCount++;
 }
@@ -52,9 +76,13 @@ MidiOutput::MidiOutput(void) : MidiOutPort() {
 
 MidiOutput::MidiOutput(int aPort, int autoOpen) : MidiOutPort(aPort, autoOpen) {
    outputRecordQ = 0;
+   midiRecorder = NULL;
+   midiRecorderOwnerQ = 0;
 
    if (objectCount == 0) {
       initializeRPN();
+      initializeStateCache();
+      initializeActiveNotes();
    }
    objectCount++;
 }
@@ -70,6 +98,9 @@ MidiOutput::~MidiOutput() {
    objectCount--;
    if (objectCount == 0) {
       deinitializeRPN();
+      deinitializeSendQueues();
+      deinitializeStateCache();
+      deinitializeActiveNotes();
    } else if (objectCount < 0) {
       cout << "Error in MidiOutput decontruction" << endl; 
    }
@@ -77,6 +108,26 @@ MidiOutput::~MidiOutput() {
    if (outputRecordQ) {
       recordStop();
    }
+   if (midiRecorderOwnerQ) {
+      delete midiRecorder;
+   }
+   midiRecorder = NULL;
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::clearScheduled -- throw away the messages given to
+//     sendAt() for the output port which have not been sent yet.
+//     This affects all MidiOutput objects which use the port.
+//
+
+void MidiOutput::clearScheduled(void) {
+   if (sendQueue == NULL || getPort() == -1 || sendQueue[getPort()] == NULL) {
+      return;
+   }
+   sendQueue[getPort()]->clear();
 }
 
 
@@ -96,6 +147,108 @@ int MidiOutput::cont(int channel, int controller, int data) {
 
 
 
+//////////////////////////////
+//
+// MidiOutput::getActiveCount -- returns the number of keys which are
+//     sounding on the output port, or on one channel of it.  Only notes
+//     sent through MidiOutput objects (including sendAt()) are counted.
+//     default value: channel = -1 (all channels)
+//
+
+int MidiOutput::getActiveCount(int channel) {
+   if (activeNotes == NULL || getPort() == -1) {
+      return 0;
+   }
+   if (channel == -1) {
+      return activeNotes[getPort()].getActiveCount();
+   } else {
+      return activeNotes[getPort()].getActiveCount(channel);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::getPacingLatency -- returns the number of nanoseconds a
+//     message sent now would wait for the cable, if output to the port
+//     is paced (see setPacing()).
+//
+
+int64_t MidiOutput::getPacingLatency(void) {
+   if (!isPaced()) {
+      return 0;
+   }
+   return sendQueue[getPort()]->getPredictedLatency();
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::getScheduledCount -- returns the number of messages given
+//     to sendAt() for the output port which have not been sent yet.
+//
+
+int MidiOutput::getScheduledCount(void) {
+   if (sendQueue == NULL || getPort() == -1 || sendQueue[getPort()] == NULL) {
+      return 0;
+   }
+   return sendQueue[getPort()]->getCount();
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::getSendStatistics -- returns the number of messages sent 
+//     by sendAt() on the output port, and a histogram of how late they 
+//     were sent (see MidiSendQueue.h).
+//
+
+void MidiOutput::getSendStatistics(MidiSendStatistics& stats) {
+   if (sendQueue == NULL || getPort() == -1 || sendQueue[getPort()] == NULL) {
+      memset(&stats, 0, sizeof(stats));
+      return;
+   }
+   sendQueue[getPort()]->getStatistics(stats);
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::getStateCache -- returns the state cache of the output
+//     port, which can be used to set the deadbands, to read the number
+//     of messages which were left out, or to look up the last values
+//     sent on the port.
+//
+
+MidiStateCache& MidiOutput::getStateCache(void) {
+   static MidiStateCache noPort;
+   if (outputState == NULL || getPort() == -1) {
+      return noPort;
+   }
+   return outputState[getPort()];
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::isSounding -- returns true if a note-on for the key has
+//     been sent on the output port without a matching note-off.
+//
+
+int MidiOutput::isSounding(int channel, int keynum) {
+   if (activeNotes == NULL || getPort() == -1) {
+      return 0;
+   }
+   return activeNotes[getPort()].isSounding(channel, keynum);
+}
+
+
+
 //////////////////////////////
 //
 // MidiOutput::off -- sends a Note Off MIDI message (0x80).
@@ -114,6 +267,29 @@ int MidiOutput::off(int channel, int keynum, int releaseVelocity) {
 
 
 
+//////////////////////////////
+//
+// MidiOutput::panic -- turn off the sounding notes like silence(), then
+//     send All Notes Off (controller 123) on every channel (or on one
+//     channel) for notes which were sent some other way, such as by
+//     rawsend() or by another program.
+//     default value: aChannel = -1
+//
+
+void MidiOutput::panic(int aChannel) {
+   silence(aChannel);
+   if (aChannel == -1) {
+      for (int channel=0; channel<16; channel++) {
+         cont(channel, 123, 0);
+      }
+   } else {
+      cont(aChannel, 123, 0);
+   }
+   flush();
+}
+
+
+
 //////////////////////////////
 //
 // MidiOutput::pc -- send a patch change MIDI message. changes the timbre
@@ -196,7 +372,19 @@ int MidiOutput::pw(int channel, double tuningData) {
 
 //////////////////////////////
 //
-// MidiOutput::recordStart
+// MidiOutput::recordStart -- record the output into a file.  The
+//     RECORD_MIDI_FILE formats are encoded and written by a background
+//     thread (see MidiFileRecorder), so recording does not slow down
+//     send().  RECORD_MIDI_FILE writes a type 0 file, and
+//     RECORD_MIDI_FILE_PORTS and RECORD_MIDI_FILE_CHANNELS write a type 1
+//     file with a track for each port or channel.  The MIDI file is
+//     written when recordStop() is called.  RECORD_MIDI_LOG writes a
+//     binary log of all messages while recording instead.
+//
+//     The second form records into a MidiFileRecorder which has been
+//     started by the caller, so that the output of several MidiOutput
+//     objects (or MIDI input) can go into one file.  The recorder is 
+//     not stopped by recordStop().
 //
 
 void MidiOutput::recordStart(char *filename, int format) {
@@ -204,6 +392,25 @@ void MidiOutput::recordStart(char *filename, int format) {
       recordStop();
    }
 
+   if (format != RECORD_ASCII && format != RECORD_BINARY) {
+      if (!midiRecorderOwnerQ) {
+         midiRecorder = new MidiFileRecorder;
+         midiRecorderOwnerQ = 1;
+      }
+      int trackMode = MIDI_RECORD_ONE_TRACK;
+      if (format == RECORD_MIDI_FILE_PORTS) {
+         trackMode = MIDI_RECORD_BY_PORT;
+      } else if (format == RECORD_MIDI_FILE_CHANNELS) {
+         trackMode = MIDI_RECORD_BY_CHANNEL;
+      } else if (format == RECORD_MIDI_LOG) {
+         trackMode = MIDI_RECORD_LOG;
+      }
+      outputRecordQ = midiRecorder->start(filename, trackMode);
+      outputRecordType = RECORD_MIDI_FILE;
+      lastFlushTime = timer.getTime();
+      return;
+   }
+
    outputRecordFile.open(filename, ios::out);
    if (!outputRecordFile) {   // open file failed
       cerr << "Error: cannot open file " << filename << endl;
@@ -224,12 +431,6 @@ void MidiOutput::recordStart(char *filename, int format) {
             outputRecordFile << (uchar)0xf8 << (uchar)0xf8
                        << (uchar)0xf8 << (uchar)0xf8;
             break;
-         case RECORD_MIDI_FILE: // standard MIDI file, type 0
-         default:
-            outputRecordType = RECORD_MIDI_FILE;
-            // header stuff written here
-            rtmidifile.setup(filename);
-            break;
       }
    }
 
@@ -237,10 +438,26 @@ void MidiOutput::recordStart(char *filename, int format) {
 }
 
 
+void MidiOutput::recordStart(MidiFileRecorder& recorder) {
+   if (outputRecordQ) {
+      recordStop();
+   }
+   if (midiRecorderOwnerQ) {
+      delete midiRecorder;
+      midiRecorderOwnerQ = 0;
+   }
+   midiRecorder = &recorder;
+   outputRecordType = RECORD_MIDI_FILE;
+   outputRecordQ = 1;
+   lastFlushTime = timer.getTime();
+}
+
+
 
 //////////////////////////////
 //
-// MidiOutput::recordStop
+// MidiOutput::recordStop -- stop recording the output.  A MIDI file
+//     is written at this point.
 //
 
 void MidiOutput::recordStop(void) {
@@ -248,7 +465,11 @@ void MidiOutput::recordStop(void) {
       outputRecordQ = 0;
       switch (outputRecordType) {
          case RECORD_MIDI_FILE:
-            rtmidifile.close();
+            if (midiRecorderOwnerQ) {
+               midiRecorder->stop();
+            } else {
+               midiRecorder = NULL;
+            }
             break;
          case RECORD_ASCII:
          case RECORD_BINARY:
@@ -282,6 +503,9 @@ void MidiOutput::reset(void) {
 //
 
 int MidiOutput::send(int command, int p1, int p2) {
+   if (isRedundant(command, p1, p2, 3)) {
+      return 1;
+   }
    if (outputRecordQ) {
       switch (outputRecordType) {
          case 0:   // ascii
@@ -296,11 +520,24 @@ int MidiOutput::send(int command, int p1, int p2) {
       }
       lastFlushTime = timer.getTime();  // only keep track if recording
    }
-   return rawsend(command, p1, p2);
+   if (isPaced()) {
+      uchar data[3] = {(uchar)command, (uchar)p1, (uchar)p2};
+      return sendAt(SigTimer::getMonotonicTime(), data, 3);
+   }
+   int status = rawsend(command, p1, p2);
+   if (status != 1) {
+      sendFailed(command);
+   } else {
+      sendSucceeded(command, p1, p2, 3);
+   }
+   return status;
 }
 
 
 int MidiOutput::send(int command, int p1) {
+   if (isRedundant(command, p1, 0, 2)) {
+      return 1;
+   }
    if (outputRecordQ) {
       switch (outputRecordType) {
          case 0:   // ascii
@@ -315,11 +552,24 @@ int MidiOutput::send(int command, int p1) {
       }
       lastFlushTime = timer.getTime();  // only keep track if recording
    }
-   return rawsend(command, p1);
+   if (isPaced()) {
+      uchar data[2] = {(uchar)command, (uchar)p1};
+      return sendAt(SigTimer::getMonotonicTime(), data, 2);
+   }
+   int status = rawsend(command, p1);
+   if (status != 1) {
+      sendFailed(command);
+   } else {
+      sendSucceeded(command, p1, 0, 2);
+   }
+   return status;
 }
 
 
 int MidiOutput::send(int command) {
+   if (isRedundant(command, 0, 0, 1)) {
+      return 1;
+   }
    if (outputRecordQ) {
       switch (outputRecordType) {
          case 0:   // ascii
@@ -334,7 +584,17 @@ int MidiOutput::send(int command) {
       }
       lastFlushTime = timer.getTime();  // only keep track if recording
    }
-   return rawsend(command);
+   if (isPaced()) {
+      uchar data[1] = {(uchar)command};
+      return sendAt(SigTimer::getMonotonicTime(), data, 1);
+   }
+   int status = rawsend(command);
+   if (status != 1) {
+      sendFailed(command);
+   } else {
+      sendSucceeded(command, 0, 0, 1);
+   }
+   return status;
 }
 
 
@@ -362,23 +622,132 @@ int MidiOutput::send(smf::MidiEvent& message) {
 
 //////////////////////////////
 //
-// MidiOutput::silence -- send a note off to all notes on all channels.
+// MidiOutput::sendAt -- send a MIDI message at a later time.  The time
+//     is absolute CLOCK_MONOTONIC nanoseconds, as returned by 
+//     SigTimer::getMonotonicTime() and used for MIDI input timestamps.
+//     The message is sent by a separate thread for the output port
+//     which sleeps until it is due, so the timing does not depend on 
+//     how often the main loop runs.  A time which has already passed 
+//     sends the message as soon as possible.  Messages sent with sendAt()
+//     are not recorded by recordStart(), but notes are counted by
+//     isSounding() as soon as they are queued.  Returns 1 if the message
+//     was scheduled.
+//
+
+int MidiOutput::sendAt(int64_t nanoseconds, int command, int p1, int p2) {
+   uchar data[3] = {(uchar)command, (uchar)p1, (uchar)p2};
+   return sendAt(nanoseconds, data, 3);
+}
+
+
+int MidiOutput::sendAt(int64_t nanoseconds, smf::MidiEvent& message) {
+   if (message.size() == 0) {
+      return 0;
+   }
+   return sendAt(nanoseconds, message.data(), (int)message.size());
+}
+
+
+int MidiOutput::sendAt(int64_t nanoseconds, const uchar* data, int size) {
+   MidiSendQueue* queue = getSendQueue();
+   if (queue == NULL) {
+      return 0;
+   }
+   return queue->insert(nanoseconds, data, size);
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::setPacing -- if true, output to the port is written no
+//     faster than the given number of bytes per second (by default the
+//     speed of a MIDI cable), so that bursts such as chords, glissandos
+//     and sysex do not pile up in the driver.  Messages which are sent 
+//     while the cable is busy wait in the sender thread of the port 
+//     (see MidiSendQueue), where notes go before controllers and
+//     controllers go before sysex, and a newer controller value 
+//     replaces one which is still waiting.  send() and sysex() then 
+//     return as soon as the message is queued.  The setting is shared
+//     by all MidiOutput objects which use the port.  Output written 
+//     directly with rawsend() is not paced.
+//     default value: bytesPerSecond = MIDI_WIRE_BYTES_PER_SECOND
+//
+
+void MidiOutput::setPacing(int aState, double bytesPerSecond) {
+   MidiSendQueue* queue = getSendQueue();
+   if (queue == NULL) {
+      return;
+   }
+   queue->setPacing(aState ? bytesPerSecond : 0.0);
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::setStateCache -- if true, controller, pitch bend, program
+//     change and RPN/NRPN selection messages which would not change 
+//     the last value sent on the port are not sent (see MidiStateCache).
+//     Changes up to the deadbands are also not sent.  This is useful
+//     when controllers are mapped from a sensor which reports at a high
+//     rate.  The setting is shared by all MidiOutput objects which use
+//     the port.  Output sent with sendAt(), rawsend() or by other 
+//     programs is not seen by the cache, so those values will be 
+//     resent by the next matching message, or may be left out if they
+//     match what the cache remembers.
+//     default values: controllerDeadband = 0, pitchBendDeadband = 0
+//
+
+void MidiOutput::setStateCache(int aState, int controllerDeadband, 
+      int pitchBendDeadband) {
+   if (outputState == NULL || getPort() == -1) {
+      return;
+   }
+   outputState[getPort()].setDeadband(controllerDeadband, pitchBendDeadband);
+   outputState[getPort()].setActive(aState);
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::silence -- send a note off to all sounding notes on all 
+//    channels (or on one channel).  Only the notes which were sent 
+//    through MidiOutput objects are known, so use panic() to also turn
+//    off notes sent some other way.  A key which was played more than
+//    once without being released is sent a note off for each note-on.
+//    Notes which are still waiting to be sent (by sendAt() or paced
+//    output) are counted, but a note-on scheduled for a later time
+//    will still sound after the note off, so use clearScheduled() 
+//    first to throw those away.
 //    default value: aChannel = -1
 //
 
 void MidiOutput::silence(int aChannel) {
-   int keyno;
-   if (aChannel == -1) {
-      for (int channel=0; channel<16; channel++) {
-         for (keyno=0; keyno<128; keyno++) {
-            play(channel, keyno, 0);
-         }
+   if (activeNotes == NULL || getPort() == -1) {
+      return;
+   }
+   MidiActiveNotes& notes = activeNotes[getPort()];
+   int first = 0;
+   int last  = 15;
+   if (aChannel != -1) {
+      first = last = aChannel & 0x0f;
+   }
+   int channel, keyno, count;
+   for (channel=first; channel<=last; channel++) {
+      if (notes.getActiveCount(channel) == 0) {
+         continue;
       }
-   } else {
       for (keyno=0; keyno<128; keyno++) {
-         play(aChannel, keyno, 0);
+         count = notes.getNoteCount(channel, keyno);
+         while (count-- > 0) {
+            play(channel, keyno, 0);
+         }
       }
    }
+   // don't leave the note-offs waiting if output is being staged
+   flush();
 }
 
 
@@ -407,11 +776,19 @@ void MidiOutput::sustain(int channel, int status) {
 //
 
 int MidiOutput::sysex(char* data, int length) {
-   return rawsend((uchar*)data, length);
+   return sysex((uchar*)data, length);
 }
 
 
 int MidiOutput::sysex(uchar* data, int length) {
+   // the sysex may change anything, so forget the state of the port
+   isRedundant(0xf0, 0, 0, 1);
+   if (outputRecordQ && outputRecordType == RECORD_MIDI_FILE) {
+      midiRecorder->record(getPort(), data, length);
+   }
+   if (isPaced()) {
+      return sendAt(SigTimer::getMonotonicTime(), data, length);
+   }
    return rawsend(data, length);
 }
 
@@ -510,29 +887,29 @@ int MidiOutput::NRPN(int channel, int nrpn_msb, int nrpn_lsb,
       int data_msb, int data_lsb) {
    channel  = channel  & 0x0f;
    nrpn_msb = nrpn_msb & 0x7f;
-   nrpn_lsb = nrpn_msb & 0x7f;
-   data_msb = nrpn_msb & 0x7f;
-   data_lsb = nrpn_msb & 0x7f;
+   nrpn_lsb = nrpn_lsb & 0x7f;
+   data_msb = data_msb & 0x7f;
+   data_lsb = data_lsb & 0x7f;
  
    int status = 1;
 
    // check to see if the nrpn_msb and nrpn_lsb are the same
    // as the last call to this function, if not, then send
    // the appropriate MIDI controller values.
-   if (rpn_msb_status[getPort()][channel] != nrpn_msb) {
+   if (rpn_msb_status[getPort()][channel] != (nrpn_msb | NRPN_SELECTED)) {
       status &= cont(channel, 99, nrpn_msb);
-      rpn_msb_status[getPort()][channel] = nrpn_msb;
+      rpn_msb_status[getPort()][channel] = nrpn_msb | NRPN_SELECTED;
    }
-   if (rpn_lsb_status[getPort()][channel] != nrpn_lsb) {
+   if (rpn_lsb_status[getPort()][channel] != (nrpn_lsb | NRPN_SELECTED)) {
       status &= cont(channel, 98, nrpn_lsb);
-      rpn_lsb_status[getPort()][channel] = nrpn_lsb;
+      rpn_lsb_status[getPort()][channel] = nrpn_lsb | NRPN_SELECTED;
    }
 
    // now that the NRPN state is set, send the NRPN data values
    // but do not bother sending any data if the Null RPN is in effect.
    if (nrpn_msb != 127 && nrpn_lsb != 127) {
       status &= cont(channel, 6, data_msb);
-      status &= cont(channel, 38, data_msb);
+      status &= cont(channel, 38, data_lsb);
    }
 
    return status;
@@ -542,21 +919,21 @@ int MidiOutput::NRPN(int channel, int nrpn_msb, int nrpn_lsb,
 int MidiOutput::NRPN(int channel, int nrpn_msb, int nrpn_lsb, int data_msb) {
    channel  = channel  & 0x0f;
    nrpn_msb = nrpn_msb & 0x7f;
-   nrpn_lsb = nrpn_msb & 0x7f;
-   data_msb = nrpn_msb & 0x7f;
+   nrpn_lsb = nrpn_lsb & 0x7f;
+   data_msb = data_msb & 0x7f;
  
    int status = 1;
 
    // check to see if the nrpn_msb and nrpn_lsb are the same
    // as the last call to this function, if not, then send
    // the appropriate MIDI controller values.
-   if (rpn_msb_status[getPort()][channel] != nrpn_msb) {
+   if (rpn_msb_status[getPort()][channel] != (nrpn_msb | NRPN_SELECTED)) {
       status &= cont(channel, 99, nrpn_msb);
-      rpn_msb_status[getPort()][channel] = nrpn_msb;
+      rpn_msb_status[getPort()][channel] = nrpn_msb | NRPN_SELECTED;
    }
-   if (rpn_lsb_status[getPort()][channel] != nrpn_lsb) {
+   if (rpn_lsb_status[getPort()][channel] != (nrpn_lsb | NRPN_SELECTED)) {
       status &= cont(channel, 98, nrpn_lsb);
-      rpn_lsb_status[getPort()][channel] = nrpn_lsb;
+      rpn_lsb_status[getPort()][channel] = nrpn_lsb | NRPN_SELECTED;
    }
 
    // now that the NRPN state is set, send the NRPN data value,
@@ -572,7 +949,7 @@ int MidiOutput::NRPN(int channel, int nrpn_msb, int nrpn_lsb, int data_msb) {
 int MidiOutput::NRPN(int channel, int nrpn_msb, int nrpn_lsb, double data) {
    channel  = channel  & 0x0f;
    nrpn_msb = nrpn_msb & 0x7f;
-   nrpn_lsb = nrpn_msb & 0x7f;
+   nrpn_lsb = nrpn_lsb & 0x7f;
    if (data < -1.0) {
       data = -1.0;
    } else if (data > 1.0) {
@@ -584,13 +961,13 @@ int MidiOutput::NRPN(int channel, int nrpn_msb, int nrpn_lsb, double data) {
    // check to see if the nrpn_msb and nrpn_lsb are the same
    // as the last call to this function, if not, then send
    // the appropriate MIDI controller values.
-   if (rpn_msb_status[getPort()][channel] != nrpn_msb) {
+   if (rpn_msb_status[getPort()][channel] != (nrpn_msb | NRPN_SELECTED)) {
       status &= cont(channel, 99, nrpn_msb);
-      rpn_msb_status[getPort()][channel] = nrpn_msb;
+      rpn_msb_status[getPort()][channel] = nrpn_msb | NRPN_SELECTED;
    }
-   if (rpn_lsb_status[getPort()][channel] != nrpn_lsb) {
+   if (rpn_lsb_status[getPort()][channel] != (nrpn_lsb | NRPN_SELECTED)) {
       status &= cont(channel, 98, nrpn_lsb);
-      rpn_lsb_status[getPort()][channel] = nrpn_lsb;
+      rpn_lsb_status[getPort()][channel] = nrpn_lsb | NRPN_SELECTED;
    }
 
    // convert data into 14 bit number
@@ -853,9 +1230,9 @@ int MidiOutput::RPN(int channel, int rpn_msb, int rpn_lsb,
       int data_msb, int data_lsb) {
    channel  = channel & 0x0f;
    rpn_msb  = rpn_msb & 0x7f;
-   rpn_lsb  = rpn_msb & 0x7f;
-   data_msb = rpn_msb & 0x7f;
-   data_lsb = rpn_msb & 0x7f;
+   rpn_lsb  = rpn_lsb & 0x7f;
+   data_msb = data_msb & 0x7f;
+   data_lsb = data_lsb & 0x7f;
  
    int status = 1;
 
@@ -875,7 +1252,7 @@ int MidiOutput::RPN(int channel, int rpn_msb, int rpn_lsb,
    // but do not bother sending any data if the Null RPN is in effect.
    if (rpn_msb != 127 && rpn_lsb != 127) {
       status &= cont(channel, 6, data_msb);
-      status &= cont(channel, 38, data_msb);
+      status &= cont(channel, 38, data_lsb);
    }
 
    return status;
@@ -885,8 +1262,8 @@ int MidiOutput::RPN(int channel, int rpn_msb, int rpn_lsb,
 int MidiOutput::RPN(int channel, int rpn_msb, int rpn_lsb, int data_msb) {
    channel  = channel & 0x0f;
    rpn_msb  = rpn_msb & 0x7f;
-   rpn_lsb  = rpn_msb & 0x7f;
-   data_msb = rpn_msb & 0x7f;
+   rpn_lsb  = rpn_lsb & 0x7f;
+   data_msb = data_msb & 0x7f;
  
    int status = 1;
 
@@ -915,7 +1292,7 @@ int MidiOutput::RPN(int channel, int rpn_msb, int rpn_lsb, int data_msb) {
 int MidiOutput::RPN(int channel, int rpn_msb, int rpn_lsb, double data) {
    channel = channel & 0x0f;
    rpn_msb = rpn_msb & 0x7f;
-   rpn_lsb = rpn_msb & 0x7f;
+   rpn_lsb = rpn_lsb & 0x7f;
    if (data < -1.0) {
       data = -1.0;
    } else if (data > 1.0) {
@@ -1039,6 +1416,21 @@ void MidiOutput::initializeRPN(void) {
 
 
 
+//////////////////////////////
+//
+// MidiOutput::deinitializeActiveNotes -- destroy the sounding note lists.
+//     The send queues must be deleted first, since their threads use them.
+//
+
+void MidiOutput::deinitializeActiveNotes(void) {
+   if (activeNotes != NULL) {
+      delete [] activeNotes;
+      activeNotes = NULL;
+   }
+}
+
+
+
 //////////////////////////////
 //
 // MidiOutput::deinitializeRPN -- destroy the RPN status arrays
@@ -1059,6 +1451,171 @@ void MidiOutput::deinitializeRPN(void) {
 
 
 
+//////////////////////////////
+//
+// MidiOutput::deinitializeSendQueues -- stop the sender threads of 
+//    the timed output queues.
+//
+
+void MidiOutput::deinitializeSendQueues(void) {
+   std::lock_guard<std::mutex> lock(sendQueueLock);
+   if (sendQueue == NULL) {
+      return;
+   }
+   for (int i=0; i<getNumPorts(); i++) {
+      if (sendQueue[i] != NULL) {
+         delete sendQueue[i];
+      }
+   }
+   delete [] sendQueue;
+   sendQueue = NULL;
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::getSendQueue -- returns the timed output queue for the
+//    port, starting its sender thread if this is the first time that
+//    the queue is needed.  Returns NULL if there is no port.
+//
+
+MidiSendQueue* MidiOutput::getSendQueue(void) {
+   if (getPort() == -1) {
+      return NULL;
+   }
+   std::lock_guard<std::mutex> lock(sendQueueLock);
+   if (sendQueue == NULL) {
+      sendQueue = new MidiSendQueue*[getNumPorts()];
+      for (int i=0; i<getNumPorts(); i++) {
+         sendQueue[i] = NULL;
+      }
+   }
+   if (sendQueue[getPort()] == NULL) {
+      MidiActiveNotes* notes = NULL;
+      if (activeNotes != NULL) {
+         notes = &activeNotes[getPort()];
+      }
+      sendQueue[getPort()] = new MidiSendQueue(getPort(), notes);
+   }
+   return sendQueue[getPort()];
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::deinitializeStateCache -- destroy the output state caches.
+//
+
+void MidiOutput::deinitializeStateCache(void) {
+   if (outputState != NULL) {
+      delete [] outputState;
+      outputState = NULL;
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::initializeActiveNotes -- set up an empty list of sounding
+//    notes for each port.
+//
+
+void MidiOutput::initializeActiveNotes(void) {
+   if (activeNotes == NULL && getNumPorts() > 0) {
+      activeNotes = new MidiActiveNotes[getNumPorts()];
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::initializeStateCache -- set up an inactive output state
+//    cache for each port.
+//
+
+void MidiOutput::initializeStateCache(void) {
+   if (outputState == NULL && getNumPorts() > 0) {
+      outputState = new MidiStateCache[getNumPorts()];
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::isPaced -- returns true if output to the port goes 
+//    through the pacing of its send queue.
+//
+
+int MidiOutput::isPaced(void) {
+   if (sendQueue == NULL || getPort() == -1 || sendQueue[getPort()] == NULL) {
+      return 0;
+   }
+   return sendQueue[getPort()]->isPaced();
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::isRedundant -- returns true if the message does not need
+//    to be sent because it would not change the state of the port.
+//
+
+int MidiOutput::isRedundant(int command, int p1, int p2, int size) {
+   if (outputState == NULL || getPort() == -1) {
+      return 0;
+   }
+   MidiStateCache& cache = outputState[getPort()];
+   if (!cache.getActive()) {
+      return 0;
+   }
+   uchar data[3] = {(uchar)command, (uchar)p1, (uchar)p2};
+   return !cache.accept(data, size);
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::sendFailed -- forget the remembered state of the channel
+//    of a message which could not be sent, since it is not known what
+//    the device received.
+//
+
+void MidiOutput::sendFailed(int command) {
+   if (outputState == NULL || getPort() == -1) {
+      return;
+   }
+   if (command >= 0x80 && command < 0xf0) {
+      outputState[getPort()].clear(command & 0x0f);
+   } else {
+      outputState[getPort()].clear();
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutput::sendSucceeded -- keep track of the notes which are
+//    sounding after a message has been sent.
+//
+
+void MidiOutput::sendSucceeded(int command, int p1, int p2, int size) {
+   if (activeNotes == NULL || getPort() == -1) {
+      return;
+   }
+   uchar data[3] = {(uchar)command, (uchar)p1, (uchar)p2};
+   activeNotes[getPort()].update(data, size);
+}
+
+
+
 //////////////////////////////
 //
 // MidiOutput::writeOutputAscii
@@ -1110,14 +1667,14 @@ void MidiOutput::writeOutputBinary(int command, int p1, int p2) {
 //
 
 void MidiOutput::writeOutputMidifile(int command, int p1, int p2) {
-   static SigTimer localtime;
+   uchar data[3] = {(uchar)command, (uchar)p1, (uchar)p2};
+   int size = 3;
    if (p1 < 0) {
-      rtmidifile.writeAbsolute(localtime.getTime(), command);
+      size = 1;
    } else if (p2 < 0) {
-      rtmidifile.writeAbsolute(localtime.getTime(), command, p1);
-   } else {
-      rtmidifile.writeAbsolute(localtime.getTime(), command, p1, p2);
+      size = 2;
    }
+   midiRecorder->record(getPort(), data, size);
 }
 
 
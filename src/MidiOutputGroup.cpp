@@ -0,0 +1,459 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 20:04:37 PDT 2026
+// Last Modified: Sat Oct 17 20:04:37 PDT 2026
+// Last Modified: Sun Oct 18 11:24:09 PDT 2026 (follow sounding notes)
+// Filename:      ...sig/maint/code/control/MidiOutput/MidiOutputGroup.cpp
+// Web Address:   http://sig.sapp.org/src/sig/MidiOutputGroup.cpp
+// Syntax:        C++11
+//
+// Description:   Sends one MIDI message to several output destinations.
+//
+
+#include "MidiOutputGroup.h"
+#include "MidiOutput.h"
+
+
+//////////////////////////////
+//
+// MidiOutputGroup::MidiOutputGroup -- the group starts with no
+//     destinations.
+//
+
+MidiOutputGroup::MidiOutputGroup(void) {
+   compiled = 0;
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutputGroup::~MidiOutputGroup --
+//
+
+MidiOutputGroup::~MidiOutputGroup() {
+   clear();
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutputGroup::addDestination -- send messages to the given output
+//     port.  The port is opened if autoOpen is true.  By default all
+//     messages are sent unchanged; the rules of the destination can
+//     then be set with the returned destination index.  A port may be
+//     added more than once with different rules.
+//     default value: autoOpen = 1
+//
+
+int MidiOutputGroup::addDestination(int aPort, int autoOpen) {
+   Destination destination;
+   destination.output = -1;
+   for (int i=0; i<(int)outputs.size(); i++) {
+      if (outputs[i].port->getPort() == aPort) {
+         destination.output = i;
+         break;
+      }
+   }
+   if (destination.output < 0) {
+      Output output;
+      output.port = new MidiOutPort(aPort, autoOpen);
+      outputs.push_back(output);
+      destination.output = (int)outputs.size() - 1;
+   }
+
+   for (int i=0; i<16; i++) {
+      destination.channelMap[i] = i;
+   }
+   destination.commandMask = 0x7f;
+   destination.systemMask  = 0xffff;
+   destination.lowKey      = 0;
+   destination.highKey     = 127;
+   destination.transpose   = 0;
+   destinations.push_back(destination);
+   compiled = 0;
+
+   return (int)destinations.size() - 1;
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutputGroup::clear -- remove all destinations.
+//
+
+void MidiOutputGroup::clear(void) {
+   for (int i=0; i<(int)outputs.size(); i++) {
+      delete outputs[i].port;
+   }
+   outputs.clear();
+   destinations.clear();
+   routes.clear();
+   pending.clear();
+   compiled = 0;
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutputGroup::getDestinationCount -- returns the number of
+//     destinations in the group.
+//
+
+int MidiOutputGroup::getDestinationCount(void) const {
+   return (int)destinations.size();
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutputGroup::getPort -- returns the output port of a destination,
+//     or -1 if there is no such destination.
+//
+
+int MidiOutputGroup::getPort(int destination) const {
+   if (destination < 0 || destination >= (int)destinations.size()) {
+      return -1;
+   }
+   return outputs[destinations[destination].output].port->getPort();
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutputGroup::send -- send a MIDI message to all of the
+//     destinations which accept it.  Returns 1 if every output port
+//     was written successfully (or if no destination accepts the
+//     message), 0 otherwise.
+//
+
+int MidiOutputGroup::send(const uchar* data, int size) {
+   if (size < 1 || data[0] < 0x80) {
+      return 0;
+   }
+   if (!compiled) {
+      compile();
+   }
+
+   int index = data[0] - 0x80;
+   int noteQ = data[0] < 0xb0 && size >= 2;
+   int key;
+   for (int i=routeStart[index]; i<routeStart[index+1]; i++) {
+      Route& route = routes[i];
+      key = 0;
+      if (noteQ) {
+         if (data[1] < route.lowKey || data[1] > route.highKey) {
+            continue;
+         }
+         key = data[1] + route.transpose;
+         if (key < 0 || key > 127) {
+            continue;
+         }
+      }
+      std::vector<uchar>& batch = outputs[route.output].batch;
+      if (batch.empty()) {
+         pending.push_back(route.output);
+      }
+      batch.push_back(route.status);
+      if (size >= 2) {
+         batch.push_back(noteQ ? (uchar)key : data[1]);
+         batch.insert(batch.end(), data + 2, data + size);
+      }
+   }
+
+   int status = 1;
+   int sent;
+   for (int i=0; i<(int)pending.size(); i++) {
+      Output& output = outputs[pending[i]];
+      sent = output.port->rawsend(output.batch.data(),
+            (int)output.batch.size()) == 1;
+      if (!sent) {
+         status = 0;
+      }
+      trackOutput(output.port->getPort(), output.batch.data(),
+            (int)output.batch.size(), size, sent);
+      output.batch.clear();
+   }
+   pending.clear();
+
+   return status;
+}
+
+
+int MidiOutputGroup::send(int command, int p1, int p2) {
+   uchar data[3] = {(uchar)command, (uchar)p1, (uchar)p2};
+   return send(data, 3);
+}
+
+
+int MidiOutputGroup::send(int command, int p1) {
+   uchar data[2] = {(uchar)command, (uchar)p1};
+   return send(data, 2);
+}
+
+
+int MidiOutputGroup::send(int command) {
+   uchar data[1] = {(uchar)command};
+   return send(data, 1);
+}
+
+
+int MidiOutputGroup::send(smf::MidiEvent& message) {
+   if (message.size() == 0) {
+      return 0;
+   }
+   return send(message.data(), (int)message.size());
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutputGroup::setChannel -- send channel messages on inChannel to
+//     outChannel of the destination, or don't send them if outChannel
+//     is -1.  The second form sends all channels to one channel.
+//
+
+void MidiOutputGroup::setChannel(int destination, int inChannel,
+      int outChannel) {
+   Destination* target = getDestination(destination);
+   if (target == NULL) {
+      return;
+   }
+   target->channelMap[inChannel & 0x0f] = outChannel < 0 ? -1 :
+         outChannel & 0x0f;
+   compiled = 0;
+}
+
+
+void MidiOutputGroup::setChannel(int destination, int outChannel) {
+   for (int i=0; i<16; i++) {
+      setChannel(destination, i, outChannel);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutputGroup::setCommand -- send (state = 1) or don't send
+//     (state = 0) a type of message to the destination.  The command
+//     is either a channel command (0x80 to 0xe0, the channel is
+//     ignored) or a system message status byte (0xf0 to 0xff).
+//
+
+void MidiOutputGroup::setCommand(int destination, int command, int state) {
+   Destination* target = getDestination(destination);
+   if (target == NULL || command < 0x80 || command > 0xff) {
+      return;
+   }
+   if (command >= 0xf0) {
+      uint16_t bit = (uint16_t)(1 << (command & 0x0f));
+      if (state) {
+         target->systemMask |= bit;
+      } else {
+         target->systemMask &= (uint16_t)~bit;
+      }
+   } else {
+      uint8_t bit = (uint8_t)(1 << (((command & 0xf0) >> 4) - 8));
+      if (state) {
+         target->commandMask |= bit;
+      } else {
+         target->commandMask &= (uint8_t)~bit;
+      }
+   }
+   compiled = 0;
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutputGroup::setNoteRange -- send note-off, note-on and
+//     polyphonic aftertouch messages to the destination only for keys
+//     from lowKey to highKey inclusive (before transposition).
+//
+
+void MidiOutputGroup::setNoteRange(int destination, int aLowKey,
+      int aHighKey) {
+   Destination* target = getDestination(destination);
+   if (target == NULL) {
+      return;
+   }
+   if (aLowKey > aHighKey) {
+      int temp = aLowKey;
+      aLowKey = aHighKey;
+      aHighKey = temp;
+   }
+   if (aLowKey < 0) {
+      aLowKey = 0;
+   }
+   if (aHighKey > 127) {
+      aHighKey = 127;
+   }
+   target->lowKey  = (uchar)aLowKey;
+   target->highKey = (uchar)aHighKey;
+   compiled = 0;
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutputGroup::setTranspose -- add the given number of semitones to
+//     the key numbers of note-off, note-on and polyphonic aftertouch
+//     messages sent to the destination.  Notes which would be
+//     transposed outside of the range 0-127 are not sent.
+//
+
+void MidiOutputGroup::setTranspose(int destination, int semitones) {
+   Destination* target = getDestination(destination);
+   if (target == NULL) {
+      return;
+   }
+   if (semitones < -127) {
+      semitones = -127;
+   } else if (semitones > 127) {
+      semitones = 127;
+   }
+   target->transpose = semitones;
+   compiled = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// private functions
+//
+
+
+//////////////////////////////
+//
+// MidiOutputGroup::compile -- make the list of routes for each status
+//     byte from the rules of the destinations.  The routes of status
+//     byte 0x80 + n are routes[routeStart[n]] up to
+//     routes[routeStart[n+1]-1].  System messages are only sent once to
+//     an output port, even if several of its destinations accept them.
+//
+
+void MidiOutputGroup::compile(void) {
+   routes.clear();
+   Route route;
+   int i, j, k, status, channel, duplicate;
+   for (i=0; i<128; i++) {
+      routeStart[i] = (int)routes.size();
+      status = 0x80 + i;
+      for (j=0; j<(int)destinations.size(); j++) {
+         Destination& destination = destinations[j];
+         route.output    = destination.output;
+         route.status    = (uchar)status;
+         route.lowKey    = 0;
+         route.highKey   = 127;
+         route.transpose = 0;
+         if (status >= 0xf0) {
+            if (!(destination.systemMask & (1 << (status & 0x0f)))) {
+               continue;
+            }
+            duplicate = 0;
+            for (k=routeStart[i]; k<(int)routes.size(); k++) {
+               if (routes[k].output == route.output) {
+                  duplicate = 1;
+                  break;
+               }
+            }
+            if (duplicate) {
+               continue;
+            }
+         } else {
+            if (!(destination.commandMask & (1 << ((status >> 4) - 8)))) {
+               continue;
+            }
+            channel = destination.channelMap[status & 0x0f];
+            if (channel < 0) {
+               continue;
+            }
+            route.status = (uchar)((status & 0xf0) | channel);
+            if (status < 0xb0) {
+               route.lowKey    = destination.lowKey;
+               route.highKey   = destination.highKey;
+               route.transpose = (int8_t)destination.transpose;
+            }
+         }
+         routes.push_back(route);
+      }
+   }
+   routeStart[128] = (int)routes.size();
+   compiled = 1;
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutputGroup::getDestination -- returns the rules of a
+//     destination, or NULL if there is no such destination.
+//
+
+MidiOutputGroup::Destination* MidiOutputGroup::getDestination(
+      int destination) {
+   if (destination < 0 || destination >= (int)destinations.size()) {
+      return NULL;
+   }
+   return &destinations[destination];
+}
+
+
+
+//////////////////////////////
+//
+// MidiOutputGroup::trackOutput -- keep the sounding notes and the
+//     state cache of MidiOutput in step with the count bytes written
+//     to a port, which are messages of size bytes each.  If the write
+//     failed the notes are left alone, but the state cache of the port
+//     is cleared since it is not known what the device received.
+//
+
+void MidiOutputGroup::trackOutput(int aPort, const uchar* data, int count,
+      int size, int sent) {
+   if (aPort < 0 || aPort >= MidiOutPort::getNumPorts()) {
+      return;
+   }
+   MidiStateCache* cache = NULL;
+   if (MidiOutput::outputState != NULL &&
+         MidiOutput::outputState[aPort].getActive()) {
+      cache = &MidiOutput::outputState[aPort];
+   }
+   if (!sent) {
+      if (cache != NULL) {
+         cache->clear();
+      }
+      return;
+   }
+   MidiActiveNotes* notes = NULL;
+   if (MidiOutput::activeNotes != NULL) {
+      notes = &MidiOutput::activeNotes[aPort];
+   }
+   for (int i=0; i+size<=count; i+=size) {
+      if (notes != NULL) {
+         notes->update(data + i, size);
+      }
+      if (cache == NULL) {
+         continue;
+      }
+      if (data[i] >= 0xb0 && data[i] < 0xf0) {
+         cache->clear(data[i] & 0x0f);
+      } else if (data[i] == 0xf0 || data[i] == 0xff) {
+         // a sysex or a system reset may change anything
+         cache->clear();
+      }
+   }
+}
+
+
+
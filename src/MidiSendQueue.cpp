@@ -0,0 +1,586 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 17:34:26 PDT 2026
+// Last Modified: Sat Oct 17 17:34:26 PDT 2026
+// Last Modified: Sat Oct 17 19:27:03 PDT 2026 (active note tracking)
+// Last Modified: Sat Oct 17 20:41:18 PDT 2026 (output pacing)
+// Filename:      ...sig/maint/code/control/MidiOutput/MidiSendQueue.cpp
+// Web Address:   http://sig.sapp.org/src/sig/MidiSendQueue.cpp
+// Syntax:        C++11
+//
+// Description:   Time-ordered MIDI output queue with a sender thread.
+//
+
+#include "MidiSendQueue.h"
+#include "SigTimer.h"
+
+#include <algorithm>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef OLDCPP
+   #include <iostream>
+   using namespace std;
+#else
+   #include <iostream.h>
+#endif
+
+// initial number of pending messages which can be stored without
+// allocating memory
+#define SEND_QUEUE_RESERVE (256)
+
+// when output is paced, a message may be written this many nanoseconds
+// before the cable is free, so that the driver does not run dry
+#define PACING_LEAD (1000000)
+
+
+//////////////////////////////
+//
+// MidiSendQueue::MidiSendQueue -- start the sender thread for the
+//     port.  The port must be opened by the caller.  If notes is not 
+//     NULL, the notes are added to it as they are queued.
+//     default value: notes = NULL
+//
+
+MidiSendQueue::MidiSendQueue(int aPort, MidiActiveNotes* notes) : 
+      output(aPort, 0) {
+   activeNotes = notes;
+   heap.reserve(SEND_QUEUE_RESERVE);
+   orderCount = 0;
+   running = 1;
+   laneBytes = 0;
+   writeCount = 0;
+   wireBusyUntil = 0;
+   byteTime.store(0);
+   memset(&statistics, 0, sizeof(statistics));
+
+   pthread_mutex_init(&queueLock, NULL);
+   pthread_condattr_t attributes;
+   pthread_condattr_init(&attributes);
+   #ifdef LINUX
+      // wait with absolute CLOCK_MONOTONIC times, the same as the
+      // message times, so that clock adjustments don't move them
+      pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+   #endif
+   pthread_cond_init(&queueChanged, &attributes);
+   pthread_condattr_destroy(&attributes);
+
+   int flag = pthread_create(&senderThread, NULL, sendMidiQueuePrivate, this);
+   if (flag != 0) {
+      cout << "Unable to create MIDI output thread." << endl;
+      exit(1);
+   }
+
+   // try for realtime scheduling, which needs privileges; the thread
+   // still works without it, but with more jitter when the system is busy
+   struct sched_param parameters;
+   parameters.sched_priority = sched_get_priority_min(SCHED_FIFO);
+   pthread_setschedparam(senderThread, SCHED_FIFO, &parameters);
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::~MidiSendQueue -- stop the sender thread.  Messages
+//     which have not been sent yet are thrown away.
+//
+
+MidiSendQueue::~MidiSendQueue() {
+   pthread_mutex_lock(&queueLock);
+   running = 0;
+   pthread_cond_signal(&queueChanged);
+   pthread_mutex_unlock(&queueLock);
+   pthread_join(senderThread, NULL);
+
+   pthread_cond_destroy(&queueChanged);
+   pthread_mutex_destroy(&queueLock);
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::clear -- throw away all messages which have not been
+//     sent yet.
+//
+
+void MidiSendQueue::clear(void) {
+   pthread_mutex_lock(&queueLock);
+   heap.clear();
+   for (int i=0; i<3; i++) {
+      lane[i].clear();
+   }
+   laneBytes = 0;
+   pthread_cond_signal(&queueChanged);
+   pthread_mutex_unlock(&queueLock);
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::clearStatistics -- reset the sent message count and
+//     the lateness histogram.
+//
+
+void MidiSendQueue::clearStatistics(void) {
+   pthread_mutex_lock(&queueLock);
+   memset(&statistics, 0, sizeof(statistics));
+   pthread_mutex_unlock(&queueLock);
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::getCount -- returns the number of messages waiting
+//     to be sent, including the messages which the sender thread is
+//     writing now.
+//
+
+int MidiSendQueue::getCount(void) {
+   pthread_mutex_lock(&queueLock);
+   int output = (int)heap.size() + writeCount;
+   for (int i=0; i<3; i++) {
+      output += (int)lane[i].size();
+   }
+   pthread_mutex_unlock(&queueLock);
+   return output;
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::getPacing -- returns the byte rate of paced output,
+//     or 0 if output is not paced.
+//
+
+double MidiSendQueue::getPacing(void) {
+   int64_t nanoseconds = byteTime.load(std::memory_order_relaxed);
+   if (nanoseconds <= 0) {
+      return 0.0;
+   }
+   return 1000000000.0 / nanoseconds;
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::getPort -- returns the output port of the queue.
+//
+
+int MidiSendQueue::getPort(void) {
+   return output.getPort();
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::getPredictedLatency -- returns the number of
+//     nanoseconds until the messages which are due, and the bytes 
+//     already written, would have left the cable.  A message which
+//     is due now would be delayed by about this much.  Always 0 if 
+//     output is not paced.
+//
+
+int64_t MidiSendQueue::getPredictedLatency(void) {
+   pthread_mutex_lock(&queueLock);
+   int64_t output = wireBusyUntil - SigTimer::getMonotonicTime();
+   if (output < 0) {
+      output = 0;
+   }
+   output += laneBytes * byteTime.load(std::memory_order_relaxed);
+   pthread_mutex_unlock(&queueLock);
+   return output;
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::getStatistics -- returns a copy of the sent message
+//     count and the lateness histogram.
+//
+
+void MidiSendQueue::getStatistics(MidiSendStatistics& stats) {
+   pthread_mutex_lock(&queueLock);
+   stats = statistics;
+   pthread_mutex_unlock(&queueLock);
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::insert -- add a message to send at the given
+//     CLOCK_MONOTONIC time in nanoseconds.  A message whose time has
+//     already passed is sent as soon as possible.  Notes are counted
+//     as sounding when they are queued rather than when they are 
+//     written, so that a note-on which is still waiting is not missed
+//     by MidiOutput::silence().  Returns 1 if the message was added, 
+//     or 0 if the message is empty.
+//
+
+int MidiSendQueue::insert(int64_t nanoseconds, const uchar* data, int size) {
+   if (size <= 0) {
+      return 0;
+   }
+   if (activeNotes != NULL) {
+      activeNotes->update(data, size);
+   }
+
+   Message message;
+   message.time = nanoseconds;
+   message.size = size;
+   if (size <= (int)sizeof(message.shortData)) {
+      memcpy(message.shortData, data, size);
+   } else {
+      message.longData.assign(data, data + size);
+   }
+
+   pthread_mutex_lock(&queueLock);
+   uint64_t order = orderCount++;
+   message.order = order;
+   heap.push_back(std::move(message));
+   std::push_heap(heap.begin(), heap.end(), isLater);
+   if (heap.front().order == order) {
+      // the new message is the next one, so the sender must recheck
+      pthread_cond_signal(&queueChanged);
+   }
+   pthread_mutex_unlock(&queueLock);
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::isPaced -- returns true if output is paced.
+//
+
+int MidiSendQueue::isPaced(void) {
+   return byteTime.load(std::memory_order_relaxed) > 0;
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::setPacing -- pace the output to the given number of
+//     bytes per second, such as MIDI_WIRE_BYTES_PER_SECOND for a MIDI
+//     cable.  0 turns pacing off, and messages which are waiting are
+//     then sent at once.
+//
+
+void MidiSendQueue::setPacing(double bytesPerSecond) {
+   pthread_mutex_lock(&queueLock);
+   if (bytesPerSecond > 0.0) {
+      byteTime.store((int64_t)(1000000000.0 / bytesPerSecond + 0.5));
+   } else {
+      byteTime.store(0);
+   }
+   pthread_cond_signal(&queueChanged);
+   pthread_mutex_unlock(&queueLock);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// private functions
+//
+
+
+//////////////////////////////
+//
+// MidiSendQueue::addToLane -- put a message which is due into its
+//     pacing lane.  A continuous message replaces a waiting message for
+//     the same controller (or key for aftertouch, or channel for pitch
+//     bend and channel pressure).  The queue lock must be held by the
+//     caller.
+//
+
+void MidiSendQueue::addToLane(Message& message) {
+   int index = getLane(message);
+   if (index == 1) {
+      int command = message.shortData[0] & 0xf0;
+      std::deque<Message>::reverse_iterator it;
+      for (it=lane[1].rbegin(); it!=lane[1].rend(); it++) {
+         if (it->shortData[0] != message.shortData[0]) {
+            continue;
+         }
+         if (command == 0xd0 || command == 0xe0 ||
+               it->shortData[1] == message.shortData[1]) {
+            memcpy(it->shortData, message.shortData, message.size);
+            it->time = message.time;
+            statistics.thinned++;
+            return;
+         }
+      }
+   }
+   laneBytes += message.size;
+   lane[index].push_back(std::move(message));
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::countLateness -- add a sent message to the
+//     statistics.  The queue lock must be held by the caller.
+//
+
+void MidiSendQueue::countLateness(int64_t lateness) {
+   if (lateness < 0) {
+      lateness = 0;
+   }
+   int bin = 0;
+   int64_t limit = 1000;
+   while (lateness >= limit && bin < MIDI_SEND_HISTOGRAM_SIZE - 1) {
+      limit *= 2;
+      bin++;
+   }
+   statistics.histogram[bin]++;
+   statistics.sent++;
+   statistics.totalLateness += lateness;
+   if (lateness > statistics.maxLateness) {
+      statistics.maxLateness = lateness;
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::getLane -- returns the pacing lane of a message: 0 for
+//     notes, program changes, real-time messages and controllers whose
+//     order matters (bank select, pedals, RPN/NRPN and channel mode
+//     messages), 1 for other controllers, pitch bend and aftertouch,
+//     and 2 for sysex and system common messages.
+//
+
+int MidiSendQueue::getLane(const Message& message) {
+   int status = message.size <= (int)sizeof(message.shortData) ?
+         message.shortData[0] : message.longData[0];
+   if (status >= 0xf8) {
+      return 0;
+   } else if (status >= 0xf0) {
+      return 2;
+   }
+
+   int command = status & 0xf0;
+   if (message.size != (command == 0xd0 ? 2 : 3)) {
+      // not a single message, so keep it in order
+      return 0;
+   }
+   int controller = message.shortData[1];
+   switch (command) {
+      case 0xa0:
+      case 0xd0:
+      case 0xe0:
+         return 1;
+      case 0xb0:
+         if (controller == 0 || controller == 6 || controller == 32 ||
+               controller == 38 || (controller >= 64 && controller <= 69) ||
+               (controller >= 96 && controller <= 101) || controller >= 120) {
+            return 0;
+         }
+         return 1;
+   }
+   return 0;
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::getNextTime -- returns when the sender thread next has
+//     something to do, or -1 if nothing is waiting.  The queue lock must
+//     be held by the caller.
+//
+
+int64_t MidiSendQueue::getNextTime(void) {
+   int64_t output = -1;
+   if (!heap.empty()) {
+      output = heap.front().time;
+   }
+   if (laneBytes > 0) {
+      int64_t laneTime = 0;
+      if (byteTime.load(std::memory_order_relaxed) > 0) {
+         laneTime = wireBusyUntil - PACING_LEAD;
+      }
+      if (output < 0 || laneTime < output) {
+         output = laneTime;
+      }
+   }
+   return output;
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::isLater -- heap ordering: true if message a is sent
+//     after message b.
+//
+
+bool MidiSendQueue::isLater(const Message& a, const Message& b) {
+   if (a.time != b.time) {
+      return a.time > b.time;
+   }
+   return a.order > b.order;
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::sendMessage -- write a message to the output port, and
+//     return how many nanoseconds late it was.  The write may block, so
+//     the queue lock must not be held by the caller.
+//
+
+int64_t MidiSendQueue::sendMessage(Message& message) {
+   if (message.size <= (int)sizeof(message.shortData)) {
+      output.rawsend(message.shortData, message.size);
+   } else {
+      output.rawsend(message.longData.data(), message.size);
+   }
+   return SigTimer::getMonotonicTime() - message.time;
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::takeLanes -- move messages from the pacing lanes into
+//     the batch to write, highest priority first, until the cable would
+//     be busy for more than PACING_LEAD.  If output is not paced, all of
+//     the waiting messages are taken.  The queue lock must be held by 
+//     the caller.
+//
+
+void MidiSendQueue::takeLanes(int64_t now, std::vector<Message>& batch) {
+   int64_t nanoseconds = byteTime.load(std::memory_order_relaxed);
+   int index;
+   while (laneBytes > 0) {
+      if (nanoseconds > 0 && wireBusyUntil - now > PACING_LEAD) {
+         break;
+      }
+      index = 0;
+      while (lane[index].empty()) {
+         index++;
+      }
+      Message& message = lane[index].front();
+      if (wireBusyUntil < now) {
+         wireBusyUntil = now;
+      }
+      wireBusyUntil += message.size * nanoseconds;
+      laneBytes -= message.size;
+      batch.push_back(std::move(message));
+      lane[index].pop_front();
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiSendQueue::waitUntil -- sleep until the given CLOCK_MONOTONIC
+//     time, or until the queue changes.  The queue lock must be held
+//     by the caller, and is released while waiting.
+//
+
+void MidiSendQueue::waitUntil(int64_t nanoseconds) {
+   struct timespec deadline;
+   #ifndef LINUX
+      // condition variables wait on the realtime clock here
+      struct timespec now;
+      clock_gettime(CLOCK_REALTIME, &now);
+      nanoseconds += (int64_t)now.tv_sec * 1000000000 + now.tv_nsec -
+            SigTimer::getMonotonicTime();
+   #endif
+   deadline.tv_sec  = (time_t)(nanoseconds / 1000000000);
+   deadline.tv_nsec = (long)(nanoseconds % 1000000000);
+   pthread_cond_timedwait(&queueChanged, &queueLock, &deadline);
+}
+
+
+
+//////////////////////////////
+//
+// sendMidiQueuePrivate -- the sender thread of a MidiSendQueue.  All
+//     messages which are due are sent together and then the port is
+//     flushed, so that output coalescing (if it is on) writes them with
+//     one system call.  If output is paced, the messages which are due
+//     go into the pacing lanes instead, and are written as the cable 
+//     becomes free.  The messages to write are moved into a batch and
+//     written after the queue lock is released, so that a write which
+//     blocks does not hold up insert().
+//
+
+void *sendMidiQueuePrivate(void* x) {
+   MidiSendQueue& queue = *((MidiSendQueue*)x);
+   vector<MidiSendQueue::Message>& heap = queue.heap;
+   vector<MidiSendQueue::Message> batch;
+   vector<int64_t> lateness;
+   batch.reserve(SEND_QUEUE_RESERVE);
+   lateness.reserve(SEND_QUEUE_RESERVE);
+   int i;
+
+   pthread_mutex_lock(&queue.queueLock);
+   while (queue.running) {
+      int64_t now = SigTimer::getMonotonicTime();
+      while (!heap.empty() && heap.front().time <= now) {
+         std::pop_heap(heap.begin(), heap.end(), MidiSendQueue::isLater);
+         MidiSendQueue::Message& message = heap.back();
+         if (queue.isPaced() || queue.laneBytes > 0) {
+            queue.addToLane(message);
+         } else {
+            batch.push_back(std::move(message));
+         }
+         heap.pop_back();
+      }
+      if (queue.laneBytes > 0) {
+         queue.takeLanes(now, batch);
+      }
+
+      if (!batch.empty()) {
+         queue.writeCount = (int)batch.size();
+         pthread_mutex_unlock(&queue.queueLock);
+         lateness.clear();
+         for (i=0; i<(int)batch.size(); i++) {
+            lateness.push_back(queue.sendMessage(batch[i]));
+         }
+         queue.output.flush();
+         batch.clear();
+         pthread_mutex_lock(&queue.queueLock);
+         queue.writeCount = 0;
+         for (i=0; i<(int)lateness.size(); i++) {
+            queue.countLateness(lateness[i]);
+         }
+         // more messages may have become due while writing
+         continue;
+      }
+
+      int64_t next = queue.getNextTime();
+      if (next < 0) {
+         pthread_cond_wait(&queue.queueChanged, &queue.queueLock);
+      } else if (next > now) {
+         // an earlier message may be added while waiting
+         queue.waitUntil(next);
+      }
+   }
+   pthread_mutex_unlock(&queue.queueLock);
+
+   return NULL;
+}
+
+
+
@@ -0,0 +1,367 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 18:49:55 PDT 2026
+// Last Modified: Sat Oct 17 18:49:55 PDT 2026
+// Filename:      ...sig/maint/code/control/MidiOutput/MidiStateCache.cpp
+// Web Address:   http://sig.sapp.org/src/sig/MidiStateCache.cpp
+// Syntax:        C++
+//
+// Description:   Remembers the state of a MIDI output port so that
+//                redundant messages can be left out.
+//
+
+#include "MidiStateCache.h"
+
+#include <stdlib.h>
+
+// values of selectionType
+#define SELECT_NONE (0)
+#define SELECT_NRPN (1)
+#define SELECT_RPN  (2)
+
+
+//////////////////////////////
+//
+// MidiStateCache::MidiStateCache -- the cache starts out inactive,
+//     with every value unknown.
+//
+
+MidiStateCache::MidiStateCache(void) {
+   active = 0;
+   controllerDeadband = 0;
+   pitchBendDeadband = 0;
+   clear();
+   clearStatistics();
+}
+
+
+
+//////////////////////////////
+//
+// MidiStateCache::accept -- returns true if the message should be sent,
+//     and remembers the values it sets.  Returns false if the message
+//     would not change the state of the port (or changes it by less
+//     than the deadband), and counts it as suppressed.  Everything is
+//     accepted when the cache is not active.
+//
+
+int MidiStateCache::accept(const uchar* data, int size) {
+   if (!active || size < 1) {
+      return 1;
+   }
+
+   int channel = data[0] & 0x0f;
+   switch (data[0] & 0xf0) {
+      case 0xb0:
+         if (size < 3) {
+            return 1;
+         }
+         if (!acceptController(channel, data[1] & 0x7f, data[2] & 0x7f)) {
+            return suppress(size);
+         }
+         return 1;
+
+      case 0xc0:
+         if (size < 2) {
+            return 1;
+         }
+         if (program[channel] == (data[1] & 0x7f)) {
+            return suppress(size);
+         }
+         program[channel] = data[1] & 0x7f;
+         return 1;
+
+      case 0xe0:
+         {
+            if (size < 3) {
+               return 1;
+            }
+            int value = (data[1] & 0x7f) | ((data[2] & 0x7f) << 7);
+            int old = pitchBend[channel];
+            if (old >= 0) {
+               int difference = abs(value - old);
+               // always send the ends and the center of the range
+               if (difference == 0 || (difference <= pitchBendDeadband &&
+                     value != 0 && value != 8192 && value != 16383)) {
+                  return suppress(size);
+               }
+            }
+            pitchBend[channel] = value;
+         }
+         return 1;
+
+      case 0xf0:
+         if (data[0] == 0xf0 || data[0] == 0xff) {
+            // a sysex or a system reset could change anything
+            clear();
+         }
+         return 1;
+   }
+
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// MidiStateCache::clear -- forget the state of all channels, or of one
+//     channel, so that the next messages are always sent.
+//
+
+void MidiStateCache::clear(void) {
+   for (int i=0; i<16; i++) {
+      clear(i);
+   }
+}
+
+
+void MidiStateCache::clear(int channel) {
+   channel &= 0x0f;
+   for (int i=0; i<128; i++) {
+      controller[channel][i] = -1;
+   }
+   for (int i=0; i<4; i++) {
+      selection[channel][i] = -1;
+   }
+   selectionType[channel] = SELECT_NONE;
+   pitchBend[channel] = -1;
+   program[channel] = -1;
+}
+
+
+
+//////////////////////////////
+//
+// MidiStateCache::clearStatistics -- reset the suppressed message and
+//     byte counts.
+//
+
+void MidiStateCache::clearStatistics(void) {
+   suppressedCount = 0;
+   suppressedBytes = 0;
+}
+
+
+
+//////////////////////////////
+//
+// MidiStateCache::getActive -- returns true if messages are being
+//     filtered.
+//
+
+int MidiStateCache::getActive(void) const {
+   return active;
+}
+
+
+
+//////////////////////////////
+//
+// MidiStateCache::getController -- returns the last value sent for the
+//     controller, or -1 if it is not known.
+//
+
+int MidiStateCache::getController(int channel, int controller) const {
+   return this->controller[channel & 0x0f][controller & 0x7f];
+}
+
+
+
+//////////////////////////////
+//
+// MidiStateCache::getControllerDeadband -- returns the largest change
+//     of a controller value which is not sent.
+//
+
+int MidiStateCache::getControllerDeadband(void) const {
+   return controllerDeadband;
+}
+
+
+
+//////////////////////////////
+//
+// MidiStateCache::getPitchBend -- returns the last 14-bit pitch bend
+//     value sent on the channel, or -1 if it is not known.
+//
+
+int MidiStateCache::getPitchBend(int channel) const {
+   return pitchBend[channel & 0x0f];
+}
+
+
+
+//////////////////////////////
+//
+// MidiStateCache::getPitchBendDeadband -- returns the largest change
+//     of a 14-bit pitch bend value which is not sent.
+//
+
+int MidiStateCache::getPitchBendDeadband(void) const {
+   return pitchBendDeadband;
+}
+
+
+
+//////////////////////////////
+//
+// MidiStateCache::getProgram -- returns the last program change sent on
+//     the channel, or -1 if it is not known.
+//
+
+int MidiStateCache::getProgram(int channel) const {
+   return program[channel & 0x0f];
+}
+
+
+
+//////////////////////////////
+//
+// MidiStateCache::getSuppressedBytes -- returns the number of bytes in
+//     the messages which were left out.
+//
+
+int64_t MidiStateCache::getSuppressedBytes(void) const {
+   return suppressedBytes;
+}
+
+
+
+//////////////////////////////
+//
+// MidiStateCache::getSuppressedCount -- returns the number of messages
+//     which were left out.
+//
+
+int64_t MidiStateCache::getSuppressedCount(void) const {
+   return suppressedCount;
+}
+
+
+
+//////////////////////////////
+//
+// MidiStateCache::setActive -- turn filtering on or off.  The state is
+//     forgotten either way, since nothing was remembered while the cache
+//     was inactive.
+//
+
+void MidiStateCache::setActive(int aState) {
+   active = aState ? 1 : 0;
+   clear();
+}
+
+
+
+//////////////////////////////
+//
+// MidiStateCache::setDeadband -- set the largest change in a controller
+//     value (0-127) and in a 14-bit pitch bend value (0-16383) which
+//     will not be sent.  0 only leaves out identical values.  The
+//     minimum and maximum values (and the center of the pitch bend
+//     range) are always sent, so that a controller can still reach its
+//     ends.
+//     default value: pitchBendDeadband = 0
+//
+
+void MidiStateCache::setDeadband(int controllerDeadband,
+      int pitchBendDeadband) {
+   this->controllerDeadband = controllerDeadband < 0 ? 0 : controllerDeadband;
+   this->pitchBendDeadband  = pitchBendDeadband  < 0 ? 0 : pitchBendDeadband;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// private functions
+//
+
+
+//////////////////////////////
+//
+// MidiStateCache::acceptController -- returns true if the controller
+//     message should be sent.
+//
+
+int MidiStateCache::acceptController(int channel, int number, int value) {
+   switch (number) {
+      case 0:    // bank select MSB
+      case 32:   // bank select LSB
+         // the bank only changes at the next program change, which
+         // must therefore be sent even if the program number is the same
+         program[channel] = -1;
+         break;
+
+      case 6:    // data entry MSB
+      case 38:   // data entry LSB
+      case 96:   // data increment
+      case 97:   // data decrement
+         // these act on the selected parameter
+         return 1;
+
+      case 98:   // NRPN LSB
+      case 99:   // NRPN MSB
+      case 100:  // RPN LSB
+      case 101:  // RPN MSB
+         {
+            int type = number >= 100 ? SELECT_RPN : SELECT_NRPN;
+            int index = number - 98;
+            if (selectionType[channel] == type) {
+               if (selection[channel][index] == value) {
+                  return 0;
+               }
+            } else {
+               // the other half of the parameter number may not be
+               // what the device is using now, so it has to be sent
+               for (int i=0; i<4; i++) {
+                  selection[channel][i] = -1;
+               }
+               selectionType[channel] = type;
+            }
+            selection[channel][index] = value;
+         }
+         return 1;
+   }
+
+   if (number >= 120) {
+      // channel mode messages are actions, not values
+      if (number == 121) {
+         // reset all controllers
+         for (int i=0; i<120; i++) {
+            controller[channel][i] = -1;
+         }
+         pitchBend[channel] = -1;
+      }
+      return 1;
+   }
+
+   int old = controller[channel][number];
+   if (old >= 0) {
+      int difference = abs(value - old);
+      if (difference == 0 || (difference <= controllerDeadband &&
+            value != 0 && value != 127)) {
+         return 0;
+      }
+   }
+   controller[channel][number] = value;
+   return 1;
+}
+
+
+
+//////////////////////////////
+//
+// MidiStateCache::suppress -- count a message which is left out.
+//     Always returns 0.
+//
+
+int MidiStateCache::suppress(int size) {
+   suppressedCount++;
+   suppressedBytes += size;
+   return 0;
+}
+
+
+
@@ -0,0 +1,262 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 12:05:51 PDT 2026
+// Last Modified: Sat Oct 17 12:05:51 PDT 2026
+// Last Modified: Sat Oct 17 14:22:15 PDT 2026 (added swapSysex)
+// Filename:      ...sig/maint/code/control/MidiStreamParser/MidiStreamParser.cpp
+// Web Address:   http://sig.sapp.org/src/sig/MidiStreamParser.cpp
+// Syntax:        C++11
+//
+// Description:   Converts a raw MIDI byte stream from one input device
+//                into complete MIDI messages.
+//
+
+#include "MidiStreamParser.h"
+
+#include <stdlib.h>
+
+constexpr signed char MidiStreamParser::lengthTable[256];
+
+
+//////////////////////////////
+//
+// MidiStreamParser::MidiStreamParser --
+//
+
+MidiStreamParser::MidiStreamParser(void) {
+   callback = NULL;
+   callbackData = NULL;
+   sysex.reserve(1024);
+   reset();
+}
+
+
+MidiStreamParser::MidiStreamParser(MIDI_Parse_function aFunction,
+      void* userdata) {
+   callback = aFunction;
+   callbackData = userdata;
+   sysex.reserve(1024);
+   reset();
+}
+
+
+
+//////////////////////////////
+//
+// MidiStreamParser::~MidiStreamParser --
+//
+
+MidiStreamParser::~MidiStreamParser() {
+   // do nothing
+}
+
+
+
+//////////////////////////////
+//
+// MidiStreamParser::getErrorCount -- returns the number of input
+//     bytes which could not be placed into a message, such as data
+//     bytes with no running status, or a stray 0xf7.  Each system
+//     exclusive message which was ended by another status byte
+//     instead of 0xf7 also counts as one error.
+//
+
+int MidiStreamParser::getErrorCount(void) const {
+   return errorCount;
+}
+
+
+
+//////////////////////////////
+//
+// MidiStreamParser::getMessageLength -- returns the number of bytes
+//     in a MIDI message which starts with the given status byte.
+//     Returns -1 for a system exclusive message (variable length)
+//     and 0 if the byte is not a status byte.
+//
+
+int MidiStreamParser::getMessageLength(int statusByte) {
+   return lengthTable[statusByte & 0xff];
+}
+
+
+
+//////////////////////////////
+//
+// MidiStreamParser::inSysex -- returns true if the parser is in the
+//     middle of a system exclusive message.
+//
+
+int MidiStreamParser::inSysex(void) const {
+   return sysexQ;
+}
+
+
+
+//////////////////////////////
+//
+// MidiStreamParser::parse -- process count bytes from the input
+//     stream.  The timestamp is attached to any message whose first
+//     byte is in this block of data.  Returns the number of messages
+//     which were sent to the callback function.
+//
+
+int MidiStreamParser::parse(const uchar* data, int count, int64_t timestamp) {
+   int output = 0;
+   int length;
+   uchar byte;
+
+   for (int i=0; i<count; i++) {
+      byte = data[i];
+
+      if (byte >= 0xf8) {
+         // realtime messages can occur anywhere, even inside of other
+         // messages, and do not affect the running status.
+         deliver(&byte, 1, timestamp);
+         output++;
+         continue;
+      }
+
+      if (byte & 0x80) {
+         if (sysexQ) {
+            // any status byte other than realtime ends a sysex
+            sysexQ = 0;
+            if (byte == 0xf7) {
+               sysex.push_back(byte);
+               deliver(sysex.data(), (int)sysex.size(), messageTime);
+               output++;
+               continue;
+            }
+            // unterminated sysex: pass along what was received, with
+            // the missing 0xf7 added so that a delivered sysex always
+            // ends with one
+            sysex.push_back(0xf7);
+            errorCount++;
+            deliver(sysex.data(), (int)sysex.size(), messageTime);
+            output++;
+         } else if (byte == 0xf7) {
+            // end of sysex with no sysex started
+            errorCount++;
+            continue;
+         }
+
+         if (expectedSize) {
+            // the previous message was not complete, so drop it
+            errorCount += messageSize;
+            expectedSize = 0;
+         }
+
+         messageTime = timestamp;
+         if (byte == 0xf0) {
+            sysexQ = 1;
+            runningStatus = 0;
+            sysex.clear();
+            sysex.push_back(byte);
+            continue;
+         }
+
+         length = lengthTable[byte];
+         // system common messages cancel running status
+         runningStatus = (byte < 0xf0) ? byte : 0;
+         message[0] = byte;
+         messageSize = 1;
+         if (length == 1) {
+            deliver(message, 1, timestamp);
+            output++;
+         } else {
+            expectedSize = length;
+         }
+         continue;
+      }
+
+      // data byte
+      if (sysexQ) {
+         sysex.push_back(byte);
+         continue;
+      }
+      if (expectedSize == 0) {
+         if (runningStatus == 0) {
+            errorCount++;
+            continue;
+         }
+         message[0] = runningStatus;
+         messageSize = 1;
+         expectedSize = lengthTable[runningStatus];
+         messageTime = timestamp;
+      }
+      message[messageSize++] = byte;
+      if (messageSize >= expectedSize) {
+         deliver(message, messageSize, messageTime);
+         output++;
+         expectedSize = 0;
+      }
+   }
+
+   return output;
+}
+
+
+
+//////////////////////////////
+//
+// MidiStreamParser::reset -- forget any partial message and the
+//     running status.  The error count is also cleared.
+//
+
+void MidiStreamParser::reset(void) {
+   message[0] = message[1] = message[2] = 0;
+   messageSize = 0;
+   expectedSize = 0;
+   runningStatus = 0;
+   messageTime = 0;
+   sysexQ = 0;
+   sysex.clear();
+   errorCount = 0;
+}
+
+
+
+//////////////////////////////
+//
+// MidiStreamParser::setCallback -- set the function which receives
+//     complete MIDI messages.  userdata is passed back to the function.
+//
+
+void MidiStreamParser::setCallback(MIDI_Parse_function aFunction,
+      void* userdata) {
+   callback = aFunction;
+   callbackData = userdata;
+}
+
+
+
+//////////////////////////////
+//
+// MidiStreamParser::swapSysex -- exchange the storage of the system
+//     exclusive message being assembled with the given vector.  When
+//     called from the callback function for a sysex message, storage
+//     receives the complete message without any bytes being copied,
+//     and the parser continues with the old memory of storage.
+//
+
+void MidiStreamParser::swapSysex(std::vector<uchar>& storage) {
+   sysex.swap(storage);
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+//////////////////////////////
+//
+// MidiStreamParser::deliver -- send a complete message to the callback.
+//
+
+void MidiStreamParser::deliver(const uchar* data, int size, 
+      int64_t timestamp) {
+   if (callback != NULL) {
+      callback(data, size, timestamp, callbackData);
+   }
+}
@@ -0,0 +1,407 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 18:12:40 PDT 2026
+// Last Modified: Sat Oct 17 18:12:40 PDT 2026
+// Filename:      ...sig/maint/code/control/MidiTrace/MidiTrace.cpp
+// Web Address:   http://sig.sapp.org/src/sig/MidiTrace.cpp
+// Syntax:        C++11
+//
+// Description:   Asynchronous trace of MIDI input and output.
+//
+
+#include "MidiTrace.h"
+#include "SigTimer.h"
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// number of records in the ring buffer (must be a power of two)
+#define TRACE_RING_SIZE (4096)
+
+// microseconds that the trace thread sleeps when the ring is empty
+#define TRACE_IDLE_TIME (2000)
+
+// The ring buffer is a bounded multiple-producer queue: each cell has a
+// sequence number which tells the producers when the cell is free and
+// the consumer when the record in it is complete, so producers never
+// wait for each other or for the trace thread.
+struct TraceCell {
+   std::atomic<uint64_t> sequence;
+   MidiTraceRecord       record;
+};
+
+static TraceCell             traceRing[TRACE_RING_SIZE];
+static std::atomic<uint64_t> traceTail(0);      // next cell for producers
+static std::atomic<uint64_t> traceHead(0);      // next cell for the thread
+static int                   traceReady = 0;    // ring has been set up
+static std::atomic<int>      traceRunning(0);   // true if thread started
+static std::atomic<int64_t>  traceLost(0);      // records not stored
+static std::atomic<int64_t>  traceReported(0);  // lost records printed
+static std::atomic<int>      traceSampling(1);  // keep one record in N
+static std::atomic<uint64_t> traceSampleCount(0);
+static std::atomic<int>      traceRateLimit(0); // records/second, 0 = any
+static std::atomic<int64_t>  traceWindowStart(0);
+static std::atomic<int>      traceWindowCount(0);
+
+// the output of the trace thread, which is not touched by the producers
+static std::mutex            traceOutputLock;
+static ostream*              traceStream = &cout;
+static ofstream              traceFile;
+static pthread_t             traceThread;
+static std::mutex            traceStartLock;
+
+// stop the trace thread and print the remaining records at exit
+struct TraceShutdown {
+   ~TraceShutdown() { MidiTrace::stop(); }
+};
+static TraceShutdown traceShutdown;
+
+
+
+//////////////////////////////
+//
+// MidiTrace::flush -- wait until all of the records in the ring have
+//     been written.
+//
+
+void MidiTrace::flush(void) {
+   if (!traceRunning.load()) {
+      return;
+   }
+   while (traceHead.load(std::memory_order_acquire) != 
+         traceTail.load(std::memory_order_acquire)) {
+      usleep(TRACE_IDLE_TIME);
+   }
+   std::lock_guard<std::mutex> lock(traceOutputLock);
+   if (traceFile.is_open()) {
+      traceFile.flush();
+   } else {
+      traceStream->flush();
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiTrace::getLostCount -- returns the number of records which were
+//     lost because the ring buffer was full.  Records left out by
+//     sampling or by the rate limit are not counted.
+//
+
+int64_t MidiTrace::getLostCount(void) {
+   return traceLost.load(std::memory_order_relaxed);
+}
+
+
+
+//////////////////////////////
+//
+// MidiTrace::record -- add a message to the trace.  This function is
+//     safe to call from any thread, and does not block, allocate or
+//     do I/O.  If the timestamp is 0, the current time is used.
+//     default values: flags = 0, timestamp = 0
+//
+
+void MidiTrace::record(int direction, int port, const uchar* data,
+      int size, int flags, int64_t timestamp) {
+   if (!traceRunning.load(std::memory_order_relaxed)) {
+      return;
+   }
+
+   int sampling = traceSampling.load(std::memory_order_relaxed);
+   if (sampling > 1 && traceSampleCount.fetch_add(1,
+         std::memory_order_relaxed) % sampling != 0) {
+      return;
+   }
+
+   if (timestamp == 0) {
+      timestamp = SigTimer::getMonotonicTime();
+   }
+
+   int limit = traceRateLimit.load(std::memory_order_relaxed);
+   if (limit > 0) {
+      int64_t start = traceWindowStart.load(std::memory_order_relaxed);
+      if (timestamp - start >= 1000000000) {
+         // start a new one-second window (only one thread will win)
+         if (traceWindowStart.compare_exchange_strong(start, timestamp,
+               std::memory_order_relaxed)) {
+            traceWindowCount.store(0, std::memory_order_relaxed);
+         }
+      }
+      if (traceWindowCount.fetch_add(1, std::memory_order_relaxed) >= limit) {
+         return;
+      }
+   }
+
+   // claim a cell in the ring
+   uint64_t position = traceTail.load(std::memory_order_relaxed);
+   TraceCell* cell;
+   while (1) {
+      cell = &traceRing[position & (TRACE_RING_SIZE - 1)];
+      uint64_t sequence = cell->sequence.load(std::memory_order_acquire);
+      int64_t difference = (int64_t)sequence - (int64_t)position;
+      if (difference == 0) {
+         if (traceTail.compare_exchange_weak(position, position + 1,
+               std::memory_order_relaxed)) {
+            break;
+         }
+      } else if (difference < 0) {
+         // the ring is full
+         traceLost.fetch_add(1, std::memory_order_relaxed);
+         return;
+      } else {
+         position = traceTail.load(std::memory_order_relaxed);
+      }
+   }
+
+   MidiTraceRecord& record = cell->record;
+   record.time      = timestamp;
+   record.port      = (int16_t)port;
+   record.direction = (uint8_t)direction;
+   record.flags     = (uint8_t)flags;
+   record.size      = size;
+   int count = size < MIDI_TRACE_BYTES ? size : MIDI_TRACE_BYTES;
+   if (count > 0) {
+      memcpy(record.data, data, count);
+   }
+   cell->sequence.store(position + 1, std::memory_order_release);
+}
+
+
+
+//////////////////////////////
+//
+// MidiTrace::setBinaryFile -- write the raw trace records to the given
+//     file instead of printing them.  A NULL or empty filename goes
+//     back to printing.  Returns 0 if the file could not be opened.
+//
+
+int MidiTrace::setBinaryFile(const char* filename) {
+   std::lock_guard<std::mutex> lock(traceOutputLock);
+   if (traceFile.is_open()) {
+      traceFile.close();
+   }
+   if (filename == NULL || filename[0] == '\0') {
+      return 1;
+   }
+   traceFile.open(filename, ios::out | ios::binary | ios::trunc);
+   return traceFile.is_open() ? 1 : 0;
+}
+
+
+
+//////////////////////////////
+//
+// MidiTrace::setRateLimit -- keep at most the given number of records
+//     each second.  0 means no limit.
+//
+
+void MidiTrace::setRateLimit(int recordsPerSecond) {
+   if (recordsPerSecond < 0) {
+      recordsPerSecond = 0;
+   }
+   traceRateLimit.store(recordsPerSecond);
+}
+
+
+
+//////////////////////////////
+//
+// MidiTrace::setSampling -- keep only one of every N records.  1 keeps
+//     all of them.
+//
+
+void MidiTrace::setSampling(int everyN) {
+   if (everyN < 1) {
+      everyN = 1;
+   }
+   traceSampling.store(everyN);
+}
+
+
+
+//////////////////////////////
+//
+// MidiTrace::setStream -- print the trace on the given stream.  The
+//     default stream is cout.
+//
+
+void MidiTrace::setStream(ostream& out) {
+   std::lock_guard<std::mutex> lock(traceOutputLock);
+   traceStream = &out;
+}
+
+
+
+//////////////////////////////
+//
+// MidiTrace::start -- start the trace thread.  Called when trace is
+//     turned on for a MIDI port.  Nothing is recorded before this.
+//
+
+void MidiTrace::start(void) {
+   std::lock_guard<std::mutex> lock(traceStartLock);
+   if (traceRunning.load()) {
+      return;
+   }
+   if (!traceReady) {
+      for (int i=0; i<TRACE_RING_SIZE; i++) {
+         traceRing[i].sequence.store(i, std::memory_order_relaxed);
+      }
+      traceReady = 1;
+   }
+   traceRunning.store(1);
+   int flag = pthread_create(&traceThread, NULL, writeMidiTracePrivate, NULL);
+   if (flag != 0) {
+      cout << "Unable to create MIDI trace thread." << endl;
+      exit(1);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// MidiTrace::stop -- stop the trace thread after writing the records
+//     which are waiting.  Records added after this are ignored.
+//
+
+void MidiTrace::stop(void) {
+   std::lock_guard<std::mutex> lock(traceStartLock);
+   if (!traceRunning.load()) {
+      return;
+   }
+   traceRunning.store(0);
+   pthread_join(traceThread, NULL);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// private functions
+//
+
+
+//////////////////////////////
+//
+// MidiTrace::drain -- write all of the complete records in the ring.
+//     Only called by the trace thread.  Returns the number of records
+//     written.
+//
+
+int MidiTrace::drain(void) {
+   std::lock_guard<std::mutex> lock(traceOutputLock);
+   int count = 0;
+   uint64_t head = traceHead.load(std::memory_order_relaxed);
+   while (1) {
+      TraceCell& cell = traceRing[head & (TRACE_RING_SIZE - 1)];
+      uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+      if (sequence != head + 1) {
+         break;
+      }
+      if (traceFile.is_open()) {
+         traceFile.write((const char*)&cell.record, sizeof(MidiTraceRecord));
+      } else {
+         print(cell.record);
+      }
+      cell.sequence.store(head + TRACE_RING_SIZE, std::memory_order_release);
+      head++;
+      traceHead.store(head, std::memory_order_release);
+      count++;
+   }
+
+   int64_t lost = traceLost.load(std::memory_order_relaxed);
+   if (lost != traceReported.load(std::memory_order_relaxed) &&
+         !traceFile.is_open()) {
+      *traceStream << "[" << dec
+                   << lost - traceReported.load(std::memory_order_relaxed)
+                   << " trace records lost]";
+      traceReported.store(lost, std::memory_order_relaxed);
+      count++;
+   }
+
+   if (count > 0) {
+      if (traceFile.is_open()) {
+         traceFile.flush();
+      } else {
+         traceStream->flush();
+      }
+   }
+   return count;
+}
+
+
+
+//////////////////////////////
+//
+// MidiTrace::print -- print a trace record as text.  Output messages
+//     are printed in parentheses and input messages in square brackets.
+//     The separator after the command byte is 'X' for output which
+//     could not be written, 'P' for input which arrived while the port
+//     was paused, and ':' otherwise.
+//
+
+void MidiTrace::print(const MidiTraceRecord& record) {
+   ostream& out = *traceStream;
+   int input = record.direction == MIDI_TRACE_INPUT;
+   char open  = input ? '[' : '(';
+   char close = input ? ']' : ')';
+
+   if (record.flags & MIDI_TRACE_DROPPED) {
+      out << "[sysex overflow]";
+      return;
+   }
+   if (record.size > 3 || (record.size > 0 && record.data[0] == 0xf0)) {
+      if (input) {
+         out << "[sysex:" << dec << record.size << ']';
+      } else if (record.flags & MIDI_TRACE_FAILED) {
+         out << "(XarrayX)";
+      } else {
+         out << "(array)";
+      }
+      return;
+   }
+
+   char separator = ':';
+   if (record.flags & MIDI_TRACE_FAILED) {
+      separator = 'X';
+   } else if (record.flags & MIDI_TRACE_PAUSED) {
+      separator = 'P';
+   }
+   out << open << hex << (int)record.data[0] << dec;
+   if (record.size > 1) {
+      out << separator << (int)record.data[1];
+   }
+   if (record.size > 2) {
+      out << ',' << (int)record.data[2];
+   }
+   out << close;
+}
+
+
+
+//////////////////////////////
+//
+// writeMidiTracePrivate -- the trace thread.  Writes the records in the
+//     ring, and sleeps a little when there are none.
+//
+
+void *writeMidiTracePrivate(void* x) {
+   while (traceRunning.load()) {
+      if (MidiTrace::drain() == 0) {
+         usleep(TRACE_IDLE_TIME);
+      }
+   }
+   MidiTrace::drain();
+   return NULL;
+}
+
+
+
@@ -3,6 +3,7 @@
 // Creation Date: Fri Sep  5 22:00:43 GMT-0800 1997
 // Last Modified: Sat Jan 17 11:19:25 GMT-0800 1998
 // Last Modified: Tue Nov 10 15:08:01 PST 1998
+// Last Modified: Sat Oct 17 19:27:03 PDT 2026 (always send the note off)
 // Filename:      .../control/Event/TwoStageEvent/NoteEvent/NoteEvent.cpp
 // Web Address:   http://sig.sapp.org/src/sig/NoteEvent.cpp
 // Syntax:        C++ 
@@ -156,7 +157,10 @@ int NoteEvent::getVelocity(void) const {
 
 //////////////////////////////
 //
-// NoteEvent::off --
+// NoteEvent::off -- turn off the note if it is still sounding.  The
+//    note off is always sent, even if silence() has already turned the
+//    note off, since the note-on may still be waiting to be sent by
+//    the sender thread of the port.
 //
 
 void NoteEvent::off(EventBuffer& midiOutput) {
@@ -165,7 +169,8 @@ void NoteEvent::off(EventBuffer& midiOutput) {
          setStatus(EVENT_STATUS_OFF);
          break;
       case EVENT_STATUS_ON:
-         midiOutput.MidiOutput::off(getChannel(), getKeyno(), getOffVelocity());
+         midiOutput.MidiOutput::off(getChannel(), getKeyno(), 
+               getOffVelocity());
          setStatus(EVENT_STATUS_OFF);
          break;
       case EVENT_STATUS_OFF:
@@ -3,6 +3,7 @@
 // Creation Date: Fri Sep  5 22:00:43 GMT-0800 1997
 // Last Modified: Sat Dec  6 22:24:47 GMT-0800 1997
 // Last Modified: Mon Nov  9 13:28:13 PST 1998
+// Last Modified: Sat Oct 17 23:58:12 PDT 2026 (no virtual calls on stored events)
 // Filename:      ...sig/src/control/Event/OneStageEvent/OneStageEvent.cpp
 // Web Address:   http://sig.sapp.org/src/sig/OneStageEvent.cpp
 // Syntax:        C++ 
@@ -43,7 +44,7 @@ OneStageEvent::~OneStageEvent() {
 void OneStageEvent::action(EventBuffer& midiOutput) {
    switch (getType() >> 3) {
       case EVENT_ONESTAGE_MIDI:
-         ((MidiStageEvent*)this)->action(midiOutput);
+         ((MidiStageEvent*)this)->MidiStageEvent::action(midiOutput);
          break;
       default:
          break;
@@ -3,6 +3,9 @@
 // Creation Date: Thu May 11 21:10:02 PDT 2000
 // Last Modified: Sat Oct 13 14:51:43 PDT 2001 (updated for ALSA 0.9 interface)
 // Last Modified: Tue May 26 12:38:18 EDT 2009 (updated for ALSA 1.0 interface)
+// Last Modified: Sat Oct 17 10:12:40 PDT 2026 (non-blocking input handles)
+// Last Modified: Sat Oct 17 12:48:09 PDT 2026 (driver input timestamps)
+// Last Modified: Sat Oct 17 16:21:48 PDT 2026 (static write functions)
 // Filename:      ...sig/maint/code/control/Sequencer_alsa.cpp
 // Web Address:   http://sig.sapp.org/src/sig/Sequencer_alsa.cpp
 // Syntax:        C++ 
@@ -51,6 +54,7 @@ int    Sequencer_alsa::indevcount      = 0;
 int    Sequencer_alsa::outdevcount     = 0;
 
 vector<snd_rawmidi_t*> Sequencer_alsa::rawmidi_in;
+vector<int>            Sequencer_alsa::rawmidi_in_tstamp;
 vector<snd_rawmidi_t*> Sequencer_alsa::rawmidi_out;
 vector<ALSA_ENTRY>     Sequencer_alsa::rawmidi_info;
 vector<int>            Sequencer_alsa::midiin_index;
@@ -330,10 +334,13 @@ int Sequencer_alsa::openInput(int index) {
       sprintf(devname, "hw:%d,%d", card, device);
    }
 
-   int mode = 0;
+   // Input is non-blocking: the input thread waits with poll() and then
+   // reads everything which has arrived in a single call.
+   int mode = SND_RAWMIDI_NONBLOCK;
    // status = snd_rawmidi_open(&rawmidi_in[index], NULL, devname, mode);
    status = snd_rawmidi_open(&rawmidi_in[index], NULL, "virtual", mode);
    if (status == 0) {
+      rawmidi_in_tstamp[index] = enableInputTimestamps(rawmidi_in[index]);
       return 1;
    } else { 
       return 0;
@@ -415,7 +422,6 @@ int Sequencer_alsa::write(int aDevice, int aByte) {
 
 
 int Sequencer_alsa::write(int aDevice, uchar* bytes, int count) {
-cout << "> AAA " << hex << (int)bytes[0] << dec << " " << (int)bytes[1] << " " << (int)bytes[2] << endl;
    if (is_open_out(aDevice)) {
       int status = snd_rawmidi_write(rawmidi_out[aDevice], bytes, count);
       return status == count ? 1 : 0;
@@ -503,6 +509,7 @@ void Sequencer_alsa::buildInfoDatabase(void) {
    for (i=0; i<(int)rawmidi_in.size(); i++) {
       rawmidi_in[i] = NULL;
    }
+   rawmidi_in_tstamp.assign(indevcount, 0);
    rawmidi_out.resize(outdevcount);
    for (i=0; i<(int)rawmidi_out.size(); i++) {
       rawmidi_out[i] = NULL;
@@ -579,6 +586,42 @@ int Sequencer_alsa::getOutCardValue(int aDevice) const {
 
 
 
+//////////////////////////////
+//
+// Sequencer_alsa::enableInputTimestamps -- ask the driver to stamp
+//   incoming bytes with the CLOCK_MONOTONIC time at which they arrived,
+//   so that snd_rawmidi_tread() can be used to read them.  Returns 1 
+//   if timestamped reads were enabled, or 0 if the driver or the ALSA
+//   library (older than 1.2.6) does not support them.
+//
+
+int Sequencer_alsa::enableInputTimestamps(snd_rawmidi_t* handle) {
+#if SND_LIB_VERSION >= 0x010206
+   snd_rawmidi_params_t* params = NULL;
+   if (snd_rawmidi_params_malloc(&params) < 0) {
+      return 0;
+   }
+   int status = snd_rawmidi_params_current(handle, params);
+   if (status >= 0) {
+      status = snd_rawmidi_params_set_read_mode(handle, params, 
+            SND_RAWMIDI_READ_TSTAMP);
+   }
+   if (status >= 0) {
+      status = snd_rawmidi_params_set_clock_type(handle, params, 
+            SND_RAWMIDI_CLOCK_MONOTONIC);
+   }
+   if (status >= 0) {
+      status = snd_rawmidi_params(handle, params);
+   }
+   snd_rawmidi_params_free(params);
+   return status >= 0 ? 1 : 0;
+#else
+   return 0;
+#endif
+}
+
+
+
 //////////////////////////////
 //
 // Sequencer_alsa::removeInfoDatabase --
@@ -595,6 +638,7 @@ void Sequencer_alsa::removeInfoDatabase(void) {
    }
 
    rawmidi_in.resize(0);
+   rawmidi_in_tstamp.resize(0);
    rawmidi_out.resize(0);
    rawmidi_info.resize(0);
    midiin_index.resize(0);
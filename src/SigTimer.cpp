@@ -9,6 +9,7 @@
 // Last Modified: Sun Nov 20 01:19:24 PST 2005 new cpu speed measurement)
 // Last Modified: Tue Jun  9 14:17:28 PDT 2009 added Apple OSX capability)
 // Last Modified: Sun May 19 13:58:03 PDT 2024 use clock_gettime() for portable high-resolution timer.
+// Last Modified: Sat Oct 17 12:48:09 PDT 2026 added getMonotonicTime()
 // Filename:      .../sig/code/control/SigTimer/SigTimer.cpp
 // Web Address:   http://improv.sapp.org/src/SigTimer.cpp
 // Syntax:        C++
@@ -143,6 +144,21 @@ int64bits SigTimer::getCpuSpeed(void) {
 
 
 
+//////////////////////////////
+//
+// SigTimer::getMonotonicTime -- returns the CLOCK_MONOTONIC time in
+//   nanoseconds.  Used for high-resolution MIDI input timestamps.
+//   (static function)
+//
+
+int64_t SigTimer::getMonotonicTime(void) {
+	TimeSpec tspec;
+	clock_gettime(CLOCK_MONOTONIC, &tspec);
+	return (int64_t)tspec.tv_sec * 1000000000 + tspec.tv_nsec;
+}
+
+
+
 //////////////////////////////
 //
 // SigTimer::getPeriod -- returns the timing period of the timer,
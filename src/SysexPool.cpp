@@ -0,0 +1,381 @@
+//
+// Programmer:    Craig Stuart Sapp <craig@ccrma.stanford.edu>
+// Creation Date: Sat Oct 17 14:22:15 PDT 2026
+// Last Modified: Sat Oct 17 14:22:15 PDT 2026
+// Filename:      ...sig/maint/code/control/SysexPool/SysexPool.cpp
+// Web Address:   http://sig.sapp.org/src/sig/SysexPool.cpp
+// Syntax:        C++11
+//
+// Description:   Reference-counted storage for incoming system exclusive
+//                messages.
+//
+
+#include "SysexPool.h"
+
+#include <string.h>
+
+// initial storage size of each slot
+#define SYSEX_SLOT_RESERVE (32)
+
+
+//////////////////////////////
+//
+// SysexPool::SysexPool --
+//     default value: aSlotCount = 128
+//
+
+SysexPool::SysexPool(int aSlotCount) {
+   if (aSlotCount < 1) {
+      aSlotCount = 1;
+   }
+   slotCount = aSlotCount;
+   slots = new Slot[slotCount];
+   for (int i=0; i<slotCount; i++) {
+      slots[i].data.reserve(SYSEX_SLOT_RESERVE);
+      slots[i].references.store(0);
+   }
+   nextSlot.store(0);
+   overflowCount.store(0);
+}
+
+
+
+//////////////////////////////
+//
+// SysexPool::~SysexPool --
+//
+
+SysexPool::~SysexPool() {
+   if (slots != NULL) {
+      delete [] slots;
+      slots = NULL;
+   }
+}
+
+
+
+//////////////////////////////
+//
+// SysexPool::addReference -- the caller must already hold a reference
+//     to the slot (such as through a SysexView).
+//
+
+void SysexPool::addReference(int slot) {
+   if (isValid(slot)) {
+      slots[slot].references.fetch_add(1, std::memory_order_relaxed);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// SysexPool::clear -- remove the data from a slot and shrink its
+//     storage, if the slot is not in use.
+//
+
+void SysexPool::clear(int slot) {
+   if (!isValid(slot)) {
+      return;
+   }
+   int expected = 0;
+   // hold the slot while clearing so that a message is not stored in it
+   if (!slots[slot].references.compare_exchange_strong(expected, 1,
+         std::memory_order_acquire)) {
+      return;
+   }
+   std::vector<uchar> empty;
+   empty.reserve(SYSEX_SLOT_RESERVE);
+   slots[slot].data.swap(empty);
+   slots[slot].references.store(0, std::memory_order_release);
+}
+
+
+
+//////////////////////////////
+//
+// SysexPool::getData -- returns the bytes of the message in the slot,
+//     starting with 0xf0.  Returns NULL for an invalid slot.
+//
+
+const uchar* SysexPool::getData(int slot) const {
+   if (slot < 0 || slot >= slotCount) {
+      return NULL;
+   }
+   return slots[slot].data.data();
+}
+
+
+
+//////////////////////////////
+//
+// SysexPool::getOverflowCount -- returns the number of messages which
+//     could not be stored because every slot held an unread message.
+//
+
+int SysexPool::getOverflowCount(void) const {
+   return overflowCount.load(std::memory_order_relaxed);
+}
+
+
+
+//////////////////////////////
+//
+// SysexPool::getSize -- returns the number of bytes in the message in
+//     the slot, including the starting 0xf0 and ending 0xf7.
+//
+
+int SysexPool::getSize(int slot) const {
+   if (slot < 0 || slot >= slotCount) {
+      return 0;
+   }
+   return (int)slots[slot].data.size();
+}
+
+
+
+//////////////////////////////
+//
+// SysexPool::getSlotCount --
+//
+
+int SysexPool::getSlotCount(void) const {
+   return slotCount;
+}
+
+
+
+//////////////////////////////
+//
+// SysexPool::isValid -- returns true if the slot number is in range.
+//
+
+int SysexPool::isValid(int slot) const {
+   return slot >= 0 && slot < slotCount;
+}
+
+
+
+//////////////////////////////
+//
+// SysexPool::release -- give up a reference to a slot.  When the last
+//     reference is released, the slot can be used for a new message.
+//     Releasing a slot which is not in use is ignored.
+//
+
+void SysexPool::release(int slot) {
+   if (!isValid(slot)) {
+      return;
+   }
+   int count = slots[slot].references.load(std::memory_order_relaxed);
+   while (count > 0) {
+      if (slots[slot].references.compare_exchange_weak(count, count - 1,
+            std::memory_order_release, std::memory_order_relaxed)) {
+         break;
+      }
+   }
+}
+
+
+
+//////////////////////////////
+//
+// SysexPool::store -- place a message into an unused slot, and return
+//     the slot number.  The caller receives one reference to the slot,
+//     which must be released when the message is no longer needed.
+//     Returns -1 (and counts an overflow) if all slots are in use.
+//     The vector version exchanges storage with the message: afterwards
+//     the message vector is empty, but keeps the capacity of the slot
+//     it was swapped with, so it can be used to assemble the next
+//     message without allocating memory.
+//
+
+int SysexPool::store(std::vector<uchar>& message) {
+   int slot = acquire();
+   if (slot < 0) {
+      return -1;
+   }
+   slots[slot].data.swap(message);
+   message.clear();
+   return slot;
+}
+
+
+int SysexPool::store(const uchar* data, int size) {
+   int slot = acquire();
+   if (slot < 0) {
+      return -1;
+   }
+   slots[slot].data.resize(size);
+   if (size > 0) {
+      memcpy(slots[slot].data.data(), data, size);
+   }
+   return slot;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// protected functions
+//
+
+//////////////////////////////
+//
+// SysexPool::acquire -- find an unused slot and take a reference to it.
+//     Slots are used in order, so the oldest message is replaced first.
+//
+
+int SysexPool::acquire(void) {
+   int start = nextSlot.load(std::memory_order_relaxed);
+   int slot;
+   int expected;
+   for (int i=0; i<slotCount; i++) {
+      slot = (start + i) % slotCount;
+      expected = 0;
+      if (slots[slot].references.compare_exchange_strong(expected, 1,
+            std::memory_order_acquire)) {
+         nextSlot.store((slot + 1) % slotCount, std::memory_order_relaxed);
+         return slot;
+      }
+   }
+   overflowCount.fetch_add(1, std::memory_order_relaxed);
+   return -1;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////
+//
+// SysexView class functions
+//
+
+//////////////////////////////
+//
+// SysexView::SysexView -- the two-argument constructor adds a 
+//     reference to a slot which the caller already holds.
+//
+
+SysexView::SysexView(void) {
+   pool = NULL;
+   slot = -1;
+}
+
+
+SysexView::SysexView(SysexPool* aPool, int aSlot) {
+   pool = NULL;
+   slot = -1;
+   if (aPool != NULL && aPool->isValid(aSlot)) {
+      pool = aPool;
+      slot = aSlot;
+      pool->addReference(slot);
+   }
+}
+
+
+SysexView::SysexView(const SysexView& aView) {
+   pool = aView.pool;
+   slot = aView.slot;
+   if (pool != NULL) {
+      pool->addReference(slot);
+   }
+}
+
+
+
+//////////////////////////////
+//
+// SysexView::~SysexView --
+//
+
+SysexView::~SysexView() {
+   reset();
+}
+
+
+
+//////////////////////////////
+//
+// SysexView::data -- returns the message bytes, or NULL if the view
+//     is empty.
+//
+
+const uchar* SysexView::data(void) const {
+   if (pool == NULL) {
+      return NULL;
+   }
+   return pool->getData(slot);
+}
+
+
+
+//////////////////////////////
+//
+// SysexView::isValid -- returns true if the view refers to a message.
+//
+
+int SysexView::isValid(void) const {
+   return pool != NULL;
+}
+
+
+
+//////////////////////////////
+//
+// SysexView::operator= --
+//
+
+SysexView& SysexView::operator=(const SysexView& aView) {
+   if (this == &aView) {
+      return *this;
+   }
+   if (aView.pool != NULL) {
+      aView.pool->addReference(aView.slot);
+   }
+   reset();
+   pool = aView.pool;
+   slot = aView.slot;
+   return *this;
+}
+
+
+
+//////////////////////////////
+//
+// SysexView::operator[] -- returns a byte from the message.
+//
+
+uchar SysexView::operator[](int index) const {
+   if (index < 0 || index >= size()) {
+      return 0;
+   }
+   return data()[index];
+}
+
+
+
+//////////////////////////////
+//
+// SysexView::reset -- release the message.
+//
+
+void SysexView::reset(void) {
+   if (pool != NULL) {
+      pool->release(slot);
+   }
+   pool = NULL;
+   slot = -1;
+}
+
+
+
+//////////////////////////////
+//
+// SysexView::size -- returns the number of bytes in the message.
+//
+
+int SysexView::size(void) const {
+   if (pool == NULL) {
+      return 0;
+   }
+   return pool->getSize(slot);
+}
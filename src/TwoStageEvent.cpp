@@ -3,6 +3,7 @@
 // Creation Date: Fri Sep  5 22:00:43 GMT-0800 1997
 // Last Modified: Fri Jan 16 21:08:04 GMT-0800 1998
 // Last Modified: Tue Nov 10 14:29:59 PST 1998
+// Last Modified: Sat Oct 17 23:58:12 PDT 2026 (no virtual calls on stored events)
 // Filename:      .../sig/maint//code/control/Event/TwoStageEvent.cpp
 // Web Address:   http://sig.sapp.org/src/sig/TwoStageEvent.cpp
 // Syntax:        C++ 
@@ -107,9 +108,9 @@ int TwoStageEvent::getOnTime(void) const {
 //
 
 void TwoStageEvent::off(EventBuffer& midiOutput) {
-   switch (getType() >> 3) {
+   switch ((getType() >> 3) << 3) {
       case EVENT_TWOSTAGE_NOTE:
-         ((NoteEvent*)(this))->off(midiOutput);
+         ((NoteEvent*)(this))->NoteEvent::off(midiOutput);
          break;
       default:
           setStatus(EVENT_STATUS_OFF);